@@ -0,0 +1,34 @@
+// Replacement global allocation functions of the fractac executable, which feed --mem-report. They are not
+// part of the compiler library, so programs embedding it keep their own allocator.
+#include "Utils/AllocationCounter.hpp"
+
+#if defined(__GLIBC__)
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Unsized delete does not pass a size, so both sides measure the block malloc actually handed out. Blocks are
+// only measured while tracking is enabled.
+static void* CountedAllocate(std::size_t size) {
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    if (pl::AllocationCounter::IsEnabled()) pl::AllocationCounter::RecordAllocation(malloc_usable_size(ptr));
+    return ptr;
+}
+
+static void CountedFree(void* ptr) noexcept {
+    if (!ptr) return;
+    if (pl::AllocationCounter::IsEnabled()) pl::AllocationCounter::RecordFree(malloc_usable_size(ptr));
+    std::free(ptr);
+}
+
+// The remaining forms of the standard library forward to these.
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { CountedFree(ptr); }
+
+[[maybe_unused]] static const bool hooksInstalled = (pl::AllocationCounter::MarkAvailable(), true);
+#endif
@@ -0,0 +1,71 @@
+#include "BuiltinTypes.hpp"
+#include <Utils/Utils.hpp>
+#include <string>
+#include <unordered_map>
+
+using namespace pl;
+
+static const std::unordered_map<std::string, IntegerTypeInfo> IntegerTypes = {
+    {"i8", {8, true}},
+    {"i16", {16, true}},
+    {"i32", {32, true}},
+    {"i64", {64, true}},
+    {"u8", {8, false}},
+    {"u16", {16, false}},
+    {"u32", {32, false}},
+    {"u64", {64, false}},
+};
+
+static std::string_view NameOf(const TypeSP& type) {
+    if (auto p = InstanceOf<NamedType>(type)) return p->name.identName;
+    return {};
+}
+
+std::optional<IntegerTypeInfo> pl::GetIntegerTypeInfo(std::string_view name) {
+    auto it = IntegerTypes.find(std::string(name));
+    if (it == IntegerTypes.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<IntegerTypeInfo> pl::GetIntegerTypeInfo(const TypeSP& type) {
+    if (auto p = InstanceOf<NamedType>(type)) return GetIntegerTypeInfo(p->name.identName);
+    return std::nullopt;
+}
+
+bool pl::IsIntegerType(const TypeSP& type) {
+    return GetIntegerTypeInfo(type).has_value();
+}
+
+bool pl::IsFloatType(const TypeSP& type) {
+    auto name = NameOf(type);
+    return name == "f32" || name == "f64";
+}
+
+bool pl::IsNumericType(const TypeSP& type) {
+    return IsIntegerType(type) || IsFloatType(type);
+}
+
+bool pl::IsVoidType(const TypeSP& type) {
+    return NameOf(type) == "void";
+}
+
+bool pl::IsBuiltinType(const TypeSP& type) {
+    return IsNumericType(type) || IsVoidType(type);
+}
+
+bool pl::IsSameType(const TypeSP& a, const TypeSP& b) {
+    if (!a || !b) return false;
+    return NameOf(a) == NameOf(b);
+}
+
+std::string pl::TypeName(const TypeSP& type) {
+    if (!type) return "<unknown>";
+    return std::string(NameOf(type));
+}
+
+TypeSP pl::MakeBuiltinType(std::string_view name) {
+    Token tok;
+    tok.type = TokenType::Identifier;
+    tok.identName = name;
+    return MakeSP<NamedType>(tok);
+}
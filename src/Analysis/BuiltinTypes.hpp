@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Parsing/Type.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace pl {
+    struct IntegerTypeInfo {
+        int bits;
+        bool isSigned;
+    };
+
+    std::optional<IntegerTypeInfo> GetIntegerTypeInfo(std::string_view name);
+    std::optional<IntegerTypeInfo> GetIntegerTypeInfo(const TypeSP& type);
+
+    bool IsIntegerType(const TypeSP& type);
+    bool IsFloatType(const TypeSP& type);
+    bool IsNumericType(const TypeSP& type);
+    bool IsVoidType(const TypeSP& type);
+    bool IsBuiltinType(const TypeSP& type);
+
+    bool IsSameType(const TypeSP& a, const TypeSP& b);
+    std::string TypeName(const TypeSP& type);
+
+    TypeSP MakeBuiltinType(std::string_view name);
+}
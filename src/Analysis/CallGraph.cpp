@@ -0,0 +1,141 @@
+#include "CallGraph.hpp"
+#include <Utils/Utils.hpp>
+#include <algorithm>
+#include <limits>
+
+using namespace pl;
+
+CallGraph::CallGraph(const std::vector<FileSourceNodeSP>& files) {
+    for (const auto& file : files) {
+        for (const auto& stmt : file->statements) {
+            if (auto func = InstanceOf<FuncDeclStmt>(stmt)) {
+                indices.emplace(func->name.identName, nodes.size());
+                nodes.push_back({func, {}, {}});
+            }
+        }
+    }
+
+    // Callees are resolved in a second pass, as calls may refer to functions declared later.
+    for (auto& node : nodes) {
+        CollectCalls(node.decl->body, node.calls);
+        for (const auto& site : node.calls) node.callees.push_back(site.callee);
+        std::ranges::sort(node.callees);
+        node.callees.erase(std::ranges::unique(node.callees).begin(), node.callees.end());
+    }
+}
+
+std::optional<size_t> CallGraph::Find(std::string_view name) const {
+    auto it = indices.find(std::string(name));
+    if (it == indices.end()) return std::nullopt;
+    return it->second;
+}
+
+std::vector<std::vector<size_t>> CallGraph::ComputeSCCs() const {
+    // Tarjan's algorithm, iterative so that long call chains in generated code cannot overflow the stack.
+    constexpr size_t Unvisited = std::numeric_limits<size_t>::max();
+
+    std::vector<size_t> index(nodes.size(), Unvisited);
+    std::vector<size_t> lowLink(nodes.size(), 0);
+    std::vector<bool> onStack(nodes.size(), false);
+    std::vector<size_t> stack;
+    std::vector<std::vector<size_t>> sccs;
+    size_t nextIndex = 0;
+
+    struct Visit {
+        size_t node;
+        size_t nextCallee;
+    };
+    std::vector<Visit> work;
+
+    for (size_t root = 0; root < nodes.size(); root++) {
+        if (index[root] != Unvisited) continue;
+        work.push_back({root, 0});
+
+        while (!work.empty()) {
+            auto& visit = work.back();
+            const auto n = visit.node;
+
+            if (visit.nextCallee == 0 && index[n] == Unvisited) {
+                index[n] = lowLink[n] = nextIndex++;
+                stack.push_back(n);
+                onStack[n] = true;
+            }
+
+            const auto& callees = nodes[n].callees;
+            if (visit.nextCallee < callees.size()) {
+                const auto callee = callees[visit.nextCallee++];
+                if (index[callee] == Unvisited) work.push_back({callee, 0});
+                else if (onStack[callee]) lowLink[n] = std::min(lowLink[n], index[callee]);
+                continue;
+            }
+
+            if (lowLink[n] == index[n]) {
+                auto& scc = sccs.emplace_back();
+                size_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    scc.push_back(member);
+                } while (member != n);
+            }
+
+            work.pop_back();
+            if (!work.empty()) {
+                const auto parent = work.back().node;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[n]);
+            }
+        }
+    }
+
+    return sccs;
+}
+
+bool CallGraph::IsRecursive(const std::vector<size_t>& scc) const {
+    if (scc.size() > 1) return true;
+    const auto& callees = nodes[scc.front()].callees;
+    return std::ranges::find(callees, scc.front()) != callees.end();
+}
+
+void CallGraph::CollectCalls(const StmtSP& stmt, std::vector<CallSite>& calls) const {
+    if (!stmt) return;
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) {
+        CollectCalls(p->expr, calls);
+    }
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+        CollectCalls(p->value, calls);
+    }
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (const auto& s : p->body) CollectCalls(s, calls);
+    }
+}
+
+void CallGraph::CollectCalls(const ExprSP& expr, std::vector<CallSite>& calls) const {
+    if (!expr) return;
+
+    if (auto p = InstanceOf<ParenExpr>(expr)) {
+        CollectCalls(p->subExpr, calls);
+    }
+    else if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+        CollectCalls(p->subExpr, calls);
+    }
+    else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        CollectCalls(p->subExpr, calls);
+    }
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        CollectCalls(p->left, calls);
+        CollectCalls(p->right, calls);
+    }
+    else if (auto p = InstanceOf<CallExpr>(expr)) {
+        auto ident = InstanceOf<IdentifierExpr>(p->callee);
+        auto callee = ident ? Find(ident->value.identName) : std::nullopt;
+        if (callee) calls.push_back({p, *callee});
+
+        for (const auto& arg : p->args) CollectCalls(arg, calls);
+    }
+    else if (auto p = InstanceOf<IndexExpr>(expr)) {
+        CollectCalls(p->indexedExpr, calls);
+        for (const auto& index : p->indices) CollectCalls(index, calls);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Parsing/Statement.hpp"
+#include <Parsing/ASTNode.hpp>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pl {
+    // Functions of an analysed program and the functions each one calls directly.
+    class CallGraph {
+        public:
+            struct CallSite {
+                CallSP call;
+                size_t callee = 0;
+            };
+
+        private:
+            struct Node {
+                FuncDeclStmtSP decl;
+                std::vector<size_t> callees;    // Sorted and unique.
+                std::vector<CallSite> calls;    // In source order.
+            };
+
+            std::vector<Node> nodes;
+            std::unordered_map<std::string, size_t> indices;
+
+        public:
+            explicit CallGraph(const std::vector<FileSourceNodeSP>& files);
+
+            [[nodiscard]] size_t Size() const { return nodes.size(); }
+            [[nodiscard]] const FuncDeclStmtSP& GetFunction(size_t index) const { return nodes[index].decl; }
+            [[nodiscard]] const std::vector<size_t>& GetCallees(size_t index) const { return nodes[index].callees; }
+            [[nodiscard]] const std::vector<CallSite>& GetCallSites(size_t index) const { return nodes[index].calls; }
+            [[nodiscard]] std::optional<size_t> Find(std::string_view name) const;
+
+            // Strongly connected components, each listed after every component it calls.
+            [[nodiscard]] std::vector<std::vector<size_t>> ComputeSCCs() const;
+
+            // Whether the functions of a component can call themselves.
+            [[nodiscard]] bool IsRecursive(const std::vector<size_t>& scc) const;
+
+        private:
+            void CollectCalls(const StmtSP& stmt, std::vector<CallSite>& calls) const;
+            void CollectCalls(const ExprSP& expr, std::vector<CallSite>& calls) const;
+    };
+}
@@ -0,0 +1,127 @@
+#include "ComptimeEvaluation.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "fmt/core.h"
+#include <Utils/Utils.hpp>
+#include <algorithm>
+
+using namespace pl;
+
+static InterpreterSettings MakeSandboxSettings(const ComptimeLimits& limits) {
+    InterpreterSettings settings;
+    settings.maxSteps = limits.maxSteps;
+    settings.maxMemory = limits.maxMemory;
+    settings.maxCallDepth = limits.maxCallDepth;
+    // Table generation tends to recompute the same values, and nothing here can observe a skipped call.
+    settings.memoize = true;
+    return settings;
+}
+
+ComptimeEvaluator::ComptimeEvaluator(const std::vector<FileSourceNodeSP>& files, const ComptimeLimits& limits)
+    : interpreter(files, MakeSandboxSettings(limits)) { }
+
+void ComptimeEvaluator::Evaluate(const FileSourceNodeSP& file) {
+    for (auto& stmt : file->statements) {
+        auto func = InstanceOf<FuncDeclStmt>(stmt);
+        // Compile-time bodies run as written in the interpreter, so only runtime code is rewritten.
+        if (func && !func->isComptime) EvaluateStatement(func->body);
+    }
+
+    // Every call has been replaced by its value, so nothing refers to these at runtime.
+    std::erase_if(file->statements, [](const StmtSP& stmt) {
+        auto func = InstanceOf<FuncDeclStmt>(stmt);
+        return func && func->isComptime;
+    });
+}
+
+void ComptimeEvaluator::EvaluateStatement(const StmtSP& stmt) {
+    if (!stmt) return;
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) {
+        p->expr = EvaluateExpression(p->expr);
+    }
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+        if (p->value) p->value = EvaluateExpression(p->value);
+    }
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (auto& s : p->body) EvaluateStatement(s);
+    }
+}
+
+ExprSP ComptimeEvaluator::EvaluateExpression(const ExprSP& expr) {
+    if (!expr) return expr;
+
+    if (InstanceOf<ComptimeExpr>(expr) || IsComptimeCall(expr)) {
+        return EvaluateAtCompileTime(expr);
+    }
+
+    if (auto p = InstanceOf<ParenExpr>(expr)) {
+        p->subExpr = EvaluateExpression(p->subExpr);
+    }
+    else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        p->subExpr = EvaluateExpression(p->subExpr);
+    }
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        p->left = EvaluateExpression(p->left);
+        p->right = EvaluateExpression(p->right);
+    }
+    else if (auto p = InstanceOf<CallExpr>(expr)) {
+        for (auto& arg : p->args) arg = EvaluateExpression(arg);
+    }
+    else if (auto p = InstanceOf<IndexExpr>(expr)) {
+        p->indexedExpr = EvaluateExpression(p->indexedExpr);
+        for (auto& index : p->indices) index = EvaluateExpression(index);
+    }
+    return expr;
+}
+
+ExprSP ComptimeEvaluator::EvaluateAtCompileTime(const ExprSP& expr) {
+    if (!CheckClosed(expr)) return expr;
+
+    const auto firstError = interpreter.GetErrors().size();
+    auto value = interpreter.EvaluateConstant(*expr);
+    if (!value) {
+        const auto& failures = interpreter.GetErrors();
+        for (auto i = firstError; i < failures.size(); i++) {
+            AddError(fmt::format("Compile-time evaluation failed: {}", failures[i].msg), expr->line);
+        }
+        return expr;
+    }
+
+    evaluatedCount++;
+    return ConstantFolder::MakeConstant(*value, expr);
+}
+
+bool ComptimeEvaluator::IsComptimeCall(const ExprSP& expr) const {
+    auto call = InstanceOf<CallExpr>(expr);
+    if (!call) return false;
+
+    auto ident = InstanceOf<IdentifierExpr>(call->callee);
+    auto func = ident ? interpreter.FindFunction(ident->value.identName) : nullptr;
+    return func && func->isComptime;
+}
+
+bool ComptimeEvaluator::CheckClosed(const ExprSP& expr) {
+    if (auto p = InstanceOf<IdentifierExpr>(expr)) {
+        AddError(fmt::format("'{}' is not known at compile time.", p->value.identName), p->line);
+        return false;
+    }
+    if (auto p = InstanceOf<ParenExpr>(expr)) return CheckClosed(p->subExpr);
+    if (auto p = InstanceOf<ComptimeExpr>(expr)) return CheckClosed(p->subExpr);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) return CheckClosed(p->subExpr);
+    if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        // Both sides are checked so that every runtime value is reported.
+        const bool left = CheckClosed(p->left);
+        const bool right = CheckClosed(p->right);
+        return left && right;
+    }
+    if (auto p = InstanceOf<CallExpr>(expr)) {
+        bool closed = true;
+        for (const auto& arg : p->args) closed = CheckClosed(arg) && closed;
+        return closed;
+    }
+    return true;
+}
+
+void ComptimeEvaluator::AddError(std::string msg, int line) {
+    errors.push_back({"comptime", std::move(msg), line});
+}
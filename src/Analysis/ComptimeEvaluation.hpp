@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Interpreter/Interpreter.hpp"
+#include "Parsing/Statement.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pl {
+    struct ComptimeLimits {
+        uint64_t maxSteps = 10'000'000;     // -fcomptime-steps=N, statements per evaluated expression.
+        uint64_t maxMemory = 64ull << 20;   // -fcomptime-memory=<MiB>, interpreter frames per evaluated expression.
+        uint32_t maxCallDepth = 10000;
+    };
+
+    // Replaces 'comptime' expressions and calls to 'comptime func's with their values, then drops the
+    // compile-time functions. Evaluation runs on the interpreter without a native tier, within the limits.
+    class ComptimeEvaluator {
+        private:
+            Interpreter interpreter;
+            std::vector<ErrorInfo> errors;
+            int evaluatedCount = 0;
+
+        public:
+            ComptimeEvaluator(const std::vector<FileSourceNodeSP>& files, const ComptimeLimits& limits);
+
+            void Evaluate(const FileSourceNodeSP& file);
+
+            [[nodiscard]] int GetEvaluatedCount() const { return evaluatedCount; }
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            void EvaluateStatement(const StmtSP& stmt);
+            ExprSP EvaluateExpression(const ExprSP& expr);
+            ExprSP EvaluateAtCompileTime(const ExprSP& expr);
+
+            bool IsComptimeCall(const ExprSP& expr) const;
+            bool CheckClosed(const ExprSP& expr);
+
+            void AddError(std::string msg, int line);
+    };
+}
@@ -0,0 +1,310 @@
+#include "ConstantFolding.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Utils/TimeTrace.hpp"
+#include <Utils/Utils.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using namespace pl;
+
+static IntegerTypeInfo IntegerInfoOf(const TypeSP& type) {
+    return GetIntegerTypeInfo(type).value_or(IntegerTypeInfo {64, true});
+}
+
+static int64_t WrapInteger(uint64_t value, const IntegerTypeInfo& info) {
+    if (info.bits == 64) return static_cast<int64_t>(value);
+
+    const uint64_t mask = (uint64_t {1} << info.bits) - 1;
+    value &= mask;
+    if (info.isSigned && ((value >> (info.bits - 1)) & 1)) value |= ~mask;
+    return static_cast<int64_t>(value);
+}
+
+static double RoundFloat(double value, const TypeSP& type) {
+    auto p = InstanceOf<NamedType>(type);
+    if (p && p->name.identName == "f32") return static_cast<double>(static_cast<float>(value));
+    return value;
+}
+
+static std::optional<ConstantValue> EvaluateIntegerBinary(TokenType op, int64_t lhs, int64_t rhs, const TypeSP& type) {
+    const auto info = IntegerInfoOf(type);
+    const auto ul = static_cast<uint64_t>(lhs);
+    const auto ur = static_cast<uint64_t>(rhs);
+
+    switch (op) {
+        case TokenType::Plus: return WrapInteger(ul + ur, info);
+        case TokenType::Minus: return WrapInteger(ul - ur, info);
+        case TokenType::Star: return WrapInteger(ul * ur, info);
+        case TokenType::Slash:
+        case TokenType::Mod: {
+            if (rhs == 0) return std::nullopt;
+
+            if (!info.isSigned) {
+                const uint64_t mask = info.bits == 64 ? ~uint64_t {0} : (uint64_t {1} << info.bits) - 1;
+                const uint64_t a = ul & mask, b = ur & mask;
+                return WrapInteger(op == TokenType::Slash ? a / b : a % b, info);
+            }
+
+            const int64_t minValue = info.bits == 64
+                ? std::numeric_limits<int64_t>::min()
+                : -(int64_t {1} << (info.bits - 1));
+            if (lhs == minValue && rhs == -1) return std::nullopt;
+
+            return WrapInteger(static_cast<uint64_t>(op == TokenType::Slash ? lhs / rhs : lhs % rhs), info);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+static std::optional<ConstantValue> EvaluateFloatBinary(TokenType op, double lhs, double rhs, const TypeSP& type) {
+    switch (op) {
+        case TokenType::Plus: return RoundFloat(lhs + rhs, type);
+        case TokenType::Minus: return RoundFloat(lhs - rhs, type);
+        case TokenType::Star: return RoundFloat(lhs * rhs, type);
+        case TokenType::Slash: return RoundFloat(lhs / rhs, type);
+        case TokenType::Mod: return RoundFloat(std::fmod(lhs, rhs), type);
+        default: return std::nullopt;
+    }
+}
+
+std::optional<ConstantValue> pl::EvaluateUnary(TokenType op, const ConstantValue& operand, const TypeSP& type) {
+    if (op == TokenType::Plus) return operand;
+    if (op != TokenType::Minus) return std::nullopt;
+
+    if (auto p = std::get_if<int64_t>(&operand)) {
+        return WrapInteger(uint64_t {0} - static_cast<uint64_t>(*p), IntegerInfoOf(type));
+    }
+    return RoundFloat(-std::get<double>(operand), type);
+}
+
+std::optional<ConstantValue> pl::EvaluateBinary(TokenType op, const ConstantValue& lhs, const ConstantValue& rhs, const TypeSP& type) {
+    if (lhs.index() != rhs.index()) return std::nullopt;
+
+    if (auto p = std::get_if<int64_t>(&lhs)) {
+        return EvaluateIntegerBinary(op, *p, std::get<int64_t>(rhs), type);
+    }
+    return EvaluateFloatBinary(op, std::get<double>(lhs), std::get<double>(rhs), type);
+}
+
+std::optional<ConstantValue> pl::EvaluateLiteral(const LiteralExpr& lit) {
+    if (lit.value.type == TokenType::IntLiteral) {
+        auto value = std::get<int64_t>(lit.value.literalValue);
+        if (IsFloatType(lit.exprType)) return RoundFloat(static_cast<double>(value), lit.exprType);
+        return value;
+    }
+    if (lit.value.type == TokenType::DoubleLiteral) return std::get<double>(lit.value.literalValue);
+    return std::nullopt;
+}
+
+static bool IsIntegerConstant(const ExprSP& expr, int64_t value) {
+    auto lit = InstanceOf<LiteralExpr>(expr);
+    if (!lit || lit->value.type != TokenType::IntLiteral) return false;
+    return std::get<int64_t>(lit->value.literalValue) == value;
+}
+
+// Whether dropping the expression can change observable behavior (calls, or operations that may trap).
+static bool HasSideEffects(const ExprSP& expr) {
+    if (InstanceOf<LiteralExpr>(expr) || InstanceOf<IdentifierExpr>(expr)) return false;
+    if (auto p = InstanceOf<ParenExpr>(expr)) return HasSideEffects(p->subExpr);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        if (!p->op.Check({TokenType::Plus, TokenType::Minus})) return true;
+        return HasSideEffects(p->subExpr);
+    }
+    if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        if (!p->op.Check({TokenType::Plus, TokenType::Minus, TokenType::Star})) return true;
+        return HasSideEffects(p->left) || HasSideEffects(p->right);
+    }
+    return true;
+}
+
+std::optional<ConstantValue> ConstantFolder::Evaluate(const ExprSP& expr) {
+    if (auto p = InstanceOf<LiteralExpr>(expr)) {
+        return EvaluateLiteral(*p);
+    }
+    if (auto p = InstanceOf<ParenExpr>(expr)) {
+        return Evaluate(p->subExpr);
+    }
+    if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+        return Evaluate(p->subExpr);
+    }
+    if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        auto operand = Evaluate(p->subExpr);
+        if (!operand) return std::nullopt;
+        return EvaluateUnary(p->op.type, *operand, p->exprType);
+    }
+    if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        auto lhs = Evaluate(p->left);
+        if (!lhs) return std::nullopt;
+        auto rhs = Evaluate(p->right);
+        if (!rhs) return std::nullopt;
+        return EvaluateBinary(p->op.type, *lhs, *rhs, p->exprType);
+    }
+    return std::nullopt;
+}
+
+void ConstantFolder::Fold(const FileSourceNodeSP& file) {
+    TimeTraceScope timeScope("ConstantFolding", file->filename);
+    for (auto& stmt : file->statements) {
+        FoldStatement(stmt);
+    }
+}
+
+void ConstantFolder::FoldStatement(const StmtSP& stmt) {
+    if (!stmt) return;
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) {
+        p->expr = FoldExpression(p->expr);
+    }
+    else if (auto p = InstanceOf<FuncDeclStmt>(stmt)) {
+        const auto enclosing = function;
+        function = p.get();
+        FoldStatement(p->body);
+        function = enclosing;
+    }
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+        if (p->value) p->value = FoldExpression(p->value);
+    }
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (auto& s : p->body) FoldStatement(s);
+    }
+}
+
+ExprSP ConstantFolder::FoldExpression(const ExprSP& expr) {
+    if (!expr) return expr;
+
+    if (auto p = InstanceOf<ParenExpr>(expr)) {
+        foldCount++;
+        return FoldExpression(p->subExpr);
+    }
+    if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        return FoldUnary(p);
+    }
+    if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        return FoldBinary(p);
+    }
+    if (auto p = InstanceOf<CallExpr>(expr)) {
+        p->callee = FoldExpression(p->callee);
+        for (auto& arg : p->args) arg = FoldExpression(arg);
+    }
+    else if (auto p = InstanceOf<IndexExpr>(expr)) {
+        p->indexedExpr = FoldExpression(p->indexedExpr);
+        for (auto& index : p->indices) index = FoldExpression(index);
+    }
+    return expr;
+}
+
+ExprSP ConstantFolder::FoldUnary(const UnarySP& unary) {
+    unary->subExpr = FoldExpression(unary->subExpr);
+
+    auto lit = InstanceOf<LiteralExpr>(unary->subExpr);
+    if (!lit) return unary;
+
+    auto operand = EvaluateLiteral(*lit);
+    if (!operand) return unary;
+
+    auto result = EvaluateUnary(unary->op.type, *operand, unary->exprType);
+    if (!result) return unary;
+
+    foldCount++;
+    return MakeConstant(*result, unary);
+}
+
+ExprSP ConstantFolder::FoldBinary(const BinarySP& binary) {
+    binary->left = FoldExpression(binary->left);
+    binary->right = FoldExpression(binary->right);
+
+    auto llit = InstanceOf<LiteralExpr>(binary->left);
+    auto rlit = InstanceOf<LiteralExpr>(binary->right);
+
+    if (llit && rlit) {
+        auto lhs = EvaluateLiteral(*llit);
+        auto rhs = EvaluateLiteral(*rlit);
+        if (lhs && rhs) {
+            auto result = EvaluateBinary(binary->op.type, *lhs, *rhs, binary->exprType);
+            if (result) {
+                foldCount++;
+                return MakeConstant(*result, binary);
+            }
+        }
+    }
+
+    return SimplifyIdentity(binary);
+}
+
+bool ConstantFolder::IsIntegerExpr(const ExprSP& expr) const {
+    if (expr->exprType) return IsIntegerType(expr->exprType);
+
+    // Not analysed: integer literals and arguments declared with an integer type, and arithmetic made only of them.
+    if (auto p = InstanceOf<LiteralExpr>(expr)) return p->value.type == TokenType::IntLiteral;
+    if (auto p = InstanceOf<IdentifierExpr>(expr)) {
+        if (!function) return false;
+        for (const auto& arg : function->args) {
+            if (arg.name.identName == p->value.identName) return IsIntegerType(arg.type);
+        }
+        return false;
+    }
+    if (auto p = InstanceOf<ParenExpr>(expr)) return IsIntegerExpr(p->subExpr);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        return p->op.Check({TokenType::Plus, TokenType::Minus}) && IsIntegerExpr(p->subExpr);
+    }
+    if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        return p->op.Check({TokenType::Plus, TokenType::Minus, TokenType::Star, TokenType::Slash, TokenType::Mod})
+            && IsIntegerExpr(p->left) && IsIntegerExpr(p->right);
+    }
+    return false;
+}
+
+ExprSP ConstantFolder::SimplifyIdentity(const BinarySP& binary) {
+    // Identities are only exact for integers (e.g. -0.0 + 0.0 == +0.0), so the type must be known.
+    if (!IsIntegerExpr(binary)) return binary;
+
+    const auto& left = binary->left;
+    const auto& right = binary->right;
+    ExprSP out;
+
+    switch (binary->op.type) {
+        case TokenType::Plus:
+            if (IsIntegerConstant(right, 0)) out = left;
+            else if (IsIntegerConstant(left, 0)) out = right;
+            break;
+        case TokenType::Minus:
+            if (IsIntegerConstant(right, 0)) out = left;
+            break;
+        case TokenType::Star:
+            if (IsIntegerConstant(right, 1)) out = left;
+            else if (IsIntegerConstant(left, 1)) out = right;
+            else if (IsIntegerConstant(right, 0) && !HasSideEffects(left)) out = MakeConstant(int64_t {0}, binary);
+            else if (IsIntegerConstant(left, 0) && !HasSideEffects(right)) out = MakeConstant(int64_t {0}, binary);
+            break;
+        case TokenType::Slash:
+            if (IsIntegerConstant(right, 1)) out = left;
+            break;
+        default:
+            break;
+    }
+
+    if (!out) return binary;
+    foldCount++;
+    return out;
+}
+
+ExprSP ConstantFolder::MakeConstant(const ConstantValue& value, const ExprSP& replaced) {
+    Token tok;
+    tok.lineNumber = replaced->line;
+
+    if (auto p = std::get_if<int64_t>(&value)) {
+        tok.type = TokenType::IntLiteral;
+        tok.literalValue = *p;
+    }
+    else {
+        tok.type = TokenType::DoubleLiteral;
+        tok.literalValue = std::get<double>(value);
+    }
+
+    auto out = MakeSP<LiteralExpr>(tok);
+    out->exprType = replaced->exprType;
+    out->line = replaced->line;
+    return out;
+}
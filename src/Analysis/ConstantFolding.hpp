@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Parsing/Statement.hpp"
+#include <Parsing/ASTNode.hpp>
+#include <Parsing/Expression.hpp>
+#include <cstdint>
+#include <optional>
+#include <variant>
+
+namespace pl {
+    using ConstantValue = std::variant<int64_t, double>;
+
+    // Integer arithmetic wraps around at the width of the expression type (i64 when untyped).
+    // Division or modulo by zero and signed MIN / -1 are never folded, so they keep their runtime behavior.
+    std::optional<ConstantValue> EvaluateUnary(TokenType op, const ConstantValue& operand, const TypeSP& type);
+    std::optional<ConstantValue> EvaluateBinary(TokenType op, const ConstantValue& lhs, const ConstantValue& rhs, const TypeSP& type);
+
+    // The value of a literal converted to its analysed type (integer literals coerced to floats become doubles).
+    std::optional<ConstantValue> EvaluateLiteral(const LiteralExpr& lit);
+
+    class ConstantFolder {
+        public:
+            void Fold(const FileSourceNodeSP& file);
+            void FoldStatement(const StmtSP& stmt);
+            [[nodiscard]] ExprSP FoldExpression(const ExprSP& expr);
+
+            // Evaluates an expression without modifying it, if it is made only of constants.
+            static std::optional<ConstantValue> Evaluate(const ExprSP& expr);
+
+            // A literal holding the value, with the type and line of the expression it replaces.
+            static ExprSP MakeConstant(const ConstantValue& value, const ExprSP& replaced);
+
+            [[nodiscard]] int GetFoldCount() const { return foldCount; }
+
+        private:
+            int foldCount = 0;
+            const FuncDeclStmt* function = nullptr;   // Whose arguments identifiers refer to.
+
+            ExprSP FoldUnary(const UnarySP& unary);
+            ExprSP FoldBinary(const BinarySP& binary);
+            ExprSP SimplifyIdentity(const BinarySP& binary);
+
+            // From the analysed type, or else from the literals and declared argument types the expression is made of.
+            [[nodiscard]] bool IsIntegerExpr(const ExprSP& expr) const;
+    };
+}
@@ -0,0 +1,48 @@
+#include "DeadFunctionElimination.hpp"
+#include "Analysis/CallGraph.hpp"
+#include "Utils/TimeTrace.hpp"
+#include <Utils/Utils.hpp>
+#include <algorithm>
+
+using namespace pl;
+
+void DeadFunctionEliminator::Run(const std::vector<FileSourceNodeSP>& files) {
+    TimeTraceScope timeScope("DeadFunctionElimination");
+    CallGraph graph(files);
+    totalCount = graph.Size();
+
+    std::vector<size_t> worklist;
+    for (size_t i = 0; i < graph.Size(); i++) {
+        const auto& decl = graph.GetFunction(i);
+        if (decl->isExported || decl->name.identName == "Main") worklist.push_back(i);
+    }
+    if (worklist.empty()) return;
+
+    std::vector<bool> reachable(graph.Size(), false);
+    for (auto i : worklist) reachable[i] = true;
+
+    while (!worklist.empty()) {
+        const auto current = worklist.back();
+        worklist.pop_back();
+        for (auto callee : graph.GetCallees(current)) {
+            if (reachable[callee]) continue;
+            reachable[callee] = true;
+            worklist.push_back(callee);
+        }
+    }
+
+    std::vector<const FuncDeclStmt*> dead;
+    for (size_t i = 0; i < graph.Size(); i++) {
+        if (reachable[i]) continue;
+        dead.push_back(graph.GetFunction(i).get());
+        removed.push_back(graph.GetFunction(i)->name.identName);
+    }
+    if (dead.empty()) return;
+
+    std::ranges::sort(dead);
+    for (const auto& file : files) {
+        std::erase_if(file->statements, [&](const StmtSP& stmt) {
+            return std::ranges::binary_search(dead, dynamic_cast<const FuncDeclStmt*>(stmt.get()));
+        });
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Parsing/Statement.hpp"
+#include <Parsing/ASTNode.hpp>
+#include <string>
+#include <vector>
+
+namespace pl {
+    // Drops functions that cannot be reached from the entry points, 'Main' and every 'export func', before
+    // they cost anything in code generation. A program defining neither is a library and is left as is.
+    class DeadFunctionEliminator {
+        private:
+            size_t totalCount = 0;
+            std::vector<std::string> removed;
+
+        public:
+            void Run(const std::vector<FileSourceNodeSP>& files);
+
+            [[nodiscard]] size_t GetTotalCount() const { return totalCount; }
+            [[nodiscard]] const std::vector<std::string>& GetRemoved() const { return removed; }
+    };
+}
@@ -0,0 +1,40 @@
+#include "EffectAnalysis.hpp"
+#include "Utils/TimeTrace.hpp"
+#include <algorithm>
+
+using namespace pl;
+
+static FunctionEffects CombineEffects(const FunctionEffects& a, const FunctionEffects& b) {
+    FunctionEffects out;
+    out.memory = std::max(a.memory, b.memory);
+    out.mayUnwind = a.mayUnwind || b.mayUnwind;
+    out.mayDiverge = a.mayDiverge || b.mayDiverge;
+    return out;
+}
+
+void pl::InferFunctionEffects(const CallGraph& graph) {
+    TimeTraceScope timeScope("InferFunctionEffects");
+    for (const auto& scc : graph.ComputeSCCs()) {
+        // The members of a cycle can reach each other, so they all share one result.
+        FunctionEffects effects;
+        effects.memory = MemoryEffect::None;
+        effects.mayUnwind = false;
+        effects.mayDiverge = graph.IsRecursive(scc);
+
+        for (auto index : scc) {
+            const auto& decl = graph.GetFunction(index);
+            if (!decl->body) continue;
+
+            // Components are visited callees first, so every callee outside this one is final already.
+            for (auto callee : graph.GetCallees(index)) {
+                if (std::ranges::find(scc, callee) != scc.end()) continue;
+                effects = CombineEffects(effects, graph.GetFunction(callee)->effects);
+            }
+        }
+
+        for (auto index : scc) {
+            const auto& decl = graph.GetFunction(index);
+            if (decl->body) decl->effects = effects;
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Analysis/CallGraph.hpp"
+
+namespace pl {
+    // Infers FunctionEffects for every function in the graph, callees before callers.
+    // Function bodies are arithmetic and calls only, so a body's effects are those of its callees, plus
+    // possible divergence when it is part of a recursive cycle. Declarations without a body are external
+    // and keep the conservative defaults.
+    void InferFunctionEffects(const CallGraph& graph);
+}
@@ -1,33 +1,177 @@
 #include "SemanticAnalysis.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Analysis/CallGraph.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "Analysis/EffectAnalysis.hpp"
 #include "Analysis/SymbolTable.hpp"
+#include "Utils/TimeTrace.hpp"
 #include "fmt/core.h"
+#include "magic_enum/magic_enum.hpp"
 #include <Parsing/Statement.hpp>
 #include <Utils/Utils.hpp>
+#include <limits>
 #include <string_view>
 #include <vector>
 
 using namespace pl;
 
-SemanticAnalyzer::SemanticAnalyzer(const std::vector<FileSourceNodeSP>& files, std::string_view moduleName)
-    : files(files), symbolTable(moduleName) {
+static bool AlwaysReturns(const StmtSP& stmt) {
+    if (InstanceOf<ReturnStmt>(stmt)) return true;
+    if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (auto& s : p->body) {
+            if (AlwaysReturns(s)) return true;
+        }
+    }
+    return false;
+}
+
+static void SetConstantType(const ExprSP& expr, const TypeSP& type) {
+    expr->exprType = type;
+    if (auto p = InstanceOf<ParenExpr>(expr)) SetConstantType(p->subExpr, type);
+    else if (auto p = InstanceOf<ComptimeExpr>(expr)) SetConstantType(p->subExpr, type);
+    else if (auto p = InstanceOf<UnaryExpr>(expr)) SetConstantType(p->subExpr, type);
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        SetConstantType(p->left, type);
+        SetConstantType(p->right, type);
+    }
+}
+
+static bool FitsInteger(int64_t value, const IntegerTypeInfo& info) {
+    if (!info.isSigned && value < 0) return false;
+    if (info.bits == 64) return true;
+    if (!info.isSigned) return value < (int64_t {1} << info.bits);
+    return value >= -(int64_t {1} << (info.bits - 1)) && value < (int64_t {1} << (info.bits - 1));
+}
+
+// Whether a constant expression and every operand in it fold to values of the integer type. The target type wraps
+// on overflow, so this is what makes folding in it give the same value. A negated literal only needs to fit as a
+// whole, so that e.g. -128 is an i8.
+static bool FitsIntegerType(const ExprSP& expr, const IntegerTypeInfo& info) {
+    if (auto p = InstanceOf<ParenExpr>(expr)) return FitsIntegerType(p->subExpr, info);
+    if (auto p = InstanceOf<ComptimeExpr>(expr)) return FitsIntegerType(p->subExpr, info);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        const bool negatedLiteral = p->op.type == TokenType::Minus && InstanceOf<LiteralExpr>(p->subExpr);
+        if (!negatedLiteral && !FitsIntegerType(p->subExpr, info)) return false;
+    }
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        if (!FitsIntegerType(p->left, info) || !FitsIntegerType(p->right, info)) return false;
+    }
+
+    auto value = ConstantFolder::Evaluate(expr);
+    auto p = value ? std::get_if<int64_t>(&*value) : nullptr;
+    return p && FitsInteger(*p, info);
+}
+
+// Code generation reuses the caller's frame for a tail call only when both functions lower to the same prototype,
+// in which integers are told apart by width alone.
+static bool HaveSameLoweredType(const TypeSP& a, const TypeSP& b) {
+    if (IsSameType(a, b)) return true;
+    auto left = GetIntegerTypeInfo(a);
+    auto right = GetIntegerTypeInfo(b);
+    return left && right && left->bits == right->bits;
+}
+
+static bool HaveSameLoweredSignature(const FuncDeclStmt& a, const FuncDeclStmt& b) {
+    if (a.args.size() != b.args.size() || !HaveSameLoweredType(a.returnType, b.returnType)) return false;
+    for (size_t i = 0; i < a.args.size(); i++) {
+        if (!HaveSameLoweredType(a.args[i].type, b.args[i].type)) return false;
+    }
+    return true;
+}
+
+SemanticAnalyzer::SemanticAnalyzer(const std::vector<FileSourceNodeSP>& files, std::string_view moduleName, const DiagnosticsSettings& diagnosticsSettings)
+    : files(files), symbolTable(moduleName), diagnostics(diagnosticsSettings) {
+    // Contexts are interned in file order, which diagnostics are sorted by.
+    for (const auto& file : files) diagnostics.InternContext(fmt::format("{}:{}", moduleName, file->filename), file->file);
     PopulateGlobalSymbols(files);
 }
 
 void SemanticAnalyzer::Analyze() {
+    TimeTraceScope timeScope("SemanticAnalysis");
+
     for (auto& file : files) {
         AnalyzeFile(file);
     }
+
+    // The evaluator relies on every body being analysed and valid, and on effects to memoise calls.
+    if (!diagnostics.HadErrors()) {
+        InferFunctionEffects(CallGraph(files));
+        EvaluateComptime();
+    }
+
+    // Refined on the calls that remain once compile-time calls were replaced, which are those that recurse at run time.
+    if (!diagnostics.HadErrors()) {
+        CallGraph graph(files);
+        InferFunctionEffects(graph);
+        CheckRecursiveCalls(graph);
+    }
 }
 
-void SemanticAnalyzer::AddError(std::string_view msg, int line) {
-    errors.push_back({
-        fmt::format("{}:{}", symbolTable.GetModuleName(), symbolTable.GetFileName()),
-        std::string(msg),
-        line
-    });
+void SemanticAnalyzer::CheckRecursiveCalls(const CallGraph& graph) {
+    constexpr size_t NotRecursive = std::numeric_limits<size_t>::max();
+
+    // Direct recursion is checked as calls are analysed, so only components of several functions are of interest.
+    std::vector<size_t> component(graph.Size(), NotRecursive);
+    const auto sccs = graph.ComputeSCCs();
+    for (size_t i = 0; i < sccs.size(); i++) {
+        if (sccs[i].size() < 2) continue;
+        for (auto member : sccs[i]) component[member] = i;
+    }
+
+    for (const auto& file : files) {
+        auto fileguard = symbolTable.GetFileGuard(file->filename);
+        for (const auto& stmt : file->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            auto caller = func && !func->isComptime ? graph.Find(func->name.identName) : std::nullopt;
+            if (!caller || component[*caller] == NotRecursive) continue;
+
+            for (const auto& site : graph.GetCallSites(*caller)) {
+                if (site.callee == *caller || component[site.callee] != component[*caller]) continue;
+
+                const auto& callee = graph.GetFunction(site.callee);
+                if (!site.call->isTailCall) {
+                    Report(DiagID::NonTailRecursion, site.call->line, callee->name.identName);
+                }
+                else if (!HaveSameLoweredSignature(*func, *callee)) {
+                    Report(DiagID::TailCallSignatureMismatch, site.call->line, callee->name.identName, func->name.identName);
+                }
+            }
+        }
+    }
+}
+
+void SemanticAnalyzer::AnalyzeFunction(const FuncDeclStmtSP& func, std::string_view filename) {
+    auto fileguard = symbolTable.GetFileGuard(filename);
+    AnalyzeFuncDeclStatement(func);
+}
+
+void SemanticAnalyzer::EvaluateComptime() {
+    TimeTraceScope timeScope("Comptime");
+    ComptimeEvaluator evaluator(files, comptimeLimits);
+    for (auto& file : files) {
+        auto fileguard = symbolTable.GetFileGuard(file->filename);
+        const auto firstError = evaluator.GetErrors().size();
+        evaluator.Evaluate(file);
+
+        const auto& evalErrors = evaluator.GetErrors();
+        for (auto i = firstError; i < evalErrors.size(); i++) {
+            Report(DiagID::Custom, evalErrors[i].line, evalErrors[i].msg);
+        }
+    }
+}
+
+uint32_t SemanticAnalyzer::GetContext() {
+    // Diagnostics come file by file, so the context only needs formatting when the file changes.
+    auto file = symbolTable.GetFileName();
+    if (file != contextFile) {
+        context = diagnostics.InternContext(fmt::format("{}:{}", symbolTable.GetModuleName(), file));
+        contextFile = std::move(file);
+    }
+    return context;
 }
 
 void SemanticAnalyzer::PopulateGlobalSymbols(const std::vector<FileSourceNodeSP>& files) {
+    TimeTraceScope timeScope("PopulateGlobalSymbols");
     for (const auto& file : files) {
         auto fileguard = symbolTable.GetFileGuard(file->filename);
         for (const auto& stmt : file->statements) {
@@ -39,14 +183,11 @@ void SemanticAnalyzer::PopulateGlobalSymbols(const std::vector<FileSourceNodeSP>
                 fsym.returnType = p->returnType;
                 auto success = symbolTable.Insert(p->name.identName, Symbol {fsym});
                 if (!success) {
-                    AddError(fmt::format("Function '{}' already defined.", p->name.identName), p->line);
+                    Report(DiagID::FunctionRedefined, p->line, p->name.identName);
                 }
             }
             else {
-                AddError(
-                    "Global scope only supports function and type declarations.",
-                    stmt->line
-                );
+                Report(DiagID::GlobalStatement, stmt->line);
             }
         }
     }
@@ -55,11 +196,16 @@ void SemanticAnalyzer::PopulateGlobalSymbols(const std::vector<FileSourceNodeSP>
 void SemanticAnalyzer::AnalyzeFile(FileSourceNodeSP file) {
     auto fileguard = symbolTable.GetFileGuard(file->filename);
     for (auto& stmt : file->statements) {
-        AnalyzeStatement(stmt);
+        // Further errors would only be counted.
+        if (diagnostics.LimitReached()) return;
+        // Anything else on file scope was already rejected by PopulateGlobalSymbols.
+        if (InstanceOf<FuncDeclStmt>(stmt)) AnalyzeStatement(stmt);
     }
 }
 
 void SemanticAnalyzer::AnalyzeStatement(StmtSP stmt) {
+    if (!stmt) return;
+
     if (auto p = InstanceOf<ExprStmt>(stmt)) {
         AnalyzeExprStatement(p);
     }
@@ -73,19 +219,41 @@ void SemanticAnalyzer::AnalyzeStatement(StmtSP stmt) {
         AnalyzeBlockStatement(p);
     }
     else {
-        AddError("Unsupported statement type.", stmt->line);
+        Report(DiagID::UnsupportedStatement, stmt->line);
     }
 }
 
 void SemanticAnalyzer::AnalyzeExprStatement(ExprStmtSP exsp) {
-    (void) exsp;
+    AnalyzeExpression(exsp->expr);
 }
 
 void SemanticAnalyzer::AnalyzeFuncDeclStatement(FuncDeclStmtSP func) {
+    TimeTraceScope timeScope("Analyze", func->name.identName);
     if (!symbolTable.IsOnModuleScope()) {
-        AddError("Functions may only be declared on file scope.", func->line);
+        Report(DiagID::NestedFunction, func->line);
         return;
     }
+
+    bool validSignature = true;
+    for (auto& arg : func->args) {
+        if (!IsBuiltinType(arg.type) || IsVoidType(arg.type)) {
+            Report(DiagID::InvalidArgumentType, func->line, arg.name.identName, TypeName(arg.type));
+            validSignature = false;
+        }
+    }
+    if (!IsBuiltinType(func->returnType)) {
+        Report(DiagID::UnknownReturnType, func->line, func->name.identName, TypeName(func->returnType));
+        validSignature = false;
+    }
+
+    if (func->isComptime && !func->body) {
+        Report(DiagID::ComptimeWithoutBody, func->line, func->name.identName);
+    }
+    if (func->isExported && !func->body) {
+        Report(DiagID::ExportWithoutBody, func->line, func->name.identName);
+    }
+    if (!validSignature || !func->body) return;
+
     RAIIScopeGuard guard(symbolTable, func);
 
     for (auto& arg : func->args) {
@@ -97,18 +265,207 @@ void SemanticAnalyzer::AnalyzeFuncDeclStatement(FuncDeclStmtSP func) {
         });
 
         if (!success) {
-            AddError(fmt::format("Argument '{}' shadows already existing name.", arg.name.identName), func->line);
+            Report(DiagID::ArgumentShadows, func->line, arg.name.identName);
             return;
         }
     }
 
     AnalyzeStatement(func->body);
+
+    if (!IsVoidType(func->returnType) && !AlwaysReturns(func->body)) {
+        Report(DiagID::MissingReturn, func->line, func->name.identName, TypeName(func->returnType));
+    }
 }
 
 void SemanticAnalyzer::AnalyzeReturnStatement(ReturnStmtSP ret) {
-    (void) ret;
+    auto func = symbolTable.GetCurrentFunction();
+    if (!func) {
+        Report(DiagID::ReturnOutsideFunction, ret->line);
+        return;
+    }
+
+    if (!ret->value) {
+        if (!IsVoidType(func->returnType)) {
+            Report(DiagID::MissingReturn, ret->line, func->name.identName, TypeName(func->returnType));
+        }
+        return;
+    }
+
+    // A returned call needs nothing from the caller's frame afterwards, so it can replace it.
+    if (auto call = InstanceOf<CallExpr>(ret->value)) call->isTailCall = true;
+
+    auto type = AnalyzeExpression(ret->value);
+    if (!type) return;
+
+    if (IsVoidType(func->returnType)) {
+        Report(DiagID::ReturnFromVoid, ret->line, func->name.identName);
+        return;
+    }
+    if (!CoerceExpression(ret->value, func->returnType)) {
+        Report(DiagID::ReturnTypeMismatch, ret->line, TypeName(type), func->name.identName, TypeName(func->returnType));
+    }
 }
 
 void SemanticAnalyzer::AnalyzeBlockStatement(BlockStmtSP block) {
-    (void) block;
-}
\ No newline at end of file
+    RAIIScopeGuard guard(symbolTable);
+    for (auto& stmt : block->body) {
+        AnalyzeStatement(stmt);
+    }
+}
+
+TypeSP SemanticAnalyzer::AnalyzeExpression(ExprSP expr) {
+    TypeSP type;
+
+    if (auto p = InstanceOf<LiteralExpr>(expr)) {
+        type = AnalyzeLiteralExpression(p);
+    }
+    else if (auto p = InstanceOf<IdentifierExpr>(expr)) {
+        type = AnalyzeIdentifierExpression(p);
+    }
+    else if (auto p = InstanceOf<ParenExpr>(expr)) {
+        type = AnalyzeExpression(p->subExpr);
+    }
+    else if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+        type = AnalyzeExpression(p->subExpr);
+    }
+    else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+        type = AnalyzeUnaryExpression(p);
+    }
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        type = AnalyzeBinaryExpression(p);
+    }
+    else if (auto p = InstanceOf<CallExpr>(expr)) {
+        type = AnalyzeCallExpression(p);
+    }
+    else {
+        Report(DiagID::UnsupportedExpression, expr->line);
+    }
+
+    expr->exprType = type;
+    return type;
+}
+
+TypeSP SemanticAnalyzer::AnalyzeLiteralExpression(LiteralSP lit) {
+    static const TypeSP IntLiteralType = MakeBuiltinType("i64");
+    static const TypeSP DoubleLiteralType = MakeBuiltinType("f64");
+
+    switch (lit->value.type) {
+        case TokenType::IntLiteral: return IntLiteralType;
+        case TokenType::DoubleLiteral: return DoubleLiteralType;
+        default:
+            Report(DiagID::StringLiteral, lit->line);
+            return nullptr;
+    }
+}
+
+TypeSP SemanticAnalyzer::AnalyzeIdentifierExpression(IdentifierSP ident) {
+    auto sym = symbolTable.GetSymbol(ident->value.identName);
+    if (!sym) {
+        Report(DiagID::UndefinedIdentifier, ident->line, ident->value.identName);
+        return nullptr;
+    }
+    if (auto var = std::get_if<VariableSymbol>(&sym->symbol)) {
+        return var->type;
+    }
+    Report(DiagID::FunctionAsValue, ident->line, ident->value.identName);
+    return nullptr;
+}
+
+TypeSP SemanticAnalyzer::AnalyzeUnaryExpression(UnarySP unary) {
+    auto type = AnalyzeExpression(unary->subExpr);
+    if (!type) return nullptr;
+
+    if (!unary->op.Check({TokenType::Plus, TokenType::Minus})) {
+        Report(DiagID::UnsupportedUnary, unary->line, magic_enum::enum_name(unary->op.type));
+        return nullptr;
+    }
+    if (!IsNumericType(type)) {
+        Report(DiagID::NonNumericUnary, unary->line, magic_enum::enum_name(unary->op.type), TypeName(type));
+        return nullptr;
+    }
+    return type;
+}
+
+TypeSP SemanticAnalyzer::AnalyzeBinaryExpression(BinarySP binary) {
+    auto ltype = AnalyzeExpression(binary->left);
+    auto rtype = AnalyzeExpression(binary->right);
+    if (!ltype || !rtype) return nullptr;
+
+    if (!IsNumericType(ltype) || !IsNumericType(rtype)) {
+        Report(DiagID::NonNumericBinary, binary->line, magic_enum::enum_name(binary->op.type), TypeName(ltype), TypeName(rtype));
+        return nullptr;
+    }
+
+    if (IsSameType(ltype, rtype)) return ltype;
+    if (CoerceExpression(binary->right, ltype)) return ltype;
+    if (CoerceExpression(binary->left, rtype)) return rtype;
+
+    Report(DiagID::MismatchedOperands, binary->line, TypeName(ltype), TypeName(rtype), magic_enum::enum_name(binary->op.type));
+    return nullptr;
+}
+
+TypeSP SemanticAnalyzer::AnalyzeCallExpression(CallSP call) {
+    auto ident = InstanceOf<IdentifierExpr>(call->callee);
+    if (!ident) {
+        Report(DiagID::UnnamedCall, call->line);
+        return nullptr;
+    }
+
+    const auto& name = ident->value.identName;
+    auto sym = symbolTable.GetSymbol(name);
+    if (!sym) {
+        Report(DiagID::UndefinedFunction, call->line, name);
+        return nullptr;
+    }
+
+    auto fsym = std::get_if<FunctionSymbol>(&sym->symbol);
+    if (!fsym) {
+        Report(DiagID::NotAFunction, call->line, name);
+        return nullptr;
+    }
+
+    if (call->args.size() != fsym->argTypes.size()) {
+        Report(DiagID::ArgumentCount, call->line, name, fsym->argTypes.size(), call->args.size());
+        return nullptr;
+    }
+
+    auto current = symbolTable.GetCurrentFunction();
+    if (current && current->name.identName == name && !call->isTailCall) {
+        Report(DiagID::NonTailRecursion, call->line, name);
+    }
+
+    for (size_t i = 0; i < call->args.size(); i++) {
+        auto type = AnalyzeExpression(call->args[i]);
+        if (!type) continue;
+
+        if (!CoerceExpression(call->args[i], fsym->argTypes[i])) {
+            Report(DiagID::ArgumentTypeMismatch, call->line, i + 1, name, TypeName(type), TypeName(fsym->argTypes[i]));
+        }
+    }
+
+    return fsym->returnType;
+}
+
+bool SemanticAnalyzer::CoerceExpression(const ExprSP& expr, const TypeSP& target) {
+    if (IsSameType(expr->exprType, target)) return true;
+    if (!IsNumericType(target)) return false;
+
+    auto value = ConstantFolder::Evaluate(expr);
+    if (!value) return false;
+
+    if (std::holds_alternative<double>(*value)) {
+        if (!IsFloatType(target)) return false;
+    }
+    else if (IsFloatType(target)) {
+        // Integer arithmetic folds differently from float arithmetic, so only a plain literal may become a float.
+        auto lit = InstanceOf<LiteralExpr>(expr);
+        auto unary = InstanceOf<UnaryExpr>(expr);
+        if (!lit && !(unary && InstanceOf<LiteralExpr>(unary->subExpr))) return false;
+    }
+    else if (!FitsIntegerType(expr, *GetIntegerTypeInfo(target))) {
+        return false;
+    }
+
+    SetConstantType(expr, target);
+    return true;
+}
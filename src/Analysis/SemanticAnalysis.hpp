@@ -1,10 +1,15 @@
 #pragma once
+#include "Analysis/CallGraph.hpp"
+#include "Analysis/ComptimeEvaluation.hpp"
 #include "Parsing/Statement.hpp"
 #include <Parsing/ASTNode.hpp>
 #include <string_view>
 #include <vector>
 #include <Analysis/SymbolTable.hpp>
 #include <Common/ErrorInfo.hpp>
+#include <Utils/Diagnostics.hpp>
+#include <optional>
+#include <string>
 
 namespace pl {
 
@@ -13,30 +18,68 @@ namespace pl {
             std::vector<FileSourceNodeSP> files;
 
         public:
-            SemanticAnalyzer(const std::vector<FileSourceNodeSP>& files, std::string_view moduleName);
+            // Analysis stops early once the error limit of the settings is reached.
+            SemanticAnalyzer(const std::vector<FileSourceNodeSP>& files, std::string_view moduleName, const DiagnosticsSettings& diagnosticsSettings = {});
             //~SemanticAnalyzer();
 
+            // Limits for evaluating 'comptime' code, which Analyze does once the program is known to be valid.
+            void SetComptimeLimits(const ComptimeLimits& limits) { comptimeLimits = limits; }
+
             void Analyze();
 
-            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
-            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            // Analyses one function against the global symbols, as Analyze does, but without evaluating 'comptime'
+            // code. Its diagnostics are added to those of the analyzer. The language server uses this to re-analyse
+            // only the functions an edit may have affected.
+            void AnalyzeFunction(const FuncDeclStmtSP& func, std::string_view filename);
+
+            // Drops the diagnostics found so far, e.g. before analysing functions again.
+            void ClearDiagnostics() { diagnostics.Clear(); }
+
+            [[nodiscard]] const DiagnosticsEngine& GetDiagnostics() const { return diagnostics; }
+            [[nodiscard]] DiagnosticsEngine& GetDiagnostics() { return diagnostics; }
+            // Formatted on each call.
+            [[nodiscard]] std::vector<ErrorInfo> GetErrors() const { return diagnostics.GetErrors(); }
+            [[nodiscard]] bool HadErrors() const { return diagnostics.HadErrors(); }
+            [[nodiscard]] std::vector<ErrorInfo> GetWarnings() const { return diagnostics.GetWarnings(); }
+            [[nodiscard]] const SymbolTable& GetSymbolTable() const { return symbolTable; }
 
 
         private:
             SymbolTable symbolTable;
+            ComptimeLimits comptimeLimits;
 
-            std::vector<ErrorInfo> errors;
+            DiagnosticsEngine diagnostics;
+            std::optional<std::string> contextFile;     // The file 'context' was interned for.
+            uint32_t context = 0;
 
-            void AddError(std::string_view msg, int line);
+            template <class... Args>
+            void Report(DiagID id, int line, const Args&... args) {
+                diagnostics.Report(id, GetContext(), line, args...);
+            }
+            uint32_t GetContext();
 
             void PopulateGlobalSymbols(const std::vector<FileSourceNodeSP>& files);
 
             void AnalyzeFile(FileSourceNodeSP file);
+            void EvaluateComptime();
+            // Warns about calls within mutually recursive functions that need a stack frame per level.
+            void CheckRecursiveCalls(const CallGraph& graph);
             void AnalyzeStatement(StmtSP stmt);
 
             void AnalyzeExprStatement(ExprStmtSP exsp);
             void AnalyzeFuncDeclStatement(FuncDeclStmtSP func);
             void AnalyzeReturnStatement(ReturnStmtSP ret);
             void AnalyzeBlockStatement(BlockStmtSP block);
+
+            TypeSP AnalyzeExpression(ExprSP expr);
+
+            TypeSP AnalyzeLiteralExpression(LiteralSP lit);
+            TypeSP AnalyzeIdentifierExpression(IdentifierSP ident);
+            TypeSP AnalyzeUnaryExpression(UnarySP unary);
+            TypeSP AnalyzeBinaryExpression(BinarySP binary);
+            TypeSP AnalyzeCallExpression(CallSP call);
+
+            // Gives an untyped constant expression (e.g. an integer literal) the target type, if it can represent it.
+            bool CoerceExpression(const ExprSP& expr, const TypeSP& target);
     };
 }
@@ -1,5 +1,6 @@
 #include "SymbolTable.hpp"
 #include <optional>
+#include <string>
 #include <string_view>
 
 using namespace pl;
@@ -13,22 +14,24 @@ bool SymbolTable::Insert(std::string_view name, const Symbol& symbol) {
     if (HasSymbolDefined(name)) return false;
 
     scopes.back().scopeIdentifiers.insert(std::pair {name, symbol});
+    insertedSymbols++;
 
     return true;
 }
 
 bool SymbolTable::HasSymbolDefined(std::string_view name) {
+    const std::string key(name);
     for (const auto& entry : scopes) {
-        if (entry.scopeIdentifiers.contains(std::string(name))) return true;
+        if (entry.scopeIdentifiers.contains(key)) return true;
     }
     return false;
 }
 
 std::optional<Symbol> SymbolTable::GetSymbol(std::string_view name) const {
+    const std::string key(name);
     for (const auto& scope : scopes) {
-        for (auto& [key, val] : scope.scopeIdentifiers) {
-            if (key == name) return val;
-        }
+        auto it = scope.scopeIdentifiers.find(key);
+        if (it != scope.scopeIdentifiers.end()) return it->second;
     }
 
     return std::nullopt;
@@ -48,6 +51,7 @@ std::string SymbolTable::GetFileName() const {
 
 void SymbolTable::CreateScope() {
     scopes.emplace_back();
+    createdScopes++;
 }
 
 void SymbolTable::DropScope() {
@@ -58,6 +62,11 @@ bool SymbolTable::IsOnModuleScope() const {
     return !scopes.back().scopeName.empty();
 }
 
+FuncDeclStmtSP SymbolTable::GetCurrentFunction() const {
+    if (functionStack.empty()) return nullptr;
+    return functionStack.top();
+}
+
 SymbolTable::FilenameGuard SymbolTable::GetFileGuard(std::string_view filename) {
     return SymbolTable::FilenameGuard { *this, filename };
 }
\ No newline at end of file
@@ -51,6 +51,10 @@ namespace pl {
             std::vector<SymbolTableEntry> scopes;
             std::string currentFilename = "";
 
+            // Totals over the table's lifetime, for --stats.
+            size_t insertedSymbols = 0;
+            size_t createdScopes = 1;
+
         public:
             struct FilenameGuard {
                 FilenameGuard() = delete;
@@ -82,8 +86,12 @@ namespace pl {
             void DropScope();
 
             bool IsOnModuleScope() const;
+            FuncDeclStmtSP GetCurrentFunction() const;
 
             FilenameGuard GetFileGuard(std::string_view filename);
+
+            [[nodiscard]] size_t GetInsertedSymbolCount() const { return insertedSymbols; }
+            [[nodiscard]] size_t GetCreatedScopeCount() const { return createdScopes; }
     };
 
     struct RAIIScopeGuard {
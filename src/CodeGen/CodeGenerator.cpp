@@ -0,0 +1,340 @@
+#include "CodeGenerator.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "fmt/core.h"
+#include <Utils/Utils.hpp>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace pl;
+
+CodeGenerator::CodeGenerator(llvm::LLVMContext& context, std::string_view moduleName)
+    : context(context),
+      module(std::make_unique<llvm::Module>(moduleName, context)),
+      builder(context)
+    { }
+
+std::unique_ptr<llvm::Module> CodeGenerator::Generate(const std::vector<FileSourceNodeSP>& files) {
+    llvm::TimeTraceScope timeScope("CodeGen");
+    // Declare everything first so calls may reference functions defined later or in other files.
+    for (const auto& file : files) {
+        currentFilename = file->filename;
+        for (const auto& stmt : file->statements) {
+            if (auto p = InstanceOf<FuncDeclStmt>(stmt)) DeclareFunction(p);
+        }
+    }
+
+    for (const auto& file : files) {
+        currentFilename = file->filename;
+        for (const auto& stmt : file->statements) {
+            GenerateStatement(stmt);
+        }
+    }
+
+    GenerateEntryPoint();
+
+    if (emitThunks) {
+        for (const auto& file : files) {
+            for (const auto& stmt : file->statements) {
+                auto p = InstanceOf<FuncDeclStmt>(stmt);
+                if (p && p->body) GenerateThunk(p);
+            }
+        }
+    }
+
+    std::string verifierOutput;
+    llvm::raw_string_ostream verifierStream(verifierOutput);
+    if (llvm::verifyModule(*module, &verifierStream)) {
+        AddError(fmt::format("Generated module is invalid:\n{}", verifierStream.str()), 0);
+        return nullptr;
+    }
+
+    return std::move(module);
+}
+
+std::string CodeGenerator::ThunkName(std::string_view function) {
+    return fmt::format("fracta.thunk.{}", function);
+}
+
+void CodeGenerator::AddError(std::string_view msg, int line) {
+    errors.push_back({
+        fmt::format("{}:{}", module->getName().str(), currentFilename),
+        std::string(msg),
+        line
+    });
+}
+
+llvm::Type* CodeGenerator::LowerType(const TypeSP& type) {
+    if (auto info = GetIntegerTypeInfo(type)) {
+        return builder.getIntNTy(info->bits);
+    }
+    if (IsVoidType(type)) return builder.getVoidTy();
+
+    auto name = TypeName(type);
+    if (name == "f32") return builder.getFloatTy();
+    if (name == "f64") return builder.getDoubleTy();
+
+    AddError(fmt::format("Cannot lower type '{}'.", name), 0);
+    return builder.getVoidTy();
+}
+
+llvm::Function* CodeGenerator::DeclareFunction(const FuncDeclStmtSP& func) {
+    std::vector<llvm::Type*> argTypes;
+    for (auto& arg : func->args) {
+        argTypes.push_back(LowerType(arg.type));
+    }
+
+    auto fnType = llvm::FunctionType::get(LowerType(func->returnType), argTypes, false);
+    auto fn = llvm::Function::Create(fnType, llvm::Function::ExternalLinkage, func->name.identName, module.get());
+
+    for (size_t i = 0; i < func->args.size(); i++) {
+        fn->getArg(i)->setName(func->args[i].name.identName);
+    }
+
+    // Lets LLVM hoist, merge and delete calls it would otherwise have to keep.
+    const auto& effects = func->effects;
+    if (effects.memory == MemoryEffect::None) fn->setDoesNotAccessMemory();
+    else if (effects.memory == MemoryEffect::Read) fn->setOnlyReadsMemory();
+    if (!effects.mayUnwind) fn->setDoesNotThrow();
+    if (!effects.mayDiverge) fn->addFnAttr(llvm::Attribute::WillReturn);
+
+    return fn;
+}
+
+void CodeGenerator::GenerateEntryPoint() {
+    // Programs defining 'func Main() <int>' get a C entry point so the object file links into an executable.
+    auto fracMain = module->getFunction("Main");
+    if (!fracMain || fracMain->isDeclaration() || fracMain->arg_size() != 0) return;
+    if (module->getFunction("main")) return;
+
+    auto retType = fracMain->getReturnType();
+    if (!retType->isIntegerTy() && !retType->isVoidTy()) return;
+
+    auto entryType = llvm::FunctionType::get(builder.getInt32Ty(), false);
+    auto entry = llvm::Function::Create(entryType, llvm::Function::ExternalLinkage, "main", module.get());
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry));
+
+    auto result = builder.CreateCall(fracMain);
+    if (retType->isVoidTy()) {
+        builder.CreateRet(builder.getInt32(0));
+    }
+    else {
+        builder.CreateRet(builder.CreateSExtOrTrunc(result, builder.getInt32Ty()));
+    }
+}
+
+void CodeGenerator::GenerateThunk(const FuncDeclStmtSP& func) {
+    auto fn = module->getFunction(func->name.identName);
+    auto i64 = builder.getInt64Ty();
+    auto ptr = builder.getPtrTy();
+
+    auto thunkType = llvm::FunctionType::get(builder.getVoidTy(), {ptr, ptr}, false);
+    auto thunk = llvm::Function::Create(thunkType, llvm::Function::ExternalLinkage, ThunkName(func->name.identName), module.get());
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", thunk));
+
+    // Integers arrive sign- or zero-extended to 64 bits and floats as the bits of a double.
+    std::vector<llvm::Value*> args;
+    for (size_t i = 0; i < func->args.size(); i++) {
+        auto slot = builder.CreateConstInBoundsGEP1_64(i64, thunk->getArg(0), i);
+        llvm::Value* raw = builder.CreateLoad(i64, slot);
+        auto type = fn->getArg(i)->getType();
+
+        if (type->isFloatingPointTy()) {
+            raw = builder.CreateBitCast(raw, builder.getDoubleTy());
+            args.push_back(builder.CreateFPTrunc(raw, type));
+        }
+        else {
+            args.push_back(builder.CreateTrunc(raw, type));
+        }
+    }
+
+    llvm::Value* result = builder.CreateCall(fn, args);
+    auto retType = fn->getReturnType();
+
+    if (!retType->isVoidTy()) {
+        if (retType->isFloatingPointTy()) {
+            result = builder.CreateBitCast(builder.CreateFPExt(result, builder.getDoubleTy()), i64);
+        }
+        else if (GetIntegerTypeInfo(func->returnType).value_or(IntegerTypeInfo {64, true}).isSigned) {
+            result = builder.CreateSExt(result, i64);
+        }
+        else {
+            result = builder.CreateZExt(result, i64);
+        }
+        builder.CreateStore(result, thunk->getArg(1));
+    }
+
+    builder.CreateRetVoid();
+    builder.ClearInsertionPoint();
+}
+
+void CodeGenerator::GenerateStatement(const StmtSP& stmt) {
+    if (!stmt) return;
+
+    // Statements following a return are unreachable and must not be appended to a terminated block.
+    auto insertBlock = builder.GetInsertBlock();
+    if (insertBlock && insertBlock->getTerminator()) return;
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) {
+        GenerateExpression(p->expr);
+    }
+    else if (auto p = InstanceOf<FuncDeclStmt>(stmt)) {
+        GenerateFuncDecl(p);
+    }
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+        GenerateReturn(p);
+    }
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        GenerateBlock(p);
+    }
+    else {
+        AddError("Unsupported statement type.", stmt->line);
+    }
+}
+
+void CodeGenerator::GenerateFuncDecl(const FuncDeclStmtSP& func) {
+    llvm::TimeTraceScope timeScope("CodeGen Function", func->name.identName);
+    if (!func->body) return;
+
+    auto fn = module->getFunction(func->name.identName);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", fn));
+
+    namedValues.clear();
+    for (auto& arg : fn->args()) {
+        namedValues[arg.getName().str()] = &arg;
+    }
+
+    GenerateStatement(func->body);
+
+    if (!builder.GetInsertBlock()->getTerminator()) {
+        if (fn->getReturnType()->isVoidTy()) builder.CreateRetVoid();
+        else builder.CreateUnreachable();
+    }
+
+    builder.ClearInsertionPoint();
+}
+
+void CodeGenerator::GenerateReturn(const ReturnStmtSP& ret) {
+    if (!ret->value) {
+        builder.CreateRetVoid();
+        return;
+    }
+    builder.CreateRet(GenerateExpression(ret->value));
+}
+
+void CodeGenerator::GenerateBlock(const BlockStmtSP& block) {
+    for (auto& stmt : block->body) {
+        GenerateStatement(stmt);
+    }
+}
+
+llvm::Value* CodeGenerator::GenerateExpression(const ExprSP& expr) {
+    if (auto p = InstanceOf<LiteralExpr>(expr)) return GenerateLiteral(p);
+    if (auto p = InstanceOf<IdentifierExpr>(expr)) return GenerateIdentifier(p);
+    if (auto p = InstanceOf<ParenExpr>(expr)) return GenerateExpression(p->subExpr);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) return GenerateUnary(p);
+    if (auto p = InstanceOf<BinaryExpr>(expr)) return GenerateBinary(p);
+    if (auto p = InstanceOf<CallExpr>(expr)) return GenerateCall(p);
+
+    AddError("Unsupported expression type.", expr->line);
+    return llvm::PoisonValue::get(builder.getInt64Ty());
+}
+
+llvm::Value* CodeGenerator::GenerateLiteral(const LiteralSP& lit) {
+    auto type = LowerType(lit->exprType);
+
+    if (lit->value.type == TokenType::IntLiteral) {
+        auto value = std::get<int64_t>(lit->value.literalValue);
+        if (type->isFloatingPointTy()) return llvm::ConstantFP::get(type, static_cast<double>(value));
+        return llvm::ConstantInt::get(type, static_cast<uint64_t>(value), true);
+    }
+    if (lit->value.type == TokenType::DoubleLiteral) {
+        return llvm::ConstantFP::get(type, std::get<double>(lit->value.literalValue));
+    }
+
+    AddError("Unsupported literal type.", lit->line);
+    return llvm::PoisonValue::get(type);
+}
+
+llvm::Value* CodeGenerator::GenerateIdentifier(const IdentifierSP& ident) {
+    auto it = namedValues.find(ident->value.identName);
+    if (it == namedValues.end()) {
+        AddError(fmt::format("Unknown value '{}'.", ident->value.identName), ident->line);
+        return llvm::PoisonValue::get(LowerType(ident->exprType));
+    }
+    return it->second;
+}
+
+llvm::Value* CodeGenerator::GenerateUnary(const UnarySP& unary) {
+    auto operand = GenerateExpression(unary->subExpr);
+
+    switch (unary->op.type) {
+        case TokenType::Plus:
+            return operand;
+        case TokenType::Minus:
+            if (IsFloatType(unary->exprType)) return builder.CreateFNeg(operand);
+            return builder.CreateNeg(operand);
+        default:
+            AddError("Unsupported unary operator.", unary->line);
+            return operand;
+    }
+}
+
+llvm::Value* CodeGenerator::GenerateBinary(const BinarySP& binary) {
+    auto lhs = GenerateExpression(binary->left);
+    auto rhs = GenerateExpression(binary->right);
+
+    if (IsFloatType(binary->exprType)) {
+        switch (binary->op.type) {
+            case TokenType::Plus: return builder.CreateFAdd(lhs, rhs);
+            case TokenType::Minus: return builder.CreateFSub(lhs, rhs);
+            case TokenType::Star: return builder.CreateFMul(lhs, rhs);
+            case TokenType::Slash: return builder.CreateFDiv(lhs, rhs);
+            case TokenType::Mod: return builder.CreateFRem(lhs, rhs);
+            default: break;
+        }
+    }
+    else {
+        const bool isSigned = GetIntegerTypeInfo(binary->exprType).value_or(IntegerTypeInfo {64, true}).isSigned;
+
+        // Integer arithmetic wraps around, matching the constant folder.
+        switch (binary->op.type) {
+            case TokenType::Plus: return builder.CreateAdd(lhs, rhs);
+            case TokenType::Minus: return builder.CreateSub(lhs, rhs);
+            case TokenType::Star: return builder.CreateMul(lhs, rhs);
+            case TokenType::Slash: return isSigned ? builder.CreateSDiv(lhs, rhs) : builder.CreateUDiv(lhs, rhs);
+            case TokenType::Mod: return isSigned ? builder.CreateSRem(lhs, rhs) : builder.CreateURem(lhs, rhs);
+            default: break;
+        }
+    }
+
+    AddError("Unsupported binary operator.", binary->line);
+    return lhs;
+}
+
+llvm::Value* CodeGenerator::GenerateCall(const CallSP& call) {
+    auto ident = InstanceOf<IdentifierExpr>(call->callee);
+    auto fn = ident ? module->getFunction(ident->value.identName) : nullptr;
+
+    if (!fn) {
+        AddError("Call to unknown function.", call->line);
+        return llvm::PoisonValue::get(LowerType(call->exprType));
+    }
+
+    std::vector<llvm::Value*> args;
+    for (auto& arg : call->args) {
+        args.push_back(GenerateExpression(arg));
+    }
+
+    auto inst = builder.CreateCall(fn, args);
+    if (call->isTailCall) {
+        // musttail guarantees the caller's frame is reused, but only when both prototypes match. Semantic analysis
+        // warns about recursion through calls where they do not.
+        auto caller = builder.GetInsertBlock()->getParent();
+        inst->setTailCallKind(caller->getFunctionType() == fn->getFunctionType() ? llvm::CallInst::TCK_MustTail : llvm::CallInst::TCK_Tail);
+    }
+    return inst;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Parsing/Statement.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pl {
+    class CodeGenerator {
+        private:
+            llvm::LLVMContext& context;
+            std::unique_ptr<llvm::Module> module;
+            llvm::IRBuilder<> builder;
+
+            std::unordered_map<std::string, llvm::Value*> namedValues;
+            std::string currentFilename;
+            std::vector<ErrorInfo> errors;
+
+            bool emitThunks = false;
+
+        public:
+            CodeGenerator(llvm::LLVMContext& context, std::string_view moduleName);
+
+            // Lowers analysed files into a new module. Returns nullptr if the module failed verification.
+            std::unique_ptr<llvm::Module> Generate(const std::vector<FileSourceNodeSP>& files);
+
+            // Also emits 'void <thunk>(const u64* args, u64* result)' for every defined function, giving the
+            // interpreter one signature to call promoted functions through.
+            void SetEmitThunks(bool enable) { emitThunks = enable; }
+            static std::string ThunkName(std::string_view function);
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            void AddError(std::string_view msg, int line);
+
+            llvm::Type* LowerType(const TypeSP& type);
+            llvm::Function* DeclareFunction(const FuncDeclStmtSP& func);
+            void GenerateEntryPoint();
+            void GenerateThunk(const FuncDeclStmtSP& func);
+
+            void GenerateStatement(const StmtSP& stmt);
+            void GenerateFuncDecl(const FuncDeclStmtSP& func);
+            void GenerateReturn(const ReturnStmtSP& ret);
+            void GenerateBlock(const BlockStmtSP& block);
+
+            llvm::Value* GenerateExpression(const ExprSP& expr);
+            llvm::Value* GenerateLiteral(const LiteralSP& lit);
+            llvm::Value* GenerateIdentifier(const IdentifierSP& ident);
+            llvm::Value* GenerateUnary(const UnarySP& unary);
+            llvm::Value* GenerateBinary(const BinarySP& binary);
+            llvm::Value* GenerateCall(const CallSP& call);
+    };
+}
@@ -0,0 +1,134 @@
+#include "HotReload.hpp"
+#include "fmt/core.h"
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+
+using namespace pl;
+
+static std::string VersionedName(std::string_view function, unsigned generation) {
+    return fmt::format("{}.v{}", function, generation);
+}
+
+HotReloadEngine::HotReloadEngine(const JITSettings& settings) : engine(settings) {
+    auto jit = engine.GetJIT();
+    if (!jit) return;
+
+    // Unsupported targets are reported by Load.
+    auto stubsBuilder = llvm::orc::createLocalIndirectStubsManagerBuilder(jit->getTargetTriple());
+    if (stubsBuilder) stubs = stubsBuilder();
+}
+
+std::vector<std::string> HotReloadEngine::Load(llvm::orc::ThreadSafeModule module) {
+    errors.clear();
+    const auto firstEngineError = engine.GetErrors().size();
+
+    auto jit = engine.GetJIT();
+    if (!jit) {
+        Fail(0);
+        return {};
+    }
+    if (!stubs) {
+        AddError(fmt::format("Indirect stubs are not supported on '{}'.", jit->getTargetTriple().str()));
+        return {};
+    }
+
+    const auto version = generation++;
+    auto dylib = jit->createJITDylib(fmt::format("fracta.reload.{}", version));
+    if (!dylib) {
+        AddError(llvm::toString(dylib.takeError()));
+        return {};
+    }
+    dylib->addToLinkOrder(jit->getMainJITDylib());
+
+    // Each definition moves to a versioned name, and every call to it, including recursive ones, goes to a
+    // declaration under the original name that resolves to the stub. The declaration carries no inferred
+    // attributes, as the stub may later lead to code with different effects.
+    std::vector<std::string> loaded;
+    module.withModuleDo([&](llvm::Module& m) {
+        if (auto entry = m.getFunction("main")) entry->eraseFromParent();
+
+        std::vector<llvm::Function*> definitions;
+        for (auto& fn : m) {
+            if (!fn.isDeclaration()) definitions.push_back(&fn);
+        }
+
+        for (auto fn : definitions) {
+            const auto name = fn->getName().str();
+            fn->setName(VersionedName(name, version));
+            auto stubCall = llvm::Function::Create(fn->getFunctionType(), llvm::Function::ExternalLinkage, name, m);
+            fn->replaceAllUsesWith(stubCall);
+            loaded.push_back(name);
+        }
+    });
+
+    // Stubs of new functions are defined before compiling, as the module's own calls resolve through them.
+    // They stay null until the load succeeds.
+    llvm::orc::SymbolMap newStubs;
+    for (const auto& name : loaded) {
+        if (stubbedFunctions.contains(name)) continue;
+        if (auto err = stubs->createStub(name, llvm::orc::ExecutorAddr(), llvm::JITSymbolFlags::Exported)) {
+            AddError(llvm::toString(std::move(err)));
+            return {};
+        }
+        newStubs[jit->mangleAndIntern(name)] = stubs->findStub(name, true);
+        stubbedFunctions.insert(name);
+    }
+    if (!newStubs.empty()) {
+        if (auto err = jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(newStubs)))) {
+            AddError(llvm::toString(std::move(err)));
+            return {};
+        }
+    }
+
+    if (!engine.AddModule(std::move(module), &*dylib)) {
+        Fail(firstEngineError);
+        return {};
+    }
+
+    // Everything is compiled before the first stub moves, so a failed load leaves the program unchanged.
+    std::vector<void*> addresses;
+    for (const auto& name : loaded) {
+        auto address = engine.Lookup(VersionedName(name, version), &*dylib);
+        if (!address) {
+            Fail(firstEngineError);
+            return {};
+        }
+        addresses.push_back(address);
+    }
+
+    for (size_t i = 0; i < loaded.size(); i++) {
+        if (auto err = stubs->updatePointer(loaded[i], llvm::orc::ExecutorAddr::fromPtr(addresses[i]))) {
+            AddError(llvm::toString(std::move(err)));
+            continue;
+        }
+        loadedFunctions.insert(loaded[i]);
+    }
+    return loaded;
+}
+
+void* HotReloadEngine::Lookup(std::string_view name) {
+    errors.clear();
+    if (!loadedFunctions.contains(std::string(name))) {
+        AddError(fmt::format("Function '{}' has not been loaded.", name));
+        return nullptr;
+    }
+
+    const auto firstEngineError = engine.GetErrors().size();
+    auto address = engine.Lookup(name);
+    if (!address) Fail(firstEngineError);
+    return address;
+}
+
+void HotReloadEngine::Fail(size_t firstEngineError) {
+    const auto& engineErrors = engine.GetErrors();
+    errors.insert(errors.end(), engineErrors.begin() + static_cast<std::ptrdiff_t>(firstEngineError), engineErrors.end());
+}
+
+void HotReloadEngine::AddError(std::string_view msg) {
+    errors.push_back({
+        "HotReload",
+        std::string(msg),
+        0
+    });
+}
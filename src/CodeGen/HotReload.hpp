@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CodeGen/JITEngine.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace pl {
+    // JIT execution in which every function is called through an ORC indirect stub, so a function can be
+    // replaced while the program runs. Calls already executing finish in the old code; every call made after
+    // the stub was updated runs the new one.
+    class HotReloadEngine {
+        private:
+            JITEngine engine;
+            std::unique_ptr<llvm::orc::IndirectStubsManager> stubs;
+            std::unordered_set<std::string> stubbedFunctions;
+            std::unordered_set<std::string> loadedFunctions;   // Stubs that point at code.
+            unsigned generation = 0;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            explicit HotReloadEngine(const JITSettings& settings);
+
+            // Compiles the functions defined in the module into a new JITDylib and points their stubs at them.
+            // Declared-only functions resolve to the stubs of earlier loads. Returns the functions loaded.
+            std::vector<std::string> Load(llvm::orc::ThreadSafeModule module);
+
+            // The stub of a loaded function, which always runs its latest version.
+            void* Lookup(std::string_view name);
+
+            // Errors of the last call.
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            // Takes over the engine's errors from the given index on.
+            void Fail(size_t firstEngineError);
+            void AddError(std::string_view msg);
+    };
+}
@@ -0,0 +1,142 @@
+#include "JITEngine.hpp"
+#include "CodeGen/ModuleEmitter.hpp"
+#include "fmt/core.h"
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Support/Error.h>
+#include <cstdint>
+#include <string>
+
+using namespace pl;
+
+JITEngine::JITEngine(const JITSettings& settings) : settings(settings) {
+    InitializeNativeTargets();
+
+    auto jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmb) {
+        AddError(llvm::toString(jtmb.takeError()));
+        return;
+    }
+    jtmb->setCodeGenOptLevel(ToCodeGenOptLevel(settings.optLevel));
+
+    auto tm = jtmb->createTargetMachine();
+    if (!tm) {
+        AddError(llvm::toString(tm.takeError()));
+        return;
+    }
+    targetMachine = std::move(*tm);
+
+    if (settings.objectCache) {
+        objectCache = std::make_unique<DiskObjectCache>(*settings.objectCache, *targetMachine, settings.optLevel);
+    }
+
+    auto compilerCreator = [cache = objectCache.get()](llvm::orc::JITTargetMachineBuilder builder)
+        -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(builder), cache);
+    };
+
+    if (settings.perfSupport || settings.recordSymbols) {
+        symbolRegistry = std::make_unique<JITSymbolRegistry>(settings.perfSupport);
+        if (settings.perfSupport) perfListener = llvm::JITEventListener::createPerfJITEventListener();
+    }
+
+    // Event listeners are only notified by the RuntimeDyld layer, so it replaces the default linker when needed.
+    auto objectLayerCreator = [this](llvm::orc::ExecutionSession& session, const llvm::Triple&)
+        -> llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>> {
+        auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(session, [](auto&&...) {
+            return std::make_unique<llvm::SectionMemoryManager>();
+        });
+        layer->registerJITEventListener(*symbolRegistry);
+        if (perfListener) layer->registerJITEventListener(*perfListener);
+        return layer;
+    };
+
+    auto configure = [&](auto& builder) {
+        builder.setJITTargetMachineBuilder(*jtmb);
+        builder.setCompileFunctionCreator(compilerCreator);
+        if (symbolRegistry) builder.setObjectLinkingLayerCreator(objectLayerCreator);
+    };
+
+    if (settings.lazy) {
+        llvm::orc::LLLazyJITBuilder builder;
+        configure(builder);
+        auto created = builder.create();
+        if (!created) {
+            AddError(llvm::toString(created.takeError()));
+            return;
+        }
+        jit = std::move(*created);
+    }
+    else {
+        llvm::orc::LLJITBuilder builder;
+        configure(builder);
+        auto created = builder.create();
+        if (!created) {
+            AddError(llvm::toString(created.takeError()));
+            return;
+        }
+        jit = std::move(*created);
+    }
+
+    // In lazy mode this runs once per extracted function, so optimisation cost follows the code actually executed.
+    jit->getIRTransformLayer().setTransform(
+        [this](llvm::orc::ThreadSafeModule tsm, llvm::orc::MaterializationResponsibility&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+            tsm.withModuleDo([this](llvm::Module& module) {
+                ApplyTargetAttributes(module, *targetMachine);
+
+                OptimizerSettings optimizerSettings;
+                optimizerSettings.level = this->settings.optLevel;
+                ModuleOptimizer(targetMachine.get(), optimizerSettings).Run(module);
+            });
+            return tsm;
+        }
+    );
+}
+
+bool JITEngine::AddModule(llvm::orc::ThreadSafeModule module, llvm::orc::JITDylib* dylib) {
+    if (!jit) return false;
+    auto& target = dylib ? *dylib : jit->getMainJITDylib();
+
+    module.withModuleDo([this](llvm::Module& m) {
+        m.setDataLayout(jit->getDataLayout());
+        m.setTargetTriple(jit->getTargetTriple().str());
+    });
+
+    auto err = settings.lazy
+        ? static_cast<llvm::orc::LLLazyJIT&>(*jit).addLazyIRModule(target, std::move(module))
+        : jit->addIRModule(target, std::move(module));
+
+    if (err) {
+        AddError(llvm::toString(std::move(err)));
+        return false;
+    }
+    return true;
+}
+
+void* JITEngine::Lookup(std::string_view name, llvm::orc::JITDylib* dylib) {
+    if (!jit) return nullptr;
+
+    auto address = jit->lookup(dylib ? *dylib : jit->getMainJITDylib(), name);
+    if (!address) {
+        AddError(llvm::toString(address.takeError()));
+        return nullptr;
+    }
+    return address->toPtr<void*>();
+}
+
+std::optional<int> JITEngine::RunMain() {
+    auto entry = reinterpret_cast<int32_t (*)()>(Lookup("Main"));
+    if (!entry) return std::nullopt;
+    return entry();
+}
+
+void JITEngine::AddError(std::string_view msg) {
+    errors.push_back({
+        "JIT",
+        std::string(msg),
+        0
+    });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CodeGen/JITSymbolRegistry.hpp"
+#include "CodeGen/ObjectCache.hpp"
+#include "CodeGen/Optimizer.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Target/TargetMachine.h>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    struct JITSettings {
+        OptLevel optLevel = OptLevel::O0;
+
+        // Compiles each function on its first call through lazy reexports, instead of the whole module up front.
+        bool lazy = false;
+
+        // Reuses machine code across runs through ORC's object cache interface.
+        std::optional<ObjectCacheSettings> objectCache;
+
+        // Writes /tmp/perf-<pid>.map, and jitdump files when LLVM was built with perf support.
+        bool perfSupport = false;
+        // Records the address range of every compiled function, for attributing profile samples.
+        bool recordSymbols = false;
+    };
+
+    class JITEngine {
+        private:
+            JITSettings settings;
+            std::unique_ptr<llvm::TargetMachine> targetMachine;
+            std::unique_ptr<DiskObjectCache> objectCache;
+            std::unique_ptr<JITSymbolRegistry> symbolRegistry;
+            llvm::JITEventListener* perfListener = nullptr;
+            std::unique_ptr<llvm::orc::LLJIT> jit;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            explicit JITEngine(const JITSettings& settings = {});
+
+            // Adds to the main JITDylib unless another one, created through GetJIT(), is given.
+            bool AddModule(llvm::orc::ThreadSafeModule module, llvm::orc::JITDylib* dylib = nullptr);
+            void* Lookup(std::string_view name, llvm::orc::JITDylib* dylib = nullptr);
+
+            // Runs 'func Main() i32' and returns its result.
+            std::optional<int> RunMain();
+
+            // Null unless perf support or symbol recording was requested.
+            [[nodiscard]] const JITSymbolRegistry* GetSymbolRegistry() const { return symbolRegistry.get(); }
+
+            // Null if the JIT could not be created.
+            [[nodiscard]] llvm::orc::LLJIT* GetJIT() { return jit.get(); }
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            void AddError(std::string_view msg);
+    };
+}
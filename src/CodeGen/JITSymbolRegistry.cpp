@@ -0,0 +1,53 @@
+#include "JITSymbolRegistry.hpp"
+#include "fmt/core.h"
+#include <llvm/ExecutionEngine/RuntimeDyld.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace pl;
+
+JITSymbolRegistry::JITSymbolRegistry(bool writePerfMap) {
+    if (!writePerfMap) return;
+
+    std::error_code ec;
+    perfMap = std::make_unique<llvm::raw_fd_ostream>(fmt::format("/tmp/perf-{}.map", getpid()), ec, llvm::sys::fs::OF_Text);
+    if (ec) perfMap.reset();
+}
+
+void JITSymbolRegistry::notifyObjectLoaded(ObjectKey, const llvm::object::ObjectFile& object, const llvm::RuntimeDyld::LoadedObjectInfo& info) {
+    // The debug object has its symbols relocated to the addresses they were loaded at.
+    auto debugObject = info.getObjectForDebug(object);
+    const auto& loaded = debugObject.getBinary() ? *debugObject.getBinary() : object;
+
+    std::lock_guard lock(mutex);
+    for (const auto& [symbol, size] : llvm::object::computeSymbolSizes(loaded)) {
+        auto type = symbol.getType();
+        if (!type || *type != llvm::object::SymbolRef::ST_Function) {
+            if (!type) llvm::consumeError(type.takeError());
+            continue;
+        }
+
+        auto name = symbol.getName();
+        auto address = symbol.getAddress();
+        if (!name || !address || size == 0) {
+            if (!name) llvm::consumeError(name.takeError());
+            if (!address) llvm::consumeError(address.takeError());
+            continue;
+        }
+
+        functions.push_back({*address, size, name->str()});
+        if (perfMap) *perfMap << fmt::format("{:x} {:x} {}\n", *address, size, name->str());
+    }
+
+    if (perfMap) perfMap->flush();
+}
+
+std::vector<JITFunctionRange> JITSymbolRegistry::GetFunctions() const {
+    std::lock_guard lock(mutex);
+    auto sorted = functions;
+    std::ranges::sort(sorted, {}, &JITFunctionRange::address);
+    return sorted;
+}
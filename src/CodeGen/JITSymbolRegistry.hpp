@@ -0,0 +1,35 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pl {
+    struct JITFunctionRange {
+        uint64_t address = 0;
+        uint64_t size = 0;
+        std::string name;
+    };
+
+    // Records where the JIT placed every function it compiled, and optionally appends them to
+    // /tmp/perf-<pid>.map so 'perf report' can symbolize JIT frames. Lazy compilation notifies from
+    // compile threads while the program runs, so access is synchronised.
+    class JITSymbolRegistry final : public llvm::JITEventListener {
+        private:
+            mutable std::mutex mutex;
+            std::vector<JITFunctionRange> functions;
+            std::unique_ptr<llvm::raw_fd_ostream> perfMap;
+
+        public:
+            explicit JITSymbolRegistry(bool writePerfMap);
+
+            void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object, const llvm::RuntimeDyld::LoadedObjectInfo& info) override;
+
+            // Sorted by address.
+            [[nodiscard]] std::vector<JITFunctionRange> GetFunctions() const;
+    };
+}
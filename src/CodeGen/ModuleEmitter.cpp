@@ -0,0 +1,235 @@
+#include "ModuleEmitter.hpp"
+#include "fmt/core.h"
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/Archive.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <mutex>
+#include <optional>
+
+using namespace pl;
+
+void pl::InitializeNativeTargets() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
+}
+
+void pl::ApplyTargetAttributes(llvm::Module& module, const llvm::TargetMachine& targetMachine) {
+    // Per-function attributes let the optimizer's cost models (e.g. the vectorizers) see the real target.
+    const auto cpu = targetMachine.getTargetCPU();
+    const auto features = targetMachine.getTargetFeatureString();
+    for (auto& fn : module) {
+        if (fn.isDeclaration()) continue;
+        fn.addFnAttr("target-cpu", cpu);
+        if (!features.empty()) fn.addFnAttr("target-features", features);
+    }
+}
+
+std::error_code pl::WriteOutputFile(llvm::StringRef data, const std::filesystem::path& path) {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(path.string(), ec, llvm::sys::fs::OF_None);
+    if (!ec) out.write(data.data(), data.size());
+    return ec;
+}
+
+EmitKind pl::EmitKindFromPath(const std::filesystem::path& path) {
+    auto ext = path.extension();
+    if (ext == ".ll") return EmitKind::IR;
+    if (ext == ".bc") return EmitKind::Bitcode;
+    if (ext == ".s") return EmitKind::Assembly;
+    return EmitKind::Object;
+}
+
+llvm::Error pl::WriteObjectArchive(const std::filesystem::path& path, const std::vector<llvm::StringRef>& objects, const llvm::Triple& triple) {
+    const auto stem = path.stem().string();
+
+    std::vector<std::string> memberNames;
+    std::vector<llvm::NewArchiveMember> members;
+    for (size_t i = 0; i < objects.size(); i++) {
+        memberNames.push_back(fmt::format("{}.{}.o", stem, i));
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        members.emplace_back(llvm::MemoryBufferRef(objects[i], memberNames[i]));
+    }
+
+    const auto archiveKind = triple.isOSDarwin() ? llvm::object::Archive::K_DARWIN : llvm::object::Archive::K_GNU;
+    return llvm::writeArchive(path.string(), members, llvm::SymtabWritingMode::NormalSymtab, archiveKind, true, false);
+}
+
+llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> pl::LinkRelocatableObjects(const std::vector<llvm::StringRef>& objects) {
+    // lld reads objects of any target, the host's linker only its own.
+    auto linker = llvm::sys::findProgramByName("ld.lld");
+    if (!linker) linker = llvm::sys::findProgramByName("ld");
+    if (!linker) {
+        return llvm::createStringError(linker.getError(), "No linker ('ld.lld' or 'ld') was found to merge the objects.");
+    }
+
+    // The linker only reads and writes files, which are removed however this returns.
+    std::vector<std::string> paths;
+    auto removeFiles = llvm::make_scope_exit([&paths] {
+        for (const auto& path : paths) llvm::sys::fs::remove(path);
+    });
+    auto createFile = [&paths](llvm::StringRef contents) -> std::error_code {
+        int fd;
+        llvm::SmallString<128> path;
+        if (auto ec = llvm::sys::fs::createTemporaryFile("fracta", "o", fd, path)) return ec;
+        paths.push_back(path.str().str());
+        llvm::raw_fd_ostream out(fd, true);
+        out << contents;
+        out.close();
+        return out.error();
+    };
+
+    if (auto ec = createFile({})) return llvm::errorCodeToError(ec);
+    for (const auto& object : objects) {
+        if (auto ec = createFile(object)) return llvm::errorCodeToError(ec);
+    }
+
+    std::vector<llvm::StringRef> args {*linker, "-r", "-o", paths.front()};
+    args.insert(args.end(), paths.begin() + 1, paths.end());
+
+    std::string message;
+    if (llvm::sys::ExecuteAndWait(*linker, args, std::nullopt, {}, 0, 0, &message) != 0) {
+        if (message.empty()) message = "The linker failed.";
+        return llvm::createStringError(llvm::inconvertibleErrorCode(), "Could not merge the objects: %s", message.c_str());
+    }
+
+    auto linked = llvm::MemoryBuffer::getFile(paths.front());
+    if (!linked) return llvm::errorCodeToError(linked.getError());
+    return std::move(*linked);
+}
+
+TargetSettings pl::ResolveTargetSettings(const TargetSettings& settings) {
+    TargetSettings resolved = settings;
+    if (resolved.triple.empty()) resolved.triple = llvm::sys::getDefaultTargetTriple();
+    if (resolved.cpu.empty()) resolved.cpu = "generic";
+
+    llvm::SubtargetFeatures features;
+    if (resolved.cpu == "native") {
+        resolved.cpu = llvm::sys::getHostCPUName().str();
+        for (const auto& feature : llvm::sys::getHostCPUFeatures()) {
+            features.AddFeature(feature.first(), feature.second);
+        }
+    }
+    for (const auto& feature : llvm::SubtargetFeatures(settings.features).getFeatures()) {
+        features.AddFeature(feature);
+    }
+
+    resolved.features = features.getString();
+    return resolved;
+}
+
+ModuleEmitter::ModuleEmitter(const TargetSettings& settings) {
+    InitializeNativeTargets();
+
+    const auto resolved = ResolveTargetSettings(settings);
+    const auto& triple = resolved.triple;
+
+    std::string lookupError;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, lookupError);
+    if (!target) {
+        AddError(triple, lookupError);
+        return;
+    }
+
+    llvm::TargetOptions options;
+    targetMachine.reset(target->createTargetMachine(
+        triple,
+        resolved.cpu,
+        resolved.features,
+        options,
+        llvm::Reloc::PIC_,
+        std::optional<llvm::CodeModel::Model>(),
+        ToCodeGenOptLevel(settings.optLevel)
+    ));
+
+    if (!targetMachine) AddError(triple, "Could not create a target machine.");
+}
+
+void ModuleEmitter::PrepareModule(llvm::Module& module) const {
+    if (!targetMachine) return;
+    module.setTargetTriple(targetMachine->getTargetTriple().str());
+    module.setDataLayout(targetMachine->createDataLayout());
+    ApplyTargetAttributes(module, *targetMachine);
+}
+
+bool ModuleEmitter::Emit(llvm::Module& module, EmitKind kind, const std::filesystem::path& path) {
+    std::error_code ec;
+    auto flags = kind == EmitKind::IR || kind == EmitKind::Assembly ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None;
+    llvm::raw_fd_ostream out(path.string(), ec, flags);
+    if (ec) {
+        AddError(path.string(), ec.message());
+        return false;
+    }
+
+    return EmitToStream(module, kind, out, path.string());
+}
+
+bool ModuleEmitter::EmitToBuffer(llvm::Module& module, EmitKind kind, llvm::SmallVectorImpl<char>& buffer) {
+    llvm::raw_svector_ostream out(buffer);
+    return EmitToStream(module, kind, out, module.getName());
+}
+
+bool ModuleEmitter::EmitToStream(llvm::Module& module, EmitKind kind, llvm::raw_pwrite_stream& out, std::string_view outputName) {
+    llvm::TimeTraceScope timeScope("Emit", outputName);
+
+    switch (kind) {
+        case EmitKind::IR:
+            module.print(out, nullptr);
+            return true;
+        case EmitKind::Bitcode:
+            llvm::WriteBitcodeToFile(module, out);
+            return true;
+        case EmitKind::SummaryBitcode: {
+            // The summary lets the thin link decide imports and liveness without loading module bodies.
+            llvm::ProfileSummaryInfo profileSummary(module);
+            auto index = llvm::buildModuleSummaryIndex(module, nullptr, &profileSummary);
+            llvm::WriteBitcodeToFile(module, out, false, &index);
+            return true;
+        }
+        case EmitKind::Assembly:
+        case EmitKind::Object:
+            break;
+    }
+
+    if (!targetMachine) {
+        AddError(outputName, "No target machine available for code generation.");
+        return false;
+    }
+
+    llvm::legacy::PassManager pm;
+    auto fileType = kind == EmitKind::Assembly ? llvm::CodeGenFileType::AssemblyFile : llvm::CodeGenFileType::ObjectFile;
+    if (targetMachine->addPassesToEmitFile(pm, out, nullptr, fileType)) {
+        AddError(outputName, "Target machine cannot emit this file type.");
+        return false;
+    }
+
+    pm.run(module);
+    out.flush();
+    return true;
+}
+
+void ModuleEmitter::AddError(std::string_view outputName, std::string_view msg) {
+    errors.push_back({
+        std::string(outputName),
+        std::string(msg),
+        0
+    });
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CodeGen/Optimizer.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/TargetParser/Triple.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace pl {
+    enum class EmitKind {
+        IR,
+        Bitcode,
+        Assembly,
+        Object,
+        SummaryBitcode,     // Bitcode carrying a ThinLTO module summary, for 'fractac lto-link'.
+    };
+
+    void InitializeNativeTargets();
+
+    // Stamps the target machine's CPU and features on every defined function of the module.
+    void ApplyTargetAttributes(llvm::Module& module, const llvm::TargetMachine& targetMachine);
+
+    std::error_code WriteOutputFile(llvm::StringRef data, const std::filesystem::path& path);
+
+    // Picks the emit kind from an output file extension (.ll, .bc, .s), defaulting to an object file.
+    EmitKind EmitKindFromPath(const std::filesystem::path& path);
+
+    // Writes objects as a deterministic static archive with members named '<stem>.<index>.o'.
+    llvm::Error WriteObjectArchive(const std::filesystem::path& path, const std::vector<llvm::StringRef>& objects, const llvm::Triple& triple);
+
+    // Merges objects, in order, into a single relocatable object with the system linker ('ld -r'). Separately compiled
+    // objects only link like one when merged, as a linker pulls archive members only for symbols it already needs.
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> LinkRelocatableObjects(const std::vector<llvm::StringRef>& objects);
+
+    struct TargetSettings {
+        std::string triple;     // Empty means the host triple.
+        std::string cpu;        // Empty means a generic CPU for the triple, "native" means the host CPU and its features.
+        std::string features;
+        OptLevel optLevel = OptLevel::O0;
+    };
+
+    // Fills in the host triple, and replaces an empty CPU with "generic" and "native" with the host CPU and features.
+    TargetSettings ResolveTargetSettings(const TargetSettings& settings);
+
+    class ModuleEmitter {
+        private:
+            std::unique_ptr<llvm::TargetMachine> targetMachine;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            explicit ModuleEmitter(const TargetSettings& settings = {});
+
+            // Sets the module's triple and data layout, and the CPU and features of every defined function,
+            // to match the target machine.
+            void PrepareModule(llvm::Module& module) const;
+
+            bool Emit(llvm::Module& module, EmitKind kind, const std::filesystem::path& path);
+            bool EmitToBuffer(llvm::Module& module, EmitKind kind, llvm::SmallVectorImpl<char>& buffer);
+
+            [[nodiscard]] llvm::TargetMachine* GetTargetMachine() const { return targetMachine.get(); }
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            bool EmitToStream(llvm::Module& module, EmitKind kind, llvm::raw_pwrite_stream& out, std::string_view outputName);
+
+            void AddError(std::string_view outputName, std::string_view msg);
+    };
+}
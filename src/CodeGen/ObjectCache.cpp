@@ -0,0 +1,145 @@
+#include "ObjectCache.hpp"
+#include "fmt/core.h"
+#include "magic_enum/magic_enum.hpp"
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef FRACTA_VERSION
+#define FRACTA_VERSION "unknown"
+#endif
+
+using namespace pl;
+
+DiskObjectCache::DiskObjectCache(const ObjectCacheSettings& settings, const llvm::TargetMachine& targetMachine, OptLevel optLevel)
+    : settings(settings) {
+    targetKey = fmt::format("fracta-{};llvm-{};{};{};{};{}",
+        FRACTA_VERSION,
+        LLVM_VERSION_STRING,
+        targetMachine.getTargetTriple().str(),
+        targetMachine.getTargetCPU().str(),
+        targetMachine.getTargetFeatureString().str(),
+        magic_enum::enum_name(optLevel)
+    );
+
+    std::error_code ec;
+    std::filesystem::create_directories(settings.directory, ec);
+    Prune();
+}
+
+void DiskObjectCache::AddKeyInput(llvm::StringRef data) {
+    llvm::SHA256 hasher;
+    hasher.update(data);
+    targetKey += ";" + llvm::toHex(hasher.final(), true);
+}
+
+std::string DiskObjectCache::ComputeKey(const llvm::Module& module) const {
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream out(bitcode);
+    llvm::WriteBitcodeToFile(module, out);
+    return ComputeKey(llvm::StringRef(bitcode.data(), bitcode.size()));
+}
+
+std::string DiskObjectCache::ComputeKey(llvm::StringRef bitcode) const {
+    llvm::SHA256 hasher;
+    hasher.update(targetKey);
+    hasher.update(bitcode);
+    return llvm::toHex(hasher.final(), true);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> DiskObjectCache::Load(const std::string& key) {
+    const auto path = PathForKey(key);
+
+    auto buffer = llvm::MemoryBuffer::getFile(path.string());
+    if (!buffer) return nullptr;
+
+    // Refreshing the modification time is what makes eviction least-recently-used.
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+    return std::move(*buffer);
+}
+
+void DiskObjectCache::Store(const std::string& key, llvm::StringRef object) {
+    static std::atomic<uint64_t> tempCounter = 0;
+
+    // Written under a unique name and renamed, so concurrent readers never see partial files.
+    const auto path = PathForKey(key);
+    auto tempPath = path;
+    tempPath += fmt::format(".{}.{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()), tempCounter++);
+
+    {
+        std::ofstream out(tempPath, std::ios::binary);
+        if (!out) return;
+        out.write(object.data(), static_cast<std::streamsize>(object.size()));
+        if (!out) return;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return;
+    }
+
+    if (knownSize.fetch_add(object.size()) + object.size() <= settings.maxSizeBytes) return;
+
+    // Whoever waited for the lock finds the size already brought down.
+    std::lock_guard lock(pruneMutex);
+    if (knownSize > settings.maxSizeBytes) Prune();
+}
+
+void DiskObjectCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+    Store(ComputeKey(*module), object.getBuffer());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> DiskObjectCache::getObject(const llvm::Module* module) {
+    return Load(ComputeKey(*module));
+}
+
+std::filesystem::path DiskObjectCache::PathForKey(const std::string& key) const {
+    return settings.directory / (key + ".o");
+}
+
+void DiskObjectCache::Prune() {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(settings.directory, ec)) {
+        if (file.path().extension() != ".o") continue;
+
+        std::error_code entryEc;
+        auto size = file.file_size(entryEc);
+        auto lastUse = file.last_write_time(entryEc);
+        if (entryEc) continue;
+
+        entries.push_back({file.path(), lastUse, size});
+        totalSize += size;
+    }
+
+    if (totalSize > settings.maxSizeBytes) {
+        std::ranges::sort(entries, {}, &Entry::lastUse);
+        for (const auto& entry : entries) {
+            if (totalSize <= settings.maxSizeBytes) break;
+            if (std::filesystem::remove(entry.path, ec)) totalSize -= entry.size;
+        }
+    }
+    knownSize = totalSize;
+}
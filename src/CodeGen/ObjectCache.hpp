@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CodeGen/Optimizer.hpp"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Target/TargetMachine.h>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace pl {
+    struct ObjectCacheSettings {
+        std::filesystem::path directory;
+        uint64_t maxSizeBytes = uint64_t {1} << 30;
+    };
+
+    // On-disk cache of object files keyed by a hash of the module, the target and the compiler version.
+    // Least recently used entries are evicted once the cache grows past its size limit. The directory is scanned
+    // on construction, and again only when the size it had plus what was stored since goes over the limit.
+    class DiskObjectCache final : public llvm::ObjectCache {
+        private:
+            ObjectCacheSettings settings;
+            std::string targetKey;
+
+            // Stores from concurrent partitions and JIT threads add to it; replacing an entry counts it twice,
+            // which only makes the next scan come early.
+            std::atomic<uint64_t> knownSize = 0;
+            std::mutex pruneMutex;
+
+        public:
+            DiskObjectCache(const ObjectCacheSettings& settings, const llvm::TargetMachine& targetMachine, OptLevel optLevel);
+
+            // Mixes an input that changes code generation without changing the module, such as a profile, into every key.
+            void AddKeyInput(llvm::StringRef data);
+
+            [[nodiscard]] std::string ComputeKey(const llvm::Module& module) const;
+            [[nodiscard]] std::string ComputeKey(llvm::StringRef bitcode) const;
+
+            std::unique_ptr<llvm::MemoryBuffer> Load(const std::string& key);
+            void Store(const std::string& key, llvm::StringRef object);
+
+            // ORC interface, keyed by the module handed to the JIT's compiler.
+            void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+            std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+        private:
+            [[nodiscard]] std::filesystem::path PathForKey(const std::string& key) const;
+            // Evicts entries until the cache fits its limit, and sets the known size to what is left.
+            void Prune();
+    };
+}
@@ -0,0 +1,101 @@
+#include "Optimizer.hpp"
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <optional>
+#include <string>
+
+using namespace pl;
+
+static llvm::OptimizationLevel ToOptimizationLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::OptimizationLevel::O0;
+        case OptLevel::O1: return llvm::OptimizationLevel::O1;
+        case OptLevel::O2: return llvm::OptimizationLevel::O2;
+        case OptLevel::O3: return llvm::OptimizationLevel::O3;
+        case OptLevel::Os: return llvm::OptimizationLevel::Os;
+    }
+    return llvm::OptimizationLevel::O0;
+}
+
+llvm::CodeGenOptLevel pl::ToCodeGenOptLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::CodeGenOptLevel::None;
+        case OptLevel::O1: return llvm::CodeGenOptLevel::Less;
+        case OptLevel::O2:
+        case OptLevel::Os: return llvm::CodeGenOptLevel::Default;
+        case OptLevel::O3: return llvm::CodeGenOptLevel::Aggressive;
+    }
+    return llvm::CodeGenOptLevel::Default;
+}
+
+static std::optional<llvm::PGOOptions> MakePGOOptions(const OptimizerSettings& settings) {
+    if (!settings.profileGenerate.empty()) {
+        return llvm::PGOOptions(settings.profileGenerate, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+    }
+    if (!settings.profileUse.empty()) {
+        return llvm::PGOOptions(settings.profileUse, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+    }
+    return {};
+}
+
+ModuleOptimizer::ModuleOptimizer(llvm::TargetMachine* targetMachine, const OptimizerSettings& settings)
+    : targetMachine(targetMachine), settings(settings) { }
+
+void ModuleOptimizer::Run(llvm::Module& module) {
+    // Every pass inside is traced through the standard instrumentation.
+    llvm::TimeTraceScope timeScope("Optimize", module.getName());
+
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+
+    llvm::PassInstrumentationCallbacks pic;
+    llvm::StandardInstrumentations si(module.getContext(), false);
+    si.registerCallbacks(pic, &mam);
+    // The timing handler follows llvm::TimePassesIsEnabled, which the driver sets before any optimizer runs.
+    // Optimizers that do not report print their timings nowhere.
+    if (!settings.timePasses) si.getTimePasses().setOutStream(llvm::nulls());
+
+    const bool vectorize = settings.level == OptLevel::O2 || settings.level == OptLevel::O3 || settings.level == OptLevel::Os;
+    llvm::PipelineTuningOptions pto;
+    pto.LoopVectorization = vectorize;
+    pto.SLPVectorization = vectorize;
+
+    llvm::PassBuilder pb(targetMachine, pto, MakePGOOptions(settings), &pic);
+    pb.registerModuleAnalyses(mam);
+    pb.registerCGSCCAnalyses(cgam);
+    pb.registerFunctionAnalyses(fam);
+    pb.registerLoopAnalyses(lam);
+    pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+    const auto level = ToOptimizationLevel(settings.level);
+    const auto phase = settings.thinLTOPreLink ? llvm::ThinOrFullLTOPhase::ThinLTOPreLink : llvm::ThinOrFullLTOPhase::None;
+    auto mpm = settings.level == OptLevel::O0 ? pb.buildO0DefaultPipeline(level, phase)
+        : settings.thinLTOPreLink ? pb.buildThinLTOPreLinkDefaultPipeline(level)
+        : pb.buildPerModuleDefaultPipeline(level);
+
+    if (settings.printPipeline) {
+        std::string pipeline;
+        llvm::raw_string_ostream pipelineStream(pipeline);
+        mpm.printPipeline(pipelineStream, [&pic](llvm::StringRef className) {
+            auto passName = pic.getPassNameForClassName(className);
+            return passName.empty() ? className : passName;
+        });
+        llvm::outs() << "Pass pipeline:\n" << pipelineStream.str() << "\n";
+    }
+
+    mpm.run(module, mam);
+
+    if (settings.timePasses) si.getTimePasses().print();
+}
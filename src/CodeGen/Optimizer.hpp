@@ -0,0 +1,45 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <cstdint>
+#include <string>
+
+namespace pl {
+    enum class OptLevel : uint8_t {
+        O0,
+        O1,
+        O2,
+        O3,
+        Os,
+    };
+
+    llvm::CodeGenOptLevel ToCodeGenOptLevel(OptLevel level);
+
+    struct OptimizerSettings {
+        OptLevel level = OptLevel::O0;
+        bool printPipeline = false;
+        bool timePasses = false;    // Prints the timings collected while llvm::TimePassesIsEnabled is set.
+
+        // Runs the ThinLTO pre-link pipeline, leaving inlining and late optimisations to the link step.
+        bool thinLTOPreLink = false;
+
+        // Instruments edges and values. The program writes a raw profile to this path (a pattern such as
+        // 'default_%m.profraw') on exit, so it must be linked with the compiler-rt profile runtime.
+        std::string profileGenerate;
+        // Optimises with an indexed profile merged by 'llvm-profdata merge'.
+        std::string profileUse;
+    };
+
+    class ModuleOptimizer {
+        private:
+            llvm::TargetMachine* targetMachine;
+            OptimizerSettings settings;
+
+        public:
+            ModuleOptimizer(llvm::TargetMachine* targetMachine, const OptimizerSettings& settings);
+
+            // Runs the standard new pass manager pipeline for the configured level.
+            void Run(llvm::Module& module);
+    };
+}
@@ -0,0 +1,188 @@
+#include "ParallelCodeGen.hpp"
+#include "Utils/TimeTrace.hpp"
+#include "fmt/core.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/MemoryBufferRef.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Triple.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using namespace pl;
+
+static llvm::MemoryBufferRef BufferRef(const llvm::SmallVectorImpl<char>& data, llvm::StringRef name) {
+    return llvm::MemoryBufferRef(llvm::StringRef(data.data(), data.size()), name);
+}
+
+ParallelCodeGen::ParallelCodeGen(const TargetSettings& targetSettings, const OptimizerSettings& optimizerSettings, unsigned threads)
+    : targetSettings(targetSettings),
+      optimizerSettings(optimizerSettings),
+      threads(std::max(threads, 1u))
+    { }
+
+bool ParallelCodeGen::Emit(llvm::Module& module, EmitKind kind, const std::filesystem::path& path) {
+    // Objects are cached by the unoptimised module, so a hit skips optimisation as well as code generation.
+    const bool archive = kind == EmitKind::Object && path.extension() == ".a";
+    std::string cacheKey;
+    if (objectCache && kind == EmitKind::Object && !archive) {
+        cacheKey = objectCache->ComputeKey(module);
+        if (auto cached = objectCache->Load(cacheKey)) {
+            if (auto ec = WriteOutputFile(cached->getBuffer(), path)) {
+                AddError(path.string(), ec.message());
+                return false;
+            }
+            return true;
+        }
+    }
+
+    // The whole module is optimised before it is split, so inlining and other interprocedural passes still see
+    // every function.
+    ModuleEmitter emitter(targetSettings);
+    if (emitter.HadErrors()) {
+        errors = emitter.GetErrors();
+        return false;
+    }
+    ModuleOptimizer(emitter.GetTargetMachine(), optimizerSettings).Run(module);
+
+    // Only object code is split, as an IR or bitcode module has no code generation to spread, and assembly files
+    // cannot be merged.
+    if (kind != EmitKind::Object) {
+        if (!emitter.Emit(module, kind, path)) {
+            errors = emitter.GetErrors();
+            return false;
+        }
+        return true;
+    }
+
+    unsigned definedFunctions = 0;
+    for (const auto& fn : module) {
+        if (!fn.isDeclaration()) definedFunctions++;
+    }
+    const unsigned partitionCount = std::clamp(definedFunctions, 1u, MaxPartitions);
+
+    // Partitions travel as bitcode so that each worker can load its own copy into a private context.
+    std::vector<Partition> partitions;
+    partitions.reserve(partitionCount);
+    llvm::SplitModule(module, partitionCount, [&partitions](std::unique_ptr<llvm::Module> part) {
+        auto& partition = partitions.emplace_back();
+        llvm::raw_svector_ostream out(partition.bitcode);
+        llvm::WriteBitcodeToFile(*part, out);
+    });
+
+    DiagnosticsCollector diagnostics(partitions.size(), {.deduplicate = false});
+    {
+        const bool tracing = llvm::timeTraceProfilerEnabled();
+        llvm::DefaultThreadPool pool(llvm::hardware_concurrency(threads));
+        for (size_t i = 0; i < partitions.size(); i++) {
+            pool.async([this, &partitions, &diagnostics, i, tracing] {
+                TimeTraceWorkerScope traceScope(tracing);
+                CompilePartition(partitions[i], diagnostics.GetShard(i));
+            });
+        }
+        pool.wait();
+    }
+
+    DiagnosticsEngine merged({.deduplicate = false});
+    diagnostics.MergeInto(merged);
+    if (merged.HadErrors()) {
+        errors = merged.GetErrors();
+        return false;
+    }
+
+    if (archive) return WriteArchive(module, partitions, path);
+    return WriteMerged(partitions, path, cacheKey);
+}
+
+void ParallelCodeGen::CompilePartition(Partition& partition, DiagnosticsEngine& diagnostics) {
+    // Keyed by the optimised partition, so only the partitions a change reaches are compiled again.
+    std::string cacheKey;
+    if (objectCache) {
+        cacheKey = objectCache->ComputeKey(llvm::StringRef(partition.bitcode.data(), partition.bitcode.size()));
+        if (auto cached = objectCache->Load(cacheKey)) {
+            partition.output.assign(cached->getBufferStart(), cached->getBufferEnd());
+            return;
+        }
+    }
+
+    llvm::LLVMContext context;
+
+    auto parsed = llvm::parseBitcodeFile(BufferRef(partition.bitcode, "partition"), context);
+    if (!parsed) {
+        diagnostics.Add({"partition", llvm::toString(parsed.takeError()), 0});
+        return;
+    }
+    auto& module = **parsed;
+
+    // Target machines are not thread-safe, so every partition gets its own.
+    ModuleEmitter emitter(targetSettings);
+    if (emitter.HadErrors()) {
+        diagnostics.Add(emitter.GetErrors());
+        return;
+    }
+
+    if (!emitter.EmitToBuffer(module, EmitKind::Object, partition.output)) {
+        diagnostics.Add(emitter.GetErrors());
+        return;
+    }
+
+    if (!cacheKey.empty()) {
+        objectCache->Store(cacheKey, llvm::StringRef(partition.output.data(), partition.output.size()));
+    }
+}
+
+bool ParallelCodeGen::WriteMerged(std::vector<Partition>& partitions, const std::filesystem::path& path, const std::string& cacheKey) {
+    std::vector<llvm::StringRef> objects;
+    for (const auto& partition : partitions) {
+        objects.emplace_back(partition.output.data(), partition.output.size());
+    }
+
+    // A single partition needs no merging.
+    std::unique_ptr<llvm::MemoryBuffer> merged;
+    if (objects.size() == 1) {
+        merged = llvm::MemoryBuffer::getMemBuffer(objects.front(), "", false);
+    }
+    else {
+        auto linked = LinkRelocatableObjects(objects);
+        if (!linked) {
+            AddError(path.string(), llvm::toString(linked.takeError()));
+            return false;
+        }
+        merged = std::move(*linked);
+    }
+
+    if (!cacheKey.empty()) objectCache->Store(cacheKey, merged->getBuffer());
+    if (auto ec = WriteOutputFile(merged->getBuffer(), path)) {
+        AddError(path.string(), ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool ParallelCodeGen::WriteArchive(const llvm::Module& module, std::vector<Partition>& partitions, const std::filesystem::path& path) {
+    std::vector<llvm::StringRef> objects;
+    for (const auto& partition : partitions) {
+        objects.emplace_back(partition.output.data(), partition.output.size());
+    }
+
+    if (auto err = WriteObjectArchive(path, objects, llvm::Triple(module.getTargetTriple()))) {
+        AddError(path.string(), llvm::toString(std::move(err)));
+        return false;
+    }
+    return true;
+}
+
+void ParallelCodeGen::AddError(std::string_view context, std::string_view msg) {
+    errors.push_back({
+        std::string(context),
+        std::string(msg),
+        0
+    });
+}
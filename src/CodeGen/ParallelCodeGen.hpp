@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CodeGen/ModuleEmitter.hpp"
+#include "CodeGen/ObjectCache.hpp"
+#include "CodeGen/Optimizer.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Utils/Diagnostics.hpp>
+#include <llvm/IR/Module.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace pl {
+    // Optimises a module, then splits it into function partitions that are compiled to objects concurrently,
+    // each in its own LLVMContext. The partitioning depends only on the module, never on the
+    // thread count, so the output is identical for any number of threads.
+    class ParallelCodeGen {
+        private:
+            TargetSettings targetSettings;
+            OptimizerSettings optimizerSettings;
+            unsigned threads;
+            DiskObjectCache* objectCache = nullptr;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            static constexpr unsigned MaxPartitions = 32;
+
+            ParallelCodeGen(const TargetSettings& targetSettings, const OptimizerSettings& optimizerSettings, unsigned threads);
+
+            // The output object is looked up by the unoptimised module, skipping both optimisation and code
+            // generation on a hit, and each partition's object by its optimised bitcode.
+            void SetObjectCache(DiskObjectCache* cache) { objectCache = cache; }
+
+            // A '.a' object output is written as a static archive of one object per partition. Other object outputs
+            // merge the partitions into a single relocatable object. IR, bitcode and assembly are emitted unsplit.
+            bool Emit(llvm::Module& module, EmitKind kind, const std::filesystem::path& path);
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            struct Partition {
+                llvm::SmallVector<char, 0> bitcode;
+                llvm::SmallVector<char, 0> output;
+            };
+
+            // Errors go to the partition's own shard of diagnostics.
+            void CompilePartition(Partition& partition, DiagnosticsEngine& diagnostics);
+
+            // Stores the object in the cache under a non-empty key.
+            bool WriteMerged(std::vector<Partition>& partitions, const std::filesystem::path& path, const std::string& cacheKey);
+            bool WriteArchive(const llvm::Module& module, std::vector<Partition>& partitions, const std::filesystem::path& path);
+
+            void AddError(std::string_view context, std::string_view msg);
+    };
+}
@@ -0,0 +1,149 @@
+#include "ThinLTO.hpp"
+#include "fmt/core.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+using namespace pl;
+
+static unsigned ToLTOOptLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return 0;
+        case OptLevel::O1: return 1;
+        case OptLevel::O2:
+        case OptLevel::Os: return 2;
+        case OptLevel::O3: return 3;
+    }
+    return 2;
+}
+
+ThinLTOLinker::ThinLTOLinker(const TargetSettings& targetSettings, unsigned threads)
+    : targetSettings(targetSettings), threads(threads) { }
+
+bool ThinLTOLinker::Link(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output) {
+    InitializeNativeTargets();
+    const auto resolved = ResolveTargetSettings(targetSettings);
+
+    // Input files reference their buffers until the link has run.
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+    std::vector<std::unique_ptr<llvm::lto::InputFile>> files;
+    bool definesMain = false;
+
+    for (const auto& input : inputs) {
+        auto buffer = llvm::MemoryBuffer::getFile(input.string());
+        if (!buffer) {
+            AddError(input.string(), buffer.getError().message());
+            continue;
+        }
+
+        auto file = llvm::lto::InputFile::create((*buffer)->getMemBufferRef());
+        if (!file) {
+            AddError(input.string(), llvm::toString(file.takeError()));
+            continue;
+        }
+
+        for (const auto& symbol : (*file)->symbols()) {
+            if (!symbol.isUndefined() && symbol.getName() == "main") definesMain = true;
+        }
+        buffers.push_back(std::move(*buffer));
+        files.push_back(std::move(*file));
+    }
+    if (HadErrors()) return false;
+
+    llvm::lto::Config config;
+    config.CPU = resolved.cpu;
+    config.MAttrs = llvm::SubtargetFeatures(resolved.features).getFeatures();
+    config.DefaultTriple = resolved.triple;
+    config.RelocModel = llvm::Reloc::PIC_;
+    config.OptLevel = ToLTOOptLevel(targetSettings.optLevel);
+    config.CGOptLevel = ToCodeGenOptLevel(targetSettings.optLevel);
+
+    auto backend = llvm::lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(threads));
+    llvm::lto::LTO lto(std::move(config), backend);
+
+    std::unordered_set<std::string> defined;
+    for (size_t i = 0; i < files.size(); i++) {
+        std::vector<llvm::lto::SymbolResolution> resolutions;
+
+        for (const auto& symbol : files[i]->symbols()) {
+            llvm::lto::SymbolResolution resolution;
+            if (!symbol.isUndefined()) {
+                const auto name = symbol.getName().str();
+                if (!defined.insert(name).second) {
+                    AddError(inputs[i].string(), fmt::format("Symbol '{}' is defined by more than one module.", name));
+                }
+                resolution.Prevailing = true;
+                resolution.FinalDefinitionInLinkageUnit = true;
+                resolution.VisibleToRegularObj = !definesMain || name == "main";
+            }
+            resolutions.push_back(resolution);
+        }
+
+        if (auto err = lto.add(std::move(files[i]), resolutions)) {
+            AddError(inputs[i].string(), llvm::toString(std::move(err)));
+        }
+    }
+    if (HadErrors()) return false;
+
+    // One task per module, plus task 0 for any regular LTO partition, which stays empty here.
+    std::vector<llvm::SmallString<0>> objects(lto.getMaxTasks());
+    auto addStream = [&objects](unsigned task, const llvm::Twine&) -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+        return std::make_unique<llvm::CachedFileStream>(std::make_unique<llvm::raw_svector_ostream>(objects[task]));
+    };
+
+    if (auto err = lto.run(addStream)) {
+        AddError(output.string(), llvm::toString(std::move(err)));
+        return false;
+    }
+
+    std::vector<llvm::StringRef> produced;
+    for (const auto& object : objects) {
+        if (!object.empty()) produced.emplace_back(object);
+    }
+    if (produced.empty()) {
+        AddError(output.string(), "The link produced no code.");
+        return false;
+    }
+
+    if (output.extension() == ".a") {
+        if (auto err = WriteObjectArchive(output, produced, llvm::Triple(resolved.triple))) {
+            AddError(output.string(), llvm::toString(std::move(err)));
+            return false;
+        }
+        return true;
+    }
+
+    // The backends' objects only link like one object once merged.
+    llvm::StringRef merged = produced.front();
+    std::unique_ptr<llvm::MemoryBuffer> linked;
+    if (produced.size() > 1) {
+        auto result = LinkRelocatableObjects(produced);
+        if (!result) {
+            AddError(output.string(), llvm::toString(result.takeError()));
+            return false;
+        }
+        linked = std::move(*result);
+        merged = linked->getBuffer();
+    }
+
+    if (auto ec = WriteOutputFile(merged, output)) {
+        AddError(output.string(), ec.message());
+        return false;
+    }
+    return true;
+}
+
+void ThinLTOLinker::AddError(std::string_view context, std::string_view msg) {
+    errors.push_back({
+        std::string(context),
+        std::string(msg),
+        0
+    });
+}
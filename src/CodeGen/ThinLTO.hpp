@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CodeGen/ModuleEmitter.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    // Links modules compiled with '-flto=thin' into native code. The thin link reads only the module summaries
+    // to decide cross-module imports and which symbols are live, then each module is optimised and compiled
+    // in parallel with the functions it imports.
+    class ThinLTOLinker {
+        private:
+            TargetSettings targetSettings;
+            unsigned threads;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            // A thread count of 0 uses every hardware thread.
+            ThinLTOLinker(const TargetSettings& targetSettings, unsigned threads);
+
+            // If any input defines 'main', every other symbol is internalised so unused functions can be
+            // dropped; otherwise all definitions stay visible. A '.a' output is an archive of one object per module,
+            // any other output a single relocatable object merged from them.
+            bool Link(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output);
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            void AddError(std::string_view context, std::string_view msg);
+    };
+}
@@ -0,0 +1,47 @@
+#include "TieredCompiler.hpp"
+#include "CodeGen/CodeGenerator.hpp"
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+
+using namespace pl;
+
+TieredCompiler::TieredCompiler(std::vector<FileSourceNodeSP> files, std::string_view moduleName, const JITSettings& settings)
+    : files(std::move(files)),
+      moduleName(moduleName),
+      settings(settings)
+{
+    this->settings.lazy = true;
+}
+
+NativeThunk TieredCompiler::Compile(const FuncDeclStmt& func) {
+    if (failed) return nullptr;
+    if (!jit && !CreateJIT()) {
+        failed = true;
+        return nullptr;
+    }
+
+    auto thunk = reinterpret_cast<NativeThunk>(jit->Lookup(CodeGenerator::ThunkName(func.name.identName)));
+    if (!thunk) {
+        errors = jit->GetErrors();
+    }
+    return thunk;
+}
+
+bool TieredCompiler::CreateJIT() {
+    auto context = std::make_unique<llvm::LLVMContext>();
+
+    CodeGenerator codegen(*context, moduleName);
+    codegen.SetEmitThunks(true);
+    auto module = codegen.Generate(files);
+    if (!module) {
+        errors = codegen.GetErrors();
+        return false;
+    }
+
+    jit = std::make_unique<JITEngine>(settings);
+    if (!jit->AddModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+        errors = jit->GetErrors();
+        return false;
+    }
+    return true;
+}
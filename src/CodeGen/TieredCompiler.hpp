@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CodeGen/JITEngine.hpp"
+#include "Interpreter/Interpreter.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    // Native tier for the interpreter. The whole program is lowered into a lazy JIT on the first promotion,
+    // so each later promotion only compiles the functions its thunk actually reaches.
+    class TieredCompiler final : public NativeTier {
+        private:
+            std::vector<FileSourceNodeSP> files;
+            std::string moduleName;
+            JITSettings settings;
+
+            std::unique_ptr<JITEngine> jit;
+            bool failed = false;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            TieredCompiler(std::vector<FileSourceNodeSP> files, std::string_view moduleName, const JITSettings& settings);
+
+            NativeThunk Compile(const FuncDeclStmt& func) override;
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            bool CreateJIT();
+    };
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pl {
+    // A source file loaded by a SourceManager.
+    using FileID = uint32_t;
+    inline constexpr FileID InvalidFileID = ~FileID(0);
+}
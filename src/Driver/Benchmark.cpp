@@ -0,0 +1,186 @@
+#include "Benchmark.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "CodeGen/CodeGenerator.hpp"
+#include "CodeGen/JITEngine.hpp"
+#include "Interpreter/Interpreter.hpp"
+#include "Utils/Utils.hpp"
+#include "VM/BytecodeCompiler.hpp"
+#include "VM/VirtualMachine.hpp"
+#include "fmt/core.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+using namespace pl;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct TierResult {
+        std::string_view name;
+        double setupMicros = 0;
+        double callMicros = 0;
+        std::optional<int64_t> result;
+    };
+
+    double MicrosSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    // Setup returns a callable running Main once, or an empty function if the tier is unavailable.
+    TierResult Measure(std::string_view name, unsigned iterations, const std::function<std::function<std::optional<int64_t>()>()>& setup) {
+        TierResult tier;
+        tier.name = name;
+
+        auto start = Clock::now();
+        auto run = setup();
+        tier.setupMicros = MicrosSince(start);
+        if (!run) return tier;
+
+        tier.result = run();
+        start = Clock::now();
+        for (unsigned i = 1; i < iterations && tier.result; i++) {
+            tier.result = run();
+        }
+        tier.callMicros = MicrosSince(start) / std::max(iterations - 1, 1u);
+        return tier;
+    }
+
+    // Every tier calls Main without arguments and reads an integer result.
+    bool DefinesRunnableMain(const std::vector<FileSourceNodeSP>& files) {
+        for (const auto& file : files) {
+            for (const auto& stmt : file->statements) {
+                auto func = InstanceOf<FuncDeclStmt>(stmt);
+                if (!func || func->name.identName != "Main") continue;
+                return func->body && func->args.empty() && TypeName(func->returnType) == "i32";
+            }
+        }
+        return false;
+    }
+}
+
+int pl::RunBenchmark(const CompilerOptions& options, const std::vector<FileSourceNodeSP>& files, std::string_view moduleName) {
+    if (!DefinesRunnableMain(files)) {
+        ReportErrors("Run errors.", {{std::string(moduleName), "Program must define 'func Main() i32' to be run.", 0}}, true);
+    }
+
+    const auto iterations = options.benchIterations;
+    std::vector<TierResult> tiers;
+    std::vector<ErrorInfo> errors;
+
+    std::optional<Interpreter> interpreter;
+    tiers.push_back(Measure("interpreter", iterations, [&]() -> std::function<std::optional<int64_t>()> {
+        interpreter.emplace(files);
+        return [&]() -> std::optional<int64_t> {
+            auto value = interpreter->Call("Main", {});
+            if (!value) return std::nullopt;
+            return std::get<int64_t>(*value);
+        };
+    }));
+    if (interpreter && interpreter->HadErrors()) errors.insert(errors.end(), interpreter->GetErrors().begin(), interpreter->GetErrors().end());
+
+    // The in-memory VM pays for bytecode compilation; the mapped one only for loading an existing file.
+    BytecodeModule compiledModule, mappedModule;
+    std::optional<VirtualMachine> compiledVm, mappedVm;
+
+    auto vmRunner = [](VirtualMachine& vm, const BytecodeModule& module) -> std::function<std::optional<int64_t>()> {
+        auto main = module.FindFunction("Main");
+        if (!main) return {};
+        return [&vm, index = *main]() -> std::optional<int64_t> {
+            auto raw = vm.Call(index, {});
+            if (!raw) return std::nullopt;
+            return static_cast<int64_t>(*raw);
+        };
+    };
+
+    tiers.push_back(Measure("bytecode VM", iterations, [&]() -> std::function<std::optional<int64_t>()> {
+        BytecodeCompiler compiler;
+        auto image = compiler.Compile(files);
+        if (image.empty()) {
+            errors.insert(errors.end(), compiler.GetErrors().begin(), compiler.GetErrors().end());
+            return {};
+        }
+        if (!compiledModule.Adopt(std::move(image))) return {};
+        compiledVm.emplace(compiledModule);
+        return vmRunner(*compiledVm, compiledModule);
+    }));
+
+    // Created exclusively with a unique name and written through its own descriptor, so nothing already in the
+    // temporary directory, such as a planted symlink, is followed.
+    int bytecodeFd = -1;
+    llvm::SmallString<128> bytecodePath;
+    if (auto image = BytecodeCompiler().Compile(files); !image.empty()
+        && !llvm::sys::fs::createTemporaryFile("fracta-bench", "fbc", bytecodeFd, bytecodePath)) {
+        llvm::raw_fd_ostream out(bytecodeFd, true);
+        out.write(reinterpret_cast<const char*>(image.data()), image.size());
+        out.close();
+        if (out.has_error()) {
+            out.clear_error();
+            llvm::sys::fs::remove(bytecodePath);
+            bytecodePath.clear();
+        }
+    }
+    tiers.push_back(Measure("bytecode VM (mmap)", iterations, [&]() -> std::function<std::optional<int64_t>()> {
+        if (bytecodePath.empty() || !mappedModule.Load(bytecodePath.str().str())) return {};
+        mappedVm.emplace(mappedModule);
+        return vmRunner(*mappedVm, mappedModule);
+    }));
+    if (!bytecodePath.empty()) llvm::sys::fs::remove(bytecodePath);
+
+    for (const auto* vm : {&compiledVm, &mappedVm}) {
+        if (*vm && (*vm)->HadErrors()) errors.insert(errors.end(), (*vm)->GetErrors().begin(), (*vm)->GetErrors().end());
+    }
+    for (const auto* module : {&compiledModule, &mappedModule}) {
+        if (module->HadErrors()) errors.insert(errors.end(), module->GetErrors().begin(), module->GetErrors().end());
+    }
+
+    std::optional<JITEngine> jit;
+    tiers.push_back(Measure("JIT", iterations, [&]() -> std::function<std::optional<int64_t>()> {
+        auto context = std::make_unique<llvm::LLVMContext>();
+        CodeGenerator codegen(*context, moduleName);
+        auto module = codegen.Generate(files);
+        if (!module) {
+            errors.insert(errors.end(), codegen.GetErrors().begin(), codegen.GetErrors().end());
+            return {};
+        }
+
+        JITSettings settings;
+        settings.optLevel = options.optLevel;
+        jit.emplace(settings);
+        jit->AddModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+
+        auto entry = reinterpret_cast<int32_t (*)()>(jit->Lookup("Main"));
+        if (!entry) {
+            errors.insert(errors.end(), jit->GetErrors().begin(), jit->GetErrors().end());
+            return {};
+        }
+        return [entry]() -> std::optional<int64_t> { return entry(); };
+    }));
+
+    fmt::print("{:<20}{:>14}{:>14}{:>12}\n", "tier", "setup (us)", "call (us)", "result");
+    for (const auto& tier : tiers) {
+        if (!tier.result) {
+            fmt::print("{:<20}{:>14}{:>14}{:>12}\n", tier.name, "-", "-", "failed");
+            continue;
+        }
+        fmt::print("{:<20}{:>14.2f}{:>14.3f}{:>12}\n", tier.name, tier.setupMicros, tier.callMicros, *tier.result);
+    }
+
+    bool agree = true;
+    for (const auto& tier : tiers) {
+        agree &= tier.result.has_value() && tier.result == tiers.front().result;
+    }
+
+    if (!errors.empty()) ReportErrors("Benchmark errors.", errors);
+    if (!agree) {
+        fmt::print("Tiers disagree on the result of Main.\n");
+        return 1;
+    }
+    return 0;
+}
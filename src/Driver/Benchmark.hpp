@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Driver/Options.hpp"
+#include <Parsing/ASTNode.hpp>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    // Times start-up and 'Main' calls on every execution tier for an analysed program, and prints a table.
+    // Returns the process exit status.
+    int RunBenchmark(const CompilerOptions& options, const std::vector<FileSourceNodeSP>& files, std::string_view moduleName);
+}
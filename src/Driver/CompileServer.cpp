@@ -0,0 +1,404 @@
+#include "CompileServer.hpp"
+#include "CodeGen/ModuleEmitter.hpp"
+#include "Driver/Driver.hpp"
+#include "Driver/FrontEnd.hpp"
+#include "Utils/Utils.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace pl;
+
+// Requests are a 32-bit payload size followed by the working directory and the arguments, each NUL-terminated.
+// The client's stdout and stderr travel with the size as SCM_RIGHTS. The reply is the 32-bit exit status.
+static constexpr uint32_t MaxRequestSize = 1u << 20;
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static bool MakeAddress(const std::filesystem::path& path, sockaddr_un& address) {
+    const auto str = path.string();
+    if (str.size() >= sizeof(address.sun_path)) return false;
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, str.c_str(), str.size() + 1);
+    return true;
+}
+
+// Requests compile and run code and write files as the server's user, so only that user may send them.
+static bool IsSameUser(int connection) {
+#if defined(__linux__)
+    ucred credentials {};
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) return false;
+    return credentials.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (::getpeereid(connection, &uid, &gid) != 0) return false;
+    return uid == ::geteuid();
+#endif
+}
+
+static bool WriteAll(int fd, const void* data, size_t size) {
+    auto bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const auto written = ::write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool ReadAll(int fd, void* data, size_t size) {
+    auto bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const auto got = ::read(fd, bytes, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        bytes += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+std::filesystem::path pl::DefaultServerSocket() {
+    if (auto runtimeDir = std::getenv("XDG_RUNTIME_DIR"); runtimeDir && *runtimeDir) {
+        return std::filesystem::path(runtimeDir) / "fractac.sock";
+    }
+    return fmt::format("/tmp/fractac-{}.sock", ::getuid());
+}
+
+std::optional<int> pl::ForwardToCompileServer(int argc, const char* const* argv) {
+    std::optional<std::filesystem::path> socketPath;
+    std::string payload;
+
+    std::error_code ec;
+    payload += std::filesystem::current_path(ec).string();
+    payload += '\0';
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--server") socketPath = DefaultServerSocket();
+        else if (arg.starts_with("--server=")) socketPath = arg.substr(9);
+        else {
+            payload += arg;
+            payload += '\0';
+        }
+    }
+    if (!socketPath || ec || payload.size() > MaxRequestSize) return std::nullopt;
+
+    sockaddr_un address;
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return std::nullopt;
+    if (!MakeAddress(*socketPath, address) || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        fmt::print(stderr, "No compile server at '{}', compiling locally.\n", socketPath->string());
+        return std::nullopt;
+    }
+
+    // The descriptors ride along with the size, which is the first thing the server reads.
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    iovec iov {&size, sizeof(size)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] {};
+
+    msghdr message {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    const int fds[2] = {STDOUT_FILENO, STDERR_FILENO};
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // Anything still buffered must come out before the server starts writing to the same descriptors.
+    std::fflush(stdout);
+    std::fflush(stderr);
+
+    int32_t status = 1;
+    if (::sendmsg(fd, &message, 0) != static_cast<ssize_t>(sizeof(size))
+        || !WriteAll(fd, payload.data(), payload.size())
+        || !ReadAll(fd, &status, sizeof(status))) {
+        fmt::print(stderr, "Lost the connection to the compile server at '{}'.\n", socketPath->string());
+        status = 1;
+    }
+
+    ::close(fd);
+    return status;
+}
+
+namespace {
+    struct Request {
+        std::string workingDirectory;
+        std::vector<std::string> args;
+        int out = -1;
+        int err = -1;
+
+        ~Request() {
+            if (out >= 0) ::close(out);
+            if (err >= 0) ::close(err);
+        }
+    };
+
+    bool ReceiveRequest(int connection, Request& request) {
+        uint32_t size = 0;
+        iovec iov {&size, sizeof(size)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] {};
+
+        msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        const auto received = ::recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+        if (received < 0) return false;
+
+        // Descriptors are installed in this process even when the rest of the message is wrong, so every one that
+        // arrived is either kept by the request or closed here.
+        std::vector<int> fds;
+        for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            const auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; i++) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                fds.push_back(fd);
+            }
+        }
+        if (received != static_cast<ssize_t>(sizeof(size)) || fds.size() != 2 || (message.msg_flags & MSG_CTRUNC)) {
+            for (const int fd : fds) ::close(fd);
+            return false;
+        }
+        request.out = fds[0];
+        request.err = fds[1];
+
+        if (size == 0 || size > MaxRequestSize) return false;
+        std::string payload(size, '\0');
+        if (!ReadAll(connection, payload.data(), payload.size()) || payload.back() != '\0') return false;
+
+        size_t start = 0;
+        for (size_t end = payload.find('\0'); end != std::string::npos; end = payload.find('\0', start)) {
+            if (start == 0 && request.workingDirectory.empty()) request.workingDirectory = payload.substr(0, end);
+            else request.args.push_back(payload.substr(start, end - start));
+            start = end + 1;
+        }
+        return true;
+    }
+
+    class CompileServer {
+        private:
+            ParsedFileCache parsedFiles;
+
+        public:
+            // Starts the request in a child and returns its pid, or returns nullopt if it failed before that, having
+            // told the client why.
+            std::optional<pid_t> Serve(const Request& request);
+
+        private:
+            [[noreturn]] void RunChild(const Request& request, const CompilerOptions& options, const std::vector<ErrorInfo>& optionErrors);
+    };
+
+    std::optional<pid_t> CompileServer::Serve(const Request& request) {
+        auto fail = [&](std::string_view msg) -> std::optional<pid_t> {
+            const auto text = fmt::format("fractac daemon: {}\n", msg);
+            WriteAll(request.err, text.data(), text.size());
+            return std::nullopt;
+        };
+
+        if (::chdir(request.workingDirectory.c_str()) != 0) {
+            return fail(fmt::format("Cannot enter '{}': {}", request.workingDirectory, std::strerror(errno)));
+        }
+
+        std::vector<const char*> argv = {"fractac"};
+        for (const auto& arg : request.args) argv.push_back(arg.c_str());
+
+        std::vector<ErrorInfo> optionErrors;
+        const auto options = ParseCommandLine(static_cast<int>(argv.size()), argv.data(), optionErrors);
+        if (options.mode == DriverMode::Daemon || options.mode == DriverMode::LanguageServer || options.watch) {
+            return fail("'daemon', 'lsp' and '--watch' cannot be run through the compile server.");
+        }
+
+        // Parsing happens here rather than in the child, so that the results outlive the request. The previous
+        // request's child reported its count from its own copy, so it is dropped here.
+        parsedFiles.TakeParsedCount();
+        if (optionErrors.empty() && options.mode != DriverMode::LTOLink && options.emit != EmitStage::Tokens) {
+            std::vector<ErrorInfo> inputErrors;
+            const auto files = CollectSourceFiles(options.inputs, inputErrors);
+            if (inputErrors.empty()) parsedFiles.Update(files, options.jobs.value_or(0));
+        }
+
+        std::fflush(stdout);
+        std::fflush(stderr);
+        const auto pid = ::fork();
+        if (pid < 0) return fail(fmt::format("Cannot fork: {}", std::strerror(errno)));
+        if (pid == 0) RunChild(request, options, optionErrors);
+        return pid;
+    }
+
+    void CompileServer::RunChild(const Request& request, const CompilerOptions& options, const std::vector<ErrorInfo>& optionErrors) {
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        std::signal(SIGCHLD, SIG_DFL);
+        sigset_t none;
+        sigemptyset(&none);
+        ::sigprocmask(SIG_SETMASK, &none, nullptr);
+        ::dup2(request.out, STDOUT_FILENO);
+        ::dup2(request.err, STDERR_FILENO);
+
+        if (!optionErrors.empty()) {
+            ReportErrors("Invalid command line.", optionErrors, true);
+        }
+        // Exits through std::exit, so output is flushed and exit-time reports run as in a local build.
+        std::exit(RunDriver(options, &parsedFiles));
+    }
+
+    void OnStopSignal(int) {
+        stopRequested = 1;
+    }
+
+    // Only there to interrupt the wait for a connection, so that finished requests are answered.
+    void OnChildExit(int) { }
+
+    struct RunningRequest {
+        int connection;
+        std::chrono::steady_clock::time_point start;
+        std::string command;
+    };
+
+    void FinishRequest(const RunningRequest& request, int32_t status) {
+        WriteAll(request.connection, &status, sizeof(status));
+        ::close(request.connection);
+
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request.start).count();
+        fmt::print(stderr, "[{:.1f} ms, status {}] {}\n", elapsed, status, request.command);
+    }
+
+    // Answers the requests whose children have exited. Waits for at least one if 'block' is set.
+    void ReapChildren(std::unordered_map<pid_t, RunningRequest>& running, bool block) {
+        int status = 0;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, block ? 0 : WNOHANG)) != 0) {
+            if (pid < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            block = false;
+
+            const auto it = running.find(pid);
+            if (it == running.end()) continue;
+            FinishRequest(it->second, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+            running.erase(it);
+        }
+    }
+}
+
+int pl::RunCompileServer(const CompilerOptions& options) {
+    const auto socketPath = options.socketPath.value_or(DefaultServerSocket());
+
+    sockaddr_un address;
+    if (!MakeAddress(socketPath, address)) {
+        ReportErrors("Server errors.", {{socketPath.string(), "Socket path is too long.", 0}}, true);
+    }
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        ReportErrors("Server errors.", {{socketPath.string(), std::strerror(errno), 0}}, true);
+    }
+
+    // A socket nobody answers on is left over from a server that did not shut down.
+    if (::connect(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        ReportErrors("Server errors.", {{socketPath.string(), "A compile server is already listening here.", 0}}, true);
+    }
+    ::unlink(address.sun_path);
+
+    // Created accessible to the owner only, whatever the umask, before anyone can connect.
+    const auto previousMask = ::umask(0077);
+    const bool bound = ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    ::umask(previousMask);
+    if (!bound || ::chmod(address.sun_path, 0600) != 0 || ::listen(listener, 16) != 0) {
+        ReportErrors("Server errors.", {{socketPath.string(), std::strerror(errno), 0}}, true);
+    }
+
+    // The signals stay blocked except while waiting for a connection, so that none is missed between the checks of
+    // the loop and the wait. Without SA_RESTART, so that they interrupt the wait.
+    sigset_t blocked, waitMask;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGCHLD);
+    ::sigprocmask(SIG_BLOCK, &blocked, &waitMask);
+
+    struct sigaction action {};
+    action.sa_handler = OnStopSignal;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    action.sa_handler = OnChildExit;
+    ::sigaction(SIGCHLD, &action, nullptr);
+
+    // Paid once here instead of by every request.
+    InitializeNativeTargets();
+
+    // Requests run concurrently up to one per core; further connections wait in the listen queue.
+    const size_t maxRunning = std::max(1u, std::thread::hardware_concurrency());
+
+    CompileServer server;
+    std::unordered_map<pid_t, RunningRequest> running;
+    fmt::print(stderr, "Compile server listening on '{}'.\n", socketPath.string());
+
+    while (!stopRequested) {
+        ReapChildren(running, running.size() >= maxRunning);
+        if (running.size() >= maxRunning) continue;
+
+        pollfd listening {listener, POLLIN, 0};
+        if (::ppoll(&listening, 1, nullptr, &waitMask) <= 0) continue;
+
+        const int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) continue;
+        if (!IsSameUser(connection)) {
+            fmt::print(stderr, "Refused a connection from another user.\n");
+            ::close(connection);
+            continue;
+        }
+
+        RunningRequest started {connection, std::chrono::steady_clock::now(), ""};
+        Request request;
+        if (!ReceiveRequest(connection, request)) {
+            ::close(connection);
+            continue;
+        }
+        for (const auto& arg : request.args) started.command += (started.command.empty() ? "" : " ") + arg;
+
+        if (const auto pid = server.Serve(request)) running.emplace(*pid, std::move(started));
+        else FinishRequest(started, 1);
+    }
+
+    // Requests already running are still answered.
+    while (!running.empty()) ReapChildren(running, true);
+
+    ::close(listener);
+    ::unlink(address.sun_path);
+    return 0;
+}
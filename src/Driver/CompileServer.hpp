@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Driver/Options.hpp"
+#include <filesystem>
+#include <optional>
+
+namespace pl {
+    // $XDG_RUNTIME_DIR/fractac.sock, or /tmp/fractac-<uid>.sock.
+    std::filesystem::path DefaultServerSocket();
+
+    // fractac daemon [--socket=<path>]: runs command lines forwarded by 'fractac --server' in a process that keeps
+    // parsed files and initialised targets warm. Each request runs in a forked child, which inherits that state and
+    // writes to the client's own stdout and stderr; up to one child per core runs at a time. Runs until SIGINT or
+    // SIGTERM, then answers the requests still running.
+    int RunCompileServer(const CompilerOptions& options);
+
+    // Client side of 'fractac --server[=<path>] <args>': forwards the remaining arguments, the working directory and
+    // the standard output and error descriptors to the server, and returns the exit status of the request.
+    // Returns nullopt if the command line has no '--server' or no server is listening, so it runs locally.
+    std::optional<int> ForwardToCompileServer(int argc, const char* const* argv);
+}
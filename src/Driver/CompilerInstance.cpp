@@ -0,0 +1,167 @@
+#include "CompilerInstance.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "Analysis/DeadFunctionElimination.hpp"
+#include "Analysis/SemanticAnalysis.hpp"
+#include "CodeGen/CodeGenerator.hpp"
+#include "Driver/FrontEnd.hpp"
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/TimeProfiler.h>
+
+using namespace pl;
+
+static CompilerInstanceSettings ResolveSettings(CompilerInstanceSettings settings) {
+    settings.optimizer.level = settings.target.optLevel;
+    return settings;
+}
+
+CompilerInstance::CompilerInstance(const CompilerInstanceSettings& settings)
+    : settings(ResolveSettings(settings)), emitter(this->settings.target) {
+    if (emitter.HadErrors()) {
+        setupErrors = emitter.GetErrors();
+        return;
+    }
+
+    // Checked up front, as the profile loader reports a missing file as a fatal LLVM diagnostic.
+    const auto& profileUse = this->settings.optimizer.profileUse;
+    if (!profileUse.empty()) {
+        auto buffer = llvm::MemoryBuffer::getFile(profileUse);
+        if (!buffer) {
+            setupErrors.push_back({profileUse, buffer.getError().message(), 0});
+            return;
+        }
+        profile = std::move(*buffer);
+    }
+
+    optimizer = std::make_unique<ModuleOptimizer>(emitter.GetTargetMachine(), this->settings.optimizer);
+    if (this->settings.objectCache) {
+        objectCache = std::make_unique<DiskObjectCache>(*this->settings.objectCache, *emitter.GetTargetMachine(), this->settings.target.optLevel);
+        if (profile) objectCache->AddKeyInput(profile->getBuffer());
+        if (!this->settings.optimizer.profileGenerate.empty()) objectCache->AddKeyInput(this->settings.optimizer.profileGenerate);
+    }
+}
+
+llvm::LLVMContext& CompilerInstance::AcquireContext() {
+    if (!context || contextJobs >= settings.jobsPerContext) {
+        context = std::make_unique<llvm::LLVMContext>();
+        contextJobs = 0;
+    }
+    contextJobs++;
+    return *context;
+}
+
+std::vector<CompileResult> CompilerInstance::CompileBatch(const std::vector<CompileJob>& jobs) {
+    std::vector<CompileResult> results;
+    results.reserve(jobs.size());
+    for (const auto& job : jobs) results.push_back(Compile(job));
+    return results;
+}
+
+bool CompilerInstance::CheckProfile(CompileResult& result) const {
+    if (!profile) return true;
+
+    const auto& path = settings.optimizer.profileUse;
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        result.errors.push_back({path, buffer.getError().message(), 0});
+        return false;
+    }
+    if ((*buffer)->getBuffer() != profile->getBuffer()) {
+        result.errors.push_back({path, "The profile changed after the compiler instance was created; create a new instance to use it.", 0});
+        return false;
+    }
+    return true;
+}
+
+CompileResult CompilerInstance::Compile(const CompileJob& job) {
+    llvm::TimeTraceScope timeScope("CompileJob", job.output.string());
+
+    CompileResult result;
+    if (HadErrors()) {
+        result.errors = setupErrors;
+        return result;
+    }
+
+    const auto files = CollectSourceFiles(job.inputs, result.errors);
+    if (!result.errors.empty()) return result;
+
+    // Jobs are usually small, so one worker is enough and costs the least to start.
+    std::vector<FileSourceNodeSP> nodes;
+    SourceManager sources;
+    for (auto& unit : LexAndParse(sources, files, 1, false)) {
+        result.errors.insert(result.errors.end(), unit.errors.begin(), unit.errors.end());
+        nodes.push_back(std::move(unit.ast));
+    }
+    if (!result.errors.empty()) return result;
+
+    // Named as the driver names it: after a single input, otherwise after the output.
+    const auto moduleName = !job.moduleName.empty() ? job.moduleName
+        : files.size() == 1 ? files.front().stem().string()
+        : job.output.stem().string();
+    SemanticAnalyzer sema(nodes, moduleName, settings.diagnostics);
+    sema.SetComptimeLimits(settings.comptimeLimits);
+    sema.Analyze();
+    result.warnings = sema.GetWarnings();
+    if (sema.HadErrors()) {
+        result.errors = sema.GetErrors();
+        return result;
+    }
+
+    DeadFunctionEliminator().Run(nodes);
+    ConstantFolder folder;
+    for (const auto& node : nodes) folder.Fold(node);
+
+    CodeGenerator codegen(AcquireContext(), moduleName);
+    auto module = codegen.Generate(nodes);
+    if (!module) {
+        result.errors = codegen.GetErrors();
+        return result;
+    }
+    emitter.PrepareModule(*module);
+
+    const auto emitKind = EmitKindFromPath(job.output);
+    const auto firstEmitError = emitter.GetErrors().size();
+    auto takeEmitErrors = [&] {
+        const auto& errors = emitter.GetErrors();
+        result.errors.assign(errors.begin() + firstEmitError, errors.end());
+    };
+
+    // Objects are cached by the unoptimised module, as in the driver.
+    std::string cacheKey;
+    if (objectCache && emitKind == EmitKind::Object) {
+        cacheKey = objectCache->ComputeKey(*module);
+        if (auto cached = objectCache->Load(cacheKey)) {
+            if (auto ec = WriteOutputFile(cached->getBuffer(), job.output)) {
+                result.errors.push_back({job.output.string(), ec.message(), 0});
+                return result;
+            }
+            result.succeeded = true;
+            return result;
+        }
+    }
+
+    if (!CheckProfile(result)) return result;
+    optimizer->Run(*module);
+
+    if (cacheKey.empty()) {
+        if (!emitter.Emit(*module, emitKind, job.output)) {
+            takeEmitErrors();
+            return result;
+        }
+        result.succeeded = true;
+        return result;
+    }
+
+    llvm::SmallVector<char, 0> object;
+    if (!emitter.EmitToBuffer(*module, EmitKind::Object, object)) {
+        takeEmitErrors();
+        return result;
+    }
+    const llvm::StringRef objectData(object.data(), object.size());
+    objectCache->Store(cacheKey, objectData);
+    if (auto ec = WriteOutputFile(objectData, job.output)) {
+        result.errors.push_back({job.output.string(), ec.message(), 0});
+        return result;
+    }
+    result.succeeded = true;
+    return result;
+}
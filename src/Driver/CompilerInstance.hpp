@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Analysis/ComptimeEvaluation.hpp"
+#include "CodeGen/ModuleEmitter.hpp"
+#include "CodeGen/ObjectCache.hpp"
+#include "CodeGen/Optimizer.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Utils/Diagnostics.hpp>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pl {
+    struct CompilerInstanceSettings {
+        TargetSettings target;
+        OptimizerSettings optimizer;        // Its level is taken from 'target'.
+        ComptimeLimits comptimeLimits;
+        DiagnosticsSettings diagnostics;    // For semantic analysis; its format does not matter here.
+        std::optional<ObjectCacheSettings> objectCache;
+
+        // Constants and metadata live as long as the LLVM context, so it is replaced after this many jobs.
+        size_t jobsPerContext = 256;
+    };
+
+    // One compilation: source files or directories of them, compiled into a single output whose kind follows
+    // its extension (.ll, .bc, .s, anything else an object file).
+    struct CompileJob {
+        std::vector<std::filesystem::path> inputs;
+        std::filesystem::path output;
+        std::string moduleName;         // Empty names it as 'fractac' would.
+    };
+
+    struct CompileResult {
+        bool succeeded = false;
+        std::vector<ErrorInfo> errors;
+        std::vector<ErrorInfo> warnings;
+    };
+
+    // Compiles many jobs in one process. The target machine, the optimizer, the object cache and the LLVM context
+    // are set up once and reused by every job, where a 'fractac' process pays for all of them per compile.
+    // Diagnostics are returned rather than printed, and nothing ends the process. An instance is not thread-safe;
+    // use one per thread to compile in parallel.
+    class CompilerInstance {
+        private:
+            CompilerInstanceSettings settings;
+            ModuleEmitter emitter;
+            std::unique_ptr<ModuleOptimizer> optimizer;
+            std::unique_ptr<DiskObjectCache> objectCache;
+            std::unique_ptr<llvm::MemoryBuffer> profile;
+            std::vector<ErrorInfo> setupErrors;
+
+            std::unique_ptr<llvm::LLVMContext> context;
+            size_t contextJobs = 0;
+
+        public:
+            explicit CompilerInstance(const CompilerInstanceSettings& settings = {});
+
+            // Target and profile setup errors; every job fails if there are any.
+            [[nodiscard]] bool HadErrors() const { return !setupErrors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return setupErrors; }
+
+            CompileResult Compile(const CompileJob& job);
+
+            // Compiles the jobs in order. A failing job does not stop the ones after it.
+            std::vector<CompileResult> CompileBatch(const std::vector<CompileJob>& jobs);
+
+        private:
+            llvm::LLVMContext& AcquireContext();
+
+            // The profile is read when the instance is created and is part of every cache key, so it must not
+            // change while the instance is in use.
+            bool CheckProfile(CompileResult& result) const;
+    };
+}
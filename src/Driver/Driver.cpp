@@ -0,0 +1,464 @@
+#include "Driver.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "Analysis/DeadFunctionElimination.hpp"
+#include "Analysis/SemanticAnalysis.hpp"
+#include "CodeGen/CodeGenerator.hpp"
+#include "CodeGen/JITEngine.hpp"
+#include "CodeGen/ModuleEmitter.hpp"
+#include "CodeGen/ObjectCache.hpp"
+#include "CodeGen/Optimizer.hpp"
+#include "CodeGen/ParallelCodeGen.hpp"
+#include "CodeGen/ThinLTO.hpp"
+#include "CodeGen/TieredCompiler.hpp"
+#include "Driver/Benchmark.hpp"
+#include "Driver/CompileServer.hpp"
+#include "Driver/FrontEnd.hpp"
+#include "Driver/LanguageServer.hpp"
+#include "Driver/Statistics.hpp"
+#include "Driver/Watch.hpp"
+#include "Interpreter/Interpreter.hpp"
+#include "Utils/Diagnostics.hpp"
+#include "Utils/SamplingProfiler.hpp"
+#include "Utils/SourceManager.hpp"
+#include "Utils/TimeTrace.hpp"
+#include "Utils/Utils.hpp"
+#include "VM/BytecodeCompiler.hpp"
+#include "VM/VirtualMachine.hpp"
+#include <Parsing/ASTPrinter.hpp>
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pl;
+
+static void PrintFlatProfile(const std::vector<uint64_t>& samples, const std::vector<JITFunctionRange>& functions) {
+    std::map<std::string_view, size_t> counts;
+    for (auto pc : samples) {
+        // Functions are sorted by address; find the last one starting at or before the sample.
+        auto it = std::ranges::upper_bound(functions, pc, {}, &JITFunctionRange::address);
+        if (it != functions.begin() && pc < std::prev(it)->address + std::prev(it)->size) counts[std::prev(it)->name]++;
+        else counts["[outside JIT code]"]++;
+    }
+
+    std::vector<std::pair<std::string_view, size_t>> sorted(counts.begin(), counts.end());
+    std::ranges::sort(sorted, std::greater {}, &std::pair<std::string_view, size_t>::second);
+
+    fmt::print("Flat profile ({} samples, inlined callees count towards their caller):\n", samples.size());
+    for (const auto& [name, count] : sorted) {
+        fmt::print("{:>7.2f}%{:>9}  {}\n", 100.0 * static_cast<double>(count) / static_cast<double>(samples.size()), count, name);
+    }
+}
+
+static int RunModule(const CompilerOptions& options, std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context) {
+    auto fracMain = module->getFunction("Main");
+    if (!fracMain || fracMain->isDeclaration() || fracMain->arg_size() != 0 || !fracMain->getReturnType()->isIntegerTy(32)) {
+        ReportErrors("Run errors.", {{module->getName().str(), "Program must define 'func Main() i32' to be run.", 0}}, true);
+    }
+
+    JITSettings settings;
+    settings.optLevel = options.optLevel;
+    settings.lazy = options.lazy;
+    settings.objectCache = options.objectCache;
+    settings.perfSupport = options.perf;
+    settings.recordSymbols = options.profile;
+
+    JITEngine jit(settings);
+    jit.AddModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+
+    if (options.profile) {
+        // Looked up first so that eager compilation is not part of the profile.
+        auto entry = reinterpret_cast<int32_t (*)()>(jit.Lookup("Main"));
+        if (!entry) {
+            ReportErrors("JIT errors.", jit.GetErrors(), true);
+        }
+
+        if (!SamplingProfiler::Start()) {
+            ReportErrors("Run errors.", {{"--profile", "Sampling is not supported on this platform.", 0}}, true);
+        }
+        const int result = entry();
+        PrintFlatProfile(SamplingProfiler::Stop(), jit.GetSymbolRegistry()->GetFunctions());
+        return result;
+    }
+
+    auto result = jit.RunMain();
+    if (!result) {
+        ReportErrors("JIT errors.", jit.GetErrors(), true);
+    }
+    return *result;
+}
+
+static int InterpretProgram(const CompilerOptions& options, const std::vector<FileSourceNodeSP>& files, std::string_view moduleName) {
+    InterpreterSettings settings;
+    settings.tierUpThreshold = options.tierThreshold.value_or(0);
+    settings.memoize = options.memoize;
+
+    Interpreter interpreter(files, settings);
+
+    auto fracMain = interpreter.FindFunction("Main");
+    if (!fracMain || !fracMain->body || !fracMain->args.empty() || TypeName(fracMain->returnType) != "i32") {
+        ReportErrors("Run errors.", {{std::string(moduleName), "Program must define 'func Main() i32' to be run.", 0}}, true);
+    }
+
+    // Without a threshold nothing is promoted, so the JIT is never created.
+    JITSettings jitSettings;
+    jitSettings.optLevel = options.optLevel;
+    jitSettings.objectCache = options.objectCache;
+
+    TieredCompiler tieredCompiler(files, moduleName, jitSettings);
+    interpreter.SetNativeTier(&tieredCompiler);
+
+    auto result = interpreter.Call("Main", {});
+    if (tieredCompiler.HadErrors()) {
+        ReportErrors("JIT errors, execution continued in the interpreter.", tieredCompiler.GetErrors());
+    }
+    if (!result) {
+        ReportErrors("Runtime errors.", interpreter.GetErrors(), true);
+    }
+    return static_cast<int>(std::get<int64_t>(*result));
+}
+
+static int RunBytecode(const BytecodeModule& module, std::string_view moduleName) {
+    auto fracMain = module.FindFunction("Main");
+    if (!fracMain || module.GetFunction(*fracMain).numArgs != 0 || module.GetFunction(*fracMain).returnKind != ValueKind::Integer) {
+        ReportErrors("Run errors.", {{std::string(moduleName), "Program must define 'func Main() i32' to be run.", 0}}, true);
+    }
+
+    VirtualMachine vm(module);
+    auto result = vm.Call(*fracMain, {});
+    if (!result) {
+        ReportErrors("Runtime errors.", vm.GetErrors(), true);
+    }
+    return static_cast<int32_t>(*result);
+}
+
+static int WriteText(std::string_view text, const std::optional<std::filesystem::path>& output) {
+    if (!output) {
+        fmt::print("{}", text);
+        return 0;
+    }
+    if (auto ec = WriteOutputFile(llvm::StringRef(text.data(), text.size()), *output)) {
+        ReportErrors("Emission errors.", {{output->string(), ec.message(), 0}}, true);
+    }
+    return 0;
+}
+
+int pl::RunDriver(const CompilerOptions& options, ParsedFileCache* parsedFiles) {
+    const auto& inputs = options.inputs;
+
+    if (options.mode == DriverMode::Daemon) {
+        return RunCompileServer(options);
+    }
+    if (options.mode == DriverMode::LanguageServer) {
+        return RunLanguageServer(options);
+    }
+
+    // Read by every pass manager as it is created, so it is set before any of them, or any worker thread, starts.
+    llvm::TimePassesIsEnabled = options.timePasses;
+    // Reports the code generation passes, which run on the legacy pass manager, on every successful return below.
+    const auto reportTimings = llvm::make_scope_exit([&] {
+        if (options.timePasses) llvm::reportAndResetTimings();
+    });
+
+    if (options.mode == DriverMode::LTOLink) {
+        TargetSettings targetSettings;
+        targetSettings.cpu = options.targetCpu;
+        targetSettings.features = options.targetFeatures;
+        targetSettings.optLevel = options.optLevel;
+
+        ThinLTOLinker linker(targetSettings, options.jobs.value_or(0));
+        if (!linker.Link(options.linkInputs, *options.output)) {
+            ReportErrors("Link errors.", linker.GetErrors(), true);
+        }
+        return 0;
+    }
+
+    if (options.watch) {
+        return RunWatching(options);
+    }
+
+    // An unnamed trace goes next to the output, or is named after the first input.
+    auto tracePath = options.timeTrace;
+    if (tracePath && tracePath->empty()) {
+        tracePath = options.output ? std::filesystem::path(*options.output).replace_extension(".json")
+            : std::filesystem::path(inputs.front().stem().string() + ".json");
+    }
+    TimeTraceSession timeTrace(tracePath, options.timeReport, options.timeTraceGranularity);
+    CompilerStatistics stats(options.stats, options.memReport, options.statsFile);
+
+    // Bytecode files are already compiled and verified on load, so they skip the front end entirely.
+    if (options.mode == DriverMode::Run && inputs.front().extension() == ".fbc") {
+        BytecodeModule module;
+        if (!module.Load(inputs.front())) {
+            ReportErrors("Bytecode errors.", module.GetErrors(), true);
+        }
+        return RunBytecode(module, inputs.front().stem().string());
+    }
+
+    // Input, parse and semantic errors go through one engine, for the error limit and the output format. It shows
+    // their source lines from the one copy of each file that is scanned.
+    SourceManager sources;
+    DiagnosticsEngine diagnostics(options.diagnostics);
+    diagnostics.SetSourceManager(&sources);
+    auto reportAndExit = [&](std::string_view header) {
+        diagnostics.Flush(header);
+        std::exit(1);
+    };
+
+    std::vector<ErrorInfo> inputErrors;
+    const auto files = CollectSourceFiles(inputs, inputErrors);
+    if (!inputErrors.empty()) {
+        diagnostics.Add(inputErrors);
+        reportAndExit("Input errors.");
+    }
+
+    stats.BeginPhase("Parse");
+    const bool lexOnly = options.emit == EmitStage::Tokens;
+    const bool useCache = parsedFiles && !lexOnly;
+    auto units = useCache ? parsedFiles->Update(files, options.jobs.value_or(0)) : LexAndParse(sources, files, options.jobs.value_or(0), lexOnly);
+    // The compile server has already brought the cache up to date for this request, so this counts its parsing too.
+    stats.Add("parsed files", useCache ? parsedFiles->TakeParsedCount() : files.size());
+
+    // Every file's diagnostics are reported before giving up, not only the first broken file's.
+    for (auto& unit : units) {
+        // The cache does not keep texts, so they are only loaded here, for diagnostics.
+        if (unit.file == InvalidFileID) {
+            std::error_code ec;
+            unit.file = sources.Load(unit.path, ec);
+            if (unit.ast) unit.ast->file = unit.file;
+        }
+        diagnostics.Add(unit.errors, false, unit.file);
+        stats.Add("files", 1);
+        stats.Add("tokens", unit.tokenCount);
+        if (unit.ast) stats.CountASTNodes(*unit.ast);
+    }
+    stats.AddDiagnostics(diagnostics.GetErrorCount());
+    if (diagnostics.HadErrors()) {
+        // Scanner and parser errors of a file are collected separately.
+        diagnostics.SortByLocation();
+        reportAndExit("Parsing errors.");
+    }
+
+    if (options.emit == EmitStage::Tokens || options.emit == EmitStage::AST) {
+        std::string text;
+        for (const auto& unit : units) {
+            if (options.emit == EmitStage::AST) {
+                text += PrintAST(*unit.ast);
+                continue;
+            }
+            for (const auto& token : unit.tokens) {
+                text += fmt::format("{}:{}: {}\n", unit.path.filename().string(), token.lineNumber, token.ToString());
+            }
+        }
+        return WriteText(text, options.output);
+    }
+
+    std::vector<FileSourceNodeSP> nodes;
+    for (auto& unit : units) nodes.push_back(std::move(unit.ast));
+
+    // A single file names the module; a multi-file program is named after its output.
+    const auto moduleName = files.size() == 1 ? files.front().stem().string()
+        : options.output ? options.output->stem().string()
+        : std::string("main");
+
+    // '--emit' overrides the kind implied by the output extension.
+    auto output = options.output;
+    if (options.emit == EmitStage::Object && !output) output = moduleName + ".o";
+    auto emitKind = output ? EmitKindFromPath(*output) : EmitKind::IR;
+    if (options.emit == EmitStage::IR) emitKind = EmitKind::IR;
+    if (options.emit == EmitStage::Object) emitKind = EmitKind::Object;
+
+    stats.BeginPhase("Sema");
+    SemanticAnalyzer sema(nodes, moduleName, options.diagnostics);
+    sema.SetComptimeLimits(options.comptimeLimits);
+    sema.Analyze();
+    stats.Add("symbols", sema.GetSymbolTable().GetInsertedSymbolCount());
+    stats.Add("scopes", sema.GetSymbolTable().GetCreatedScopeCount());
+    auto& semaDiagnostics = sema.GetDiagnostics();
+    semaDiagnostics.SetSourceManager(&sources);
+    stats.AddDiagnostics(semaDiagnostics.Size() + semaDiagnostics.GetDroppedCount());
+    // Global symbols are checked for all files before any body.
+    semaDiagnostics.SortByLocation();
+    if (sema.HadErrors()) {
+        semaDiagnostics.Flush("Semantic analysis errors.");
+        std::exit(1);
+    }
+    semaDiagnostics.Flush("Semantic analysis warnings.");
+
+    if (options.syntaxOnly) {
+        return 0;
+    }
+
+    stats.BeginPhase("DeadFunctions");
+    DeadFunctionEliminator deadFunctions;
+    deadFunctions.Run(nodes);
+    stats.Add("removed functions", deadFunctions.GetRemoved().size());
+    if (options.reportDeadFunctions) {
+        const auto& removed = deadFunctions.GetRemoved();
+        fmt::print(stderr, "Removed {} of {} functions unreachable from 'Main' and exports", removed.size(), deadFunctions.GetTotalCount());
+        fmt::print(stderr, "{}{}\n", removed.empty() ? "." : ": ", fmt::join(removed, ", "));
+    }
+
+    stats.BeginPhase("Fold");
+    ConstantFolder folder;
+    for (const auto& node : nodes) folder.Fold(node);
+    stats.Add("folded expressions", static_cast<uint64_t>(folder.GetFoldCount()));
+
+    // Running the program is not part of the compiler's own cost.
+    if (options.mode != DriverMode::Compile) stats.EndPhase();
+
+    if (options.mode == DriverMode::Run && (options.interpret || options.tierThreshold)) {
+        return InterpretProgram(options, nodes, moduleName);
+    }
+    if (options.mode == DriverMode::Bench) {
+        return RunBenchmark(options, nodes, moduleName);
+    }
+
+    if ((options.mode == DriverMode::Run && options.vm) || (options.emit == EmitStage::Default && output && output->extension() == ".fbc")) {
+        stats.BeginPhase("Bytecode");
+        BytecodeCompiler compiler;
+        auto image = compiler.Compile(nodes);
+        if (image.empty()) {
+            stats.AddDiagnostics(compiler.GetErrors().size());
+            ReportErrors("Bytecode errors.", compiler.GetErrors(), true);
+        }
+
+        if (options.mode == DriverMode::Compile) {
+            const llvm::StringRef data(reinterpret_cast<const char*>(image.data()), image.size());
+            if (auto ec = WriteOutputFile(data, *output)) {
+                ReportErrors("Emission errors.", {{output->string(), ec.message(), 0}}, true);
+            }
+            return 0;
+        }
+
+        BytecodeModule module;
+        if (!module.Adopt(std::move(image))) {
+            ReportErrors("Bytecode errors.", module.GetErrors(), true);
+        }
+        return RunBytecode(module, moduleName);
+    }
+
+    stats.BeginPhase("CodeGen");
+    auto context = std::make_unique<llvm::LLVMContext>();
+    CodeGenerator codegen(*context, moduleName);
+    auto module = codegen.Generate(nodes);
+    if (!module) {
+        stats.AddDiagnostics(codegen.GetErrors().size());
+        ReportErrors("Code generation errors.", codegen.GetErrors(), true);
+    }
+
+    if (options.mode == DriverMode::Run) {
+        stats.EndPhase();
+        return RunModule(options, std::move(module), std::move(context));
+    }
+
+    TargetSettings targetSettings;
+    targetSettings.cpu = options.targetCpu;
+    targetSettings.features = options.targetFeatures;
+    targetSettings.optLevel = options.optLevel;
+
+    ModuleEmitter emitter(targetSettings);
+    if (emitter.HadErrors()) {
+        ReportErrors("Target errors.", emitter.GetErrors(), true);
+    }
+    emitter.PrepareModule(*module);
+
+    OptimizerSettings optimizerSettings;
+    optimizerSettings.level = options.optLevel;
+    optimizerSettings.printPipeline = options.printPipeline;
+    optimizerSettings.timePasses = options.timePasses;
+    optimizerSettings.thinLTOPreLink = options.thinLTO;
+    optimizerSettings.profileGenerate = options.profileGenerate;
+    optimizerSettings.profileUse = options.profileUse;
+
+    // Checked up front, as the profile loader reports a missing file as a fatal LLVM diagnostic.
+    std::unique_ptr<llvm::MemoryBuffer> profile;
+    if (!options.profileUse.empty()) {
+        auto buffer = llvm::MemoryBuffer::getFile(options.profileUse);
+        if (!buffer) {
+            ReportErrors("Profile errors.", {{options.profileUse, buffer.getError().message(), 0}}, true);
+        }
+        profile = std::move(*buffer);
+    }
+
+    std::unique_ptr<DiskObjectCache> objectCache;
+    if (options.objectCache) {
+        objectCache = std::make_unique<DiskObjectCache>(*options.objectCache, *emitter.GetTargetMachine(), options.optLevel);
+        if (profile) objectCache->AddKeyInput(profile->getBuffer());
+        if (!options.profileGenerate.empty()) objectCache->AddKeyInput(options.profileGenerate);
+    }
+
+    if (options.jobs) {
+        stats.BeginPhase("ParallelCodeGen");
+        // "-" makes the emitter write to stdout.
+        const auto path = output.value_or("-");
+
+        ParallelCodeGen parallelCodegen(targetSettings, optimizerSettings, *options.jobs);
+        parallelCodegen.SetObjectCache(objectCache.get());
+        if (!parallelCodegen.Emit(*module, emitKind, path)) {
+            ReportErrors("Emission errors.", parallelCodegen.GetErrors(), true);
+        }
+        return 0;
+    }
+
+    if (options.thinLTO) {
+        stats.BeginPhase("Optimize");
+        ModuleOptimizer(emitter.GetTargetMachine(), optimizerSettings).Run(*module);
+        if (!emitter.Emit(*module, EmitKind::SummaryBitcode, *output)) {
+            ReportErrors("Emission errors.", emitter.GetErrors(), true);
+        }
+        return 0;
+    }
+
+    // Objects are cached by the unoptimised module, so a hit skips optimisation as well as code generation.
+    std::string cacheKey;
+    if (objectCache && output && emitKind == EmitKind::Object) {
+        cacheKey = objectCache->ComputeKey(*module);
+        if (auto cached = objectCache->Load(cacheKey)) {
+            if (auto ec = WriteOutputFile(cached->getBuffer(), *output)) {
+                ReportErrors("Emission errors.", {{output->string(), ec.message(), 0}}, true);
+            }
+            return 0;
+        }
+    }
+
+    stats.BeginPhase("Optimize");
+    ModuleOptimizer optimizer(emitter.GetTargetMachine(), optimizerSettings);
+    optimizer.Run(*module);
+
+    stats.BeginPhase("Emit");
+    if (!output) {
+        module->print(llvm::outs(), nullptr);
+        return 0;
+    }
+
+    if (!cacheKey.empty()) {
+        llvm::SmallVector<char, 0> object;
+        if (!emitter.EmitToBuffer(*module, EmitKind::Object, object)) {
+            ReportErrors("Emission errors.", emitter.GetErrors(), true);
+        }
+
+        const llvm::StringRef objectData(object.data(), object.size());
+        objectCache->Store(cacheKey, objectData);
+        if (auto ec = WriteOutputFile(objectData, *output)) {
+            ReportErrors("Emission errors.", {{output->string(), ec.message(), 0}}, true);
+        }
+    }
+    else if (!emitter.Emit(*module, emitKind, *output)) {
+        ReportErrors("Emission errors.", emitter.GetErrors(), true);
+    }
+
+    return 0;
+}
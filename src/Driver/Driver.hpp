@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Driver/FrontEnd.hpp"
+#include "Driver/Options.hpp"
+
+namespace pl {
+    // Compiles, runs or benchmarks the program the options describe. Diagnostics are printed as they are found,
+    // and any error ends the process with status 1. Returns the process exit status otherwise.
+    // The compile server passes its cache of parsed files, which must be up to date for the inputs.
+    int RunDriver(const CompilerOptions& options, ParsedFileCache* parsedFiles = nullptr);
+}
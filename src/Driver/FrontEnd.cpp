@@ -0,0 +1,142 @@
+#include "FrontEnd.hpp"
+#include "Utils/TimeTrace.hpp"
+#include <Parsing/Parser.hpp>
+#include <Parsing/Scanner.hpp>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <algorithm>
+#include <system_error>
+
+using namespace pl;
+
+std::vector<std::filesystem::path> pl::CollectSourceFiles(const std::vector<std::filesystem::path>& inputs, std::vector<ErrorInfo>& errors) {
+    std::vector<std::filesystem::path> files;
+
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(input, ec)) {
+            if (!std::filesystem::exists(input, ec)) errors.push_back({input.string(), "No such file or directory.", 0});
+            else files.push_back(input);
+            continue;
+        }
+
+        std::vector<std::filesystem::path> found;
+        for (std::filesystem::recursive_directory_iterator it(input, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".fr") found.push_back(it->path());
+        }
+
+        if (ec) errors.push_back({input.string(), ec.message(), 0});
+        else if (found.empty()) errors.push_back({input.string(), "Directory contains no '.fr' files.", 0});
+
+        std::ranges::sort(found);
+        files.insert(files.end(), found.begin(), found.end());
+    }
+
+    return files;
+}
+
+static void LexUnit(SourceManager& sources, SourceUnit& unit) {
+    std::error_code ec;
+    unit.file = sources.Load(unit.path, ec);
+    if (ec) {
+        unit.errors.push_back({unit.path.string(), "Cannot open file.", 0});
+        return;
+    }
+
+    auto scanner = Scanner::FromSource(sources, unit.file);
+    unit.tokens = scanner.ScanAll();
+    unit.tokenCount = unit.tokens.size();
+    unit.errors = scanner.GetErrors();
+}
+
+static void ParseUnit(SourceUnit& unit) {
+    auto parser = SourceParser::FromTokens(std::move(unit.tokens), unit.path.filename().string());
+    unit.tokens.clear();
+    unit.ast = parser.Parse();
+    unit.ast->file = unit.file;
+    unit.errors = parser.GetErrors();
+}
+
+std::vector<SourceUnit> pl::LexAndParse(SourceManager& sources, const std::vector<std::filesystem::path>& files, unsigned threads, bool lexOnly) {
+    std::vector<SourceUnit> units(files.size());
+    for (size_t i = 0; i < files.size(); i++) units[i].path = files[i];
+
+    // Every file is lexed by its own task, which queues the file's parse when it is done. Units are only
+    // touched by their own tasks, so no locking is needed.
+    const bool tracing = llvm::timeTraceProfilerEnabled();
+    llvm::DefaultThreadPool pool(llvm::hardware_concurrency(threads));
+    for (auto& unit : units) {
+        pool.async([&pool, &sources, &unit, lexOnly, tracing] {
+            TimeTraceWorkerScope traceScope(tracing);
+            LexUnit(sources, unit);
+            if (!lexOnly && unit.errors.empty()) {
+                pool.async([&unit, tracing] {
+                    TimeTraceWorkerScope traceScope(tracing);
+                    ParseUnit(unit);
+                });
+            }
+        });
+    }
+    pool.wait();
+
+    return units;
+}
+
+// Tokens are dropped once a file is parsed, and are not copyable, so only the parse results are shared. The text
+// is not kept, so the unit has no file id.
+static SourceUnit ShareParsed(const SourceUnit& unit, const std::filesystem::path& path) {
+    return {path, InvalidFileID, {}, unit.tokenCount, unit.ast, unit.errors};
+}
+
+std::vector<SourceUnit> ParsedFileCache::Update(const std::vector<std::filesystem::path>& files, unsigned threads) {
+    struct Stamp {
+        std::string key;
+        std::filesystem::file_time_type modified;
+        uintmax_t size = 0;
+        bool valid = false;     // Unreadable files are never cached, so their errors are always current.
+    };
+
+    std::vector<Stamp> stamps(files.size());
+    std::vector<std::filesystem::path> stale;
+    std::vector<size_t> staleIndices;
+
+    for (size_t i = 0; i < files.size(); i++) {
+        std::error_code ec;
+        auto& stamp = stamps[i];
+        stamp.key = std::filesystem::weakly_canonical(files[i], ec).string();
+        if (ec) stamp.key = files[i].string();
+        stamp.modified = std::filesystem::last_write_time(files[i], ec);
+        if (!ec) stamp.size = std::filesystem::file_size(files[i], ec);
+        stamp.valid = !ec;
+
+        auto it = entries.find(stamp.key);
+        if (!stamp.valid || it == entries.end() || it->second.modified != stamp.modified || it->second.size != stamp.size) {
+            stale.push_back(files[i]);
+            staleIndices.push_back(i);
+        }
+    }
+
+    std::vector<SourceUnit> units(files.size());
+    std::vector<bool> isStale(files.size(), false);
+
+    // Only the parse results are kept, and they do not refer to the text.
+    SourceManager sources;
+    auto fresh = LexAndParse(sources, stale, threads, false);
+    for (size_t i = 0; i < fresh.size(); i++) {
+        const auto index = staleIndices[i];
+        const auto& stamp = stamps[index];
+        isStale[index] = true;
+        units[index] = ShareParsed(fresh[i], files[index]);
+
+        if (stamp.valid) entries[stamp.key] = {stamp.modified, stamp.size, std::move(fresh[i])};
+        else entries.erase(stamp.key);
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        if (isStale[i]) continue;
+        units[i] = ShareParsed(entries.at(stamps[i].key).unit, files[i]);
+    }
+
+    parsedCount += stale.size();
+    return units;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Common/ErrorInfo.hpp>
+#include <Common/FileID.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <Parsing/Token.hpp>
+#include <Utils/SourceManager.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pl {
+    // One input file as it moves through the front end.
+    struct SourceUnit {
+        std::filesystem::path path;
+        FileID file = InvalidFileID;    // Invalid for units that come from the parsed-file cache.
+        std::vector<Token> tokens;      // Handed to the parser, so only kept when lexing is all that runs.
+        size_t tokenCount = 0;
+        FileSourceNodeSP ast;
+        std::vector<ErrorInfo> errors;
+    };
+
+    // Expands directories into the '.fr' files below them, sorted so the order does not depend on the file system.
+    std::vector<std::filesystem::path> CollectSourceFiles(const std::vector<std::filesystem::path>& inputs, std::vector<ErrorInfo>& errors);
+
+    // Lexes and parses the files on a pool of 'threads' workers, 0 meaning one per hardware thread. Each file is
+    // parsed as soon as it has been lexed, so parsing one file overlaps lexing the next. Units keep input order.
+    // Files are loaded into 'sources', and scanned in place.
+    std::vector<SourceUnit> LexAndParse(SourceManager& sources, const std::vector<std::filesystem::path>& files, unsigned threads, bool lexOnly);
+
+    // Parsed files kept in memory by the compile server. Entries are revalidated against each file's modification
+    // time and size whenever they are used, so edits are picked up without watching the file system. Units share
+    // their ASTs with the cache, and analysis rewrites ASTs, so they must be analysed in a forked process.
+    class ParsedFileCache {
+        private:
+            struct Entry {
+                std::filesystem::file_time_type modified;
+                uintmax_t size = 0;
+                SourceUnit unit;
+            };
+
+            std::unordered_map<std::string, Entry> entries;
+            size_t parsedCount = 0;
+
+        public:
+            // Parses the files that are new or changed since they were cached, and returns the units of all of them,
+            // in order.
+            std::vector<SourceUnit> Update(const std::vector<std::filesystem::path>& files, unsigned threads);
+
+            // How many files Update had to parse since this was last called.
+            size_t TakeParsedCount() { return std::exchange(parsedCount, 0); }
+
+            [[nodiscard]] size_t Size() const { return entries.size(); }
+    };
+}
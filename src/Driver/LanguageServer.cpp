@@ -0,0 +1,499 @@
+#include "LanguageServer.hpp"
+#include "Driver/FrontEnd.hpp"
+#include "Driver/Workspace.hpp"
+#include "fmt/core.h"
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+using namespace pl;
+
+namespace {
+    // JSON-RPC error codes used by the protocol.
+    constexpr int64_t ParseError = -32700;
+    constexpr int64_t MethodNotFound = -32601;
+
+    // Larger messages are refused rather than allocated; a whole document is far smaller.
+    constexpr size_t MaxMessageLength = size_t {64} << 20;
+
+    std::string NormalizePath(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto absolute = std::filesystem::absolute(path, ec);
+        return (ec ? path : absolute).lexically_normal().string();
+    }
+
+    std::string PathFromUri(llvm::StringRef uri) {
+        if (!uri.consume_front("file://")) return uri.str();
+
+        std::string path;
+        for (size_t i = 0; i < uri.size(); i++) {
+            unsigned value = 0;
+            if (uri[i] == '%' && i + 2 < uri.size() && !uri.substr(i + 1, 2).getAsInteger(16, value)) {
+                path += static_cast<char>(value);
+                i += 2;
+            }
+            else path += uri[i];
+        }
+        return NormalizePath(path);
+    }
+
+    std::string UriFromPath(std::string_view path) {
+        std::string uri = "file://";
+        for (const char c : path) {
+            if (std::isalnum(static_cast<unsigned char>(c)) || std::string_view("/-._~").find(c) != std::string_view::npos) uri += c;
+            else uri += fmt::format("%{:02X}", static_cast<unsigned char>(c));
+        }
+        return uri;
+    }
+
+    std::optional<std::string> ReadFile(const std::string& path) {
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if (!buffer) return std::nullopt;
+        return (*buffer)->getBuffer().str();
+    }
+
+    // Bytes in the UTF-8 sequence a byte starts; stray continuation bytes count as one each.
+    size_t SequenceLength(unsigned char lead) {
+        if (lead >= 0xF0) return 4;
+        if (lead >= 0xE0) return 3;
+        if (lead >= 0xC0) return 2;
+        return 1;
+    }
+
+    // Converts a column in UTF-16 code units, the protocol's default, to a byte column. Columns past the end of the
+    // line, or inside a character, are left for the workspace to clamp.
+    int ByteColumn(std::string_view line, int character) {
+        size_t byte = 0;
+        int units = 0;
+        while (units < character && byte < line.size()) {
+            const auto length = SequenceLength(static_cast<unsigned char>(line[byte]));
+            byte += length;
+            units += length == 4 ? 2 : 1;
+        }
+        return static_cast<int>(byte) + std::max(character - units, 0);
+    }
+
+    int UTF16Column(std::string_view line, int column) {
+        int units = 0;
+        for (size_t byte = 0; byte < line.size() && byte < static_cast<size_t>(column); ) {
+            const auto length = SequenceLength(static_cast<unsigned char>(line[byte]));
+            byte += length;
+            units += length == 4 ? 2 : 1;
+        }
+        return units;
+    }
+
+    llvm::json::Object MakePosition(int line, int character) {
+        return llvm::json::Object {{"line", line}, {"character", character}};
+    }
+
+    llvm::json::Object MakeRange(int line, int startCharacter, int endLine, int endCharacter) {
+        return llvm::json::Object {{"start", MakePosition(line, startCharacter)}, {"end", MakePosition(endLine, endCharacter)}};
+    }
+
+    class LanguageServer {
+        private:
+            Workspace workspace;
+            std::string root;
+            bool logUpdates = false;
+            std::unordered_set<std::string> openDocuments;
+            std::map<std::string, std::vector<Diagnostic>> published;
+            bool shutdownRequested = false;
+            bool utf8Positions = false;     // Whether the client agreed to byte columns instead of UTF-16 ones.
+
+        public:
+            // With 'logUpdates', the time and the chunks parsed and analysed are printed to stderr on every update.
+            explicit LanguageServer(bool logUpdates) : logUpdates(logUpdates) { }
+
+            // Returns the exit status once the client sent 'exit' or closed the connection.
+            int Run();
+
+        private:
+            std::optional<std::string> ReadMessage();
+            void Send(llvm::json::Value message);
+            void Reply(const llvm::json::Value& id, llvm::json::Value result);
+            void ReplyError(const llvm::json::Value& id, int64_t code, std::string msg);
+            void Notify(llvm::StringRef method, llvm::json::Value params);
+
+            // Handles one request or notification, and returns false on 'exit'.
+            bool Handle(const llvm::json::Object& message);
+
+            llvm::json::Value Initialize(const llvm::json::Object& params);
+            void DidOpen(const llvm::json::Object& params);
+            void DidChange(const llvm::json::Object& params);
+            void DidClose(const llvm::json::Object& params);
+            void DidChangeWatchedFiles(const llvm::json::Object& params);
+            llvm::json::Value Definition(const llvm::json::Object& params);
+            llvm::json::Value Hover(const llvm::json::Object& params);
+            llvm::json::Value DocumentSymbols(const llvm::json::Object& params);
+
+            // Convert between the client's columns and the workspace's byte columns on a line of a document.
+            [[nodiscard]] int ToByteColumn(const std::string& path, int line, int character) const;
+            [[nodiscard]] int ToClientColumn(const std::string& path, int line, int column) const;
+            [[nodiscard]] llvm::json::Object MakeDocumentRange(const std::string& path, int line, int startColumn, int endLine, int endColumn) const;
+
+            // Reloads a document from disk, or drops it if it is gone or outside the workspace root.
+            void Reload(const std::string& path);
+            // Updates the workspace and publishes the diagnostics that changed.
+            void Refresh();
+    };
+
+    // The document and position of textDocument/definition and textDocument/hover.
+    struct TextPosition {
+        std::string path;
+        int line = 0;
+        int character = 0;
+    };
+
+    std::optional<TextPosition> GetTextPosition(const llvm::json::Object& params) {
+        auto document = params.getObject("textDocument");
+        auto position = params.getObject("position");
+        if (!document || !position) return std::nullopt;
+
+        auto uri = document->getString("uri");
+        auto line = position->getInteger("line");
+        auto character = position->getInteger("character");
+        if (!uri || !line || !character) return std::nullopt;
+        return TextPosition {PathFromUri(*uri), static_cast<int>(*line), static_cast<int>(*character)};
+    }
+
+    std::string GetDocumentPath(const llvm::json::Object& params) {
+        auto document = params.getObject("textDocument");
+        if (!document) return {};
+        auto uri = document->getString("uri");
+        return uri ? PathFromUri(*uri) : std::string();
+    }
+
+    int LanguageServer::Run() {
+        while (auto content = ReadMessage()) {
+            auto message = llvm::json::parse(*content);
+            if (!message) {
+                ReplyError(nullptr, ParseError, llvm::toString(message.takeError()));
+                continue;
+            }
+            auto object = message->getAsObject();
+            if (object && !Handle(*object)) break;
+        }
+        return shutdownRequested ? 0 : 1;
+    }
+
+    std::optional<std::string> LanguageServer::ReadMessage() {
+        while (true) {
+            std::optional<size_t> length;
+            std::string header;
+            while (true) {
+                header.clear();
+                int c;
+                while ((c = std::getc(stdin)) != EOF && c != '\n') header += static_cast<char>(c);
+                if (c == EOF) return std::nullopt;
+                if (!header.empty() && header.back() == '\r') header.pop_back();
+                if (header.empty()) break;
+
+                llvm::StringRef field(header);
+                size_t value;
+                if (field.consume_front("Content-Length:") && !field.trim().getAsInteger(10, value)) length = value;
+            }
+
+            if (!length) {
+                ReplyError(nullptr, ParseError, "Message without a valid 'Content-Length' header.");
+                continue;
+            }
+            if (*length > MaxMessageLength) {
+                ReplyError(nullptr, ParseError, fmt::format("Message of {} bytes is over the limit of {} bytes.", *length, MaxMessageLength));
+                // Skipped without being stored, so that the next message can be read.
+                char discarded[4096];
+                for (size_t left = *length; left > 0; ) {
+                    const auto read = std::fread(discarded, 1, std::min(left, sizeof(discarded)), stdin);
+                    if (read == 0) return std::nullopt;
+                    left -= read;
+                }
+                continue;
+            }
+
+            std::string content(*length, '\0');
+            if (std::fread(content.data(), 1, *length, stdin) != *length) return std::nullopt;
+            return content;
+        }
+    }
+
+    void LanguageServer::Send(llvm::json::Value message) {
+        std::string content;
+        llvm::raw_string_ostream stream(content);
+        stream << message;
+        stream.flush();
+
+        fmt::print(stdout, "Content-Length: {}\r\n\r\n{}", content.size(), content);
+        std::fflush(stdout);
+    }
+
+    void LanguageServer::Reply(const llvm::json::Value& id, llvm::json::Value result) {
+        Send(llvm::json::Object {{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+    }
+
+    void LanguageServer::ReplyError(const llvm::json::Value& id, int64_t code, std::string msg) {
+        Send(llvm::json::Object {
+            {"jsonrpc", "2.0"},
+            {"id", id},
+            {"error", llvm::json::Object {{"code", code}, {"message", std::move(msg)}}},
+        });
+    }
+
+    void LanguageServer::Notify(llvm::StringRef method, llvm::json::Value params) {
+        Send(llvm::json::Object {{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+    }
+
+    bool LanguageServer::Handle(const llvm::json::Object& message) {
+        auto methodField = message.getString("method");
+        if (!methodField) return true;   // A response to a request of ours; none are sent.
+
+        const auto method = methodField->str();
+        const auto id = message.get("id");
+        static const llvm::json::Object NoParams;
+        const auto paramsField = message.getObject("params");
+        const auto& params = paramsField ? *paramsField : NoParams;
+
+        // Notifications have no id and get no reply.
+        if (!id) {
+            if (method == "exit") return false;
+            if (method == "textDocument/didOpen") DidOpen(params);
+            else if (method == "textDocument/didChange") DidChange(params);
+            else if (method == "textDocument/didClose") DidClose(params);
+            else if (method == "workspace/didChangeWatchedFiles") DidChangeWatchedFiles(params);
+            return true;
+        }
+
+        if (method == "initialize") {
+            Reply(*id, Initialize(params));
+            Refresh();
+        }
+        else if (method == "shutdown") {
+            shutdownRequested = true;
+            Reply(*id, nullptr);
+        }
+        else if (method == "textDocument/definition") Reply(*id, Definition(params));
+        else if (method == "textDocument/hover") Reply(*id, Hover(params));
+        else if (method == "textDocument/documentSymbol") Reply(*id, DocumentSymbols(params));
+        else ReplyError(*id, MethodNotFound, fmt::format("Unsupported method '{}'.", method));
+        return true;
+    }
+
+    llvm::json::Value LanguageServer::Initialize(const llvm::json::Object& params) {
+        if (auto uri = params.getString("rootUri")) root = PathFromUri(*uri);
+        else if (auto path = params.getString("rootPath")) root = NormalizePath(path->str());
+
+        // Positions count UTF-16 code units unless the client also offers UTF-8.
+        auto capabilities = params.getObject("capabilities");
+        auto general = capabilities ? capabilities->getObject("general") : nullptr;
+        if (auto encodings = general ? general->getArray("positionEncodings") : nullptr) {
+            utf8Positions = std::ranges::any_of(*encodings, [](const llvm::json::Value& encoding) {
+                auto name = encoding.getAsString();
+                return name && *name == "utf-8";
+            });
+        }
+
+        if (!root.empty()) {
+            std::vector<ErrorInfo> errors;
+            for (const auto& file : CollectSourceFiles({root}, errors)) {
+                const auto path = NormalizePath(file);
+                if (auto text = ReadFile(path)) workspace.SetDocument(path, std::move(*text));
+            }
+        }
+
+        return llvm::json::Object {
+            {"capabilities", llvm::json::Object {
+                // Incremental: edits arrive as ranges rather than the whole document.
+                {"positionEncoding", utf8Positions ? "utf-8" : "utf-16"},
+                {"textDocumentSync", llvm::json::Object {{"openClose", true}, {"change", 2}}},
+                {"definitionProvider", true},
+                {"hoverProvider", true},
+                {"documentSymbolProvider", true},
+            }},
+            {"serverInfo", llvm::json::Object {{"name", "fractac"}}},
+        };
+    }
+
+    void LanguageServer::DidOpen(const llvm::json::Object& params) {
+        auto document = params.getObject("textDocument");
+        const auto path = GetDocumentPath(params);
+        if (path.empty()) return;
+        auto text = document->getString("text");
+        if (!text) return;
+
+        openDocuments.insert(path);
+        workspace.SetDocument(path, text->str());
+        Refresh();
+    }
+
+    void LanguageServer::DidChange(const llvm::json::Object& params) {
+        const auto path = GetDocumentPath(params);
+        auto changes = params.getArray("contentChanges");
+        if (!workspace.HasDocument(path) || !changes) return;
+
+        for (const auto& change : *changes) {
+            auto object = change.getAsObject();
+            if (!object) continue;
+            auto text = object->getString("text");
+            if (!text) continue;
+
+            auto range = object->getObject("range");
+            auto start = range ? range->getObject("start") : nullptr;
+            auto end = range ? range->getObject("end") : nullptr;
+            if (!start || !end) {
+                workspace.SetDocument(path, text->str());
+                continue;
+            }
+
+            auto position = [](const llvm::json::Object* pos, llvm::StringRef field) {
+                auto value = pos->getInteger(field);
+                return value ? static_cast<int>(*value) : 0;
+            };
+            const auto startLine = position(start, "line");
+            const auto endLine = position(end, "line");
+            workspace.EditDocument(path, startLine, ToByteColumn(path, startLine, position(start, "character")),
+                endLine, ToByteColumn(path, endLine, position(end, "character")), *text);
+        }
+        Refresh();
+    }
+
+    void LanguageServer::DidClose(const llvm::json::Object& params) {
+        const auto path = GetDocumentPath(params);
+        openDocuments.erase(path);
+        Reload(path);
+        Refresh();
+    }
+
+    void LanguageServer::DidChangeWatchedFiles(const llvm::json::Object& params) {
+        auto changes = params.getArray("changes");
+        if (!changes) return;
+
+        for (const auto& change : *changes) {
+            auto object = change.getAsObject();
+            if (!object) continue;
+            auto uri = object->getString("uri");
+            if (!uri) continue;
+
+            // Open documents are ahead of the files on disk.
+            const auto path = PathFromUri(*uri);
+            if (!openDocuments.contains(path)) Reload(path);
+        }
+        Refresh();
+    }
+
+    int LanguageServer::ToByteColumn(const std::string& path, int line, int character) const {
+        return utf8Positions ? character : ByteColumn(workspace.GetLine(path, line), character);
+    }
+
+    int LanguageServer::ToClientColumn(const std::string& path, int line, int column) const {
+        return utf8Positions ? column : UTF16Column(workspace.GetLine(path, line), column);
+    }
+
+    llvm::json::Object LanguageServer::MakeDocumentRange(const std::string& path, int line, int startColumn, int endLine, int endColumn) const {
+        return MakeRange(line, ToClientColumn(path, line, startColumn), endLine, ToClientColumn(path, endLine, endColumn));
+    }
+
+    void LanguageServer::Reload(const std::string& path) {
+        const bool inRoot = !root.empty() && std::string_view(path).starts_with(root + "/");
+        auto text = inRoot && std::filesystem::path(path).extension() == ".fr" ? ReadFile(path) : std::nullopt;
+        if (text) workspace.SetDocument(path, std::move(*text));
+        else workspace.RemoveDocument(path);
+    }
+
+    void LanguageServer::Refresh() {
+        const auto start = std::chrono::steady_clock::now();
+        workspace.Update();
+        if (logUpdates) {
+            const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            fmt::print(stderr, "Updated in {:.1f} ms: parsed {} and analysed {} of {} declaration chunks.\n",
+                elapsed, workspace.GetParsedCount(), workspace.GetAnalyzedCount(), workspace.GetChunkCount());
+        }
+
+        auto publish = [&](const std::string& path, const std::vector<Diagnostic>& diagnostics) {
+            llvm::json::Array items;
+            for (const auto& diagnostic : diagnostics) {
+                const auto text = workspace.GetLine(path, diagnostic.line);
+                const auto indent = text.find_first_not_of(" \t");
+                items.push_back(llvm::json::Object {
+                    {"range", MakeDocumentRange(path, diagnostic.line, indent == std::string_view::npos ? 0 : static_cast<int>(indent),
+                        diagnostic.line, static_cast<int>(text.size()))},
+                    {"severity", diagnostic.isWarning ? 2 : 1},
+                    {"source", "fractac"},
+                    {"message", diagnostic.msg},
+                });
+            }
+            Notify("textDocument/publishDiagnostics", llvm::json::Object {{"uri", UriFromPath(path)}, {"diagnostics", std::move(items)}});
+        };
+
+        for (auto it = published.begin(); it != published.end(); ) {
+            if (workspace.HasDocument(it->first)) it++;
+            else {
+                publish(it->first, {});
+                it = published.erase(it);
+            }
+        }
+        for (const auto& path : workspace.GetPaths()) {
+            auto diagnostics = workspace.GetDiagnostics(path);
+            auto& last = published[path];
+            if (diagnostics == last) continue;
+
+            publish(path, diagnostics);
+            last = std::move(diagnostics);
+        }
+    }
+
+    llvm::json::Value LanguageServer::Definition(const llvm::json::Object& params) {
+        auto position = GetTextPosition(params);
+        auto location = position
+            ? workspace.FindDefinition(position->path, position->line, ToByteColumn(position->path, position->line, position->character))
+            : std::nullopt;
+        if (!location) return nullptr;
+
+        return llvm::json::Object {
+            {"uri", UriFromPath(location->path)},
+            {"range", MakeDocumentRange(location->path, location->line, location->column, location->line, location->column + location->length)},
+        };
+    }
+
+    llvm::json::Value LanguageServer::Hover(const llvm::json::Object& params) {
+        auto position = GetTextPosition(params);
+        auto description = position
+            ? workspace.Describe(position->path, position->line, ToByteColumn(position->path, position->line, position->character))
+            : std::nullopt;
+        if (!description) return nullptr;
+
+        return llvm::json::Object {{"contents", llvm::json::Object {{"kind", "markdown"}, {"value", *description}}}};
+    }
+
+    llvm::json::Value LanguageServer::DocumentSymbols(const llvm::json::Object& params) {
+        constexpr int FunctionKind = 12;
+
+        const auto path = GetDocumentPath(params);
+        llvm::json::Array symbols;
+        for (const auto& symbol : workspace.GetDocumentSymbols(path)) {
+            const auto nameEnd = symbol.column + static_cast<int>(symbol.name.size());
+            symbols.push_back(llvm::json::Object {
+                {"name", symbol.name},
+                {"detail", symbol.detail},
+                {"kind", FunctionKind},
+                {"range", MakeDocumentRange(path, symbol.line, 0, symbol.endLine, static_cast<int>(workspace.GetLine(path, symbol.endLine).size()))},
+                {"selectionRange", MakeDocumentRange(path, symbol.line, symbol.column, symbol.line, nameEnd)},
+            });
+        }
+        return symbols;
+    }
+}
+
+int pl::RunLanguageServer(const CompilerOptions& options) {
+    LanguageServer server(options.stats);
+    return server.Run();
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Driver/Options.hpp"
+
+namespace pl {
+    // fractac lsp: Language Server Protocol over stdin and stdout, with diagnostics, go to definition, hover and
+    // document symbols. The '.fr' files below the workspace root are loaded on start, and open documents replace
+    // their files. Runs until the client sends 'exit'. With '--stats', every update is logged to stderr.
+    int RunLanguageServer(const CompilerOptions& options);
+}
@@ -0,0 +1,290 @@
+#include "Options.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+using namespace pl;
+
+static const std::unordered_map<std::string_view, OptLevel> OptLevelFlags = {
+    {"-O0", OptLevel::O0},
+    {"-O1", OptLevel::O1},
+    {"-O2", OptLevel::O2},
+    {"-O3", OptLevel::O3},
+    {"-Os", OptLevel::Os},
+};
+
+static const std::unordered_map<std::string_view, EmitStage> EmitStages = {
+    {"tokens", EmitStage::Tokens},
+    {"ast", EmitStage::AST},
+    {"ir", EmitStage::IR},
+    {"obj", EmitStage::Object},
+};
+
+static const std::unordered_map<std::string_view, DiagnosticsFormat> DiagnosticsFormats = {
+    {"text", DiagnosticsFormat::Text},
+    {"json", DiagnosticsFormat::JSON},
+};
+
+static std::optional<unsigned> ParseUnsigned(std::string_view str) {
+    unsigned value = 0;
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc() || end != str.data() + str.size()) return std::nullopt;
+    return value;
+}
+
+static bool IsServerOption(std::string_view arg) {
+    return arg == "--server" || arg.starts_with("--server=");
+}
+
+CompilerOptions pl::ParseCommandLine(int argc, const char* const* argv, std::vector<ErrorInfo>& errors) {
+    CompilerOptions options;
+
+    auto addError = [&](std::string msg) {
+        errors.push_back({"fractac", std::move(msg), 0});
+    };
+
+    // The mode comes first, though 'fractac --server run ...' may put a server option before it.
+    int modeIndex = 1;
+    while (modeIndex < argc && IsServerOption(argv[modeIndex])) modeIndex++;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+
+        if (i == modeIndex && arg == "run") {
+            options.mode = DriverMode::Run;
+        }
+        else if (i == modeIndex && arg == "bench") {
+            options.mode = DriverMode::Bench;
+        }
+        else if (i == modeIndex && arg == "lto-link") {
+            options.mode = DriverMode::LTOLink;
+        }
+        else if (i == modeIndex && arg == "daemon") {
+            options.mode = DriverMode::Daemon;
+        }
+        else if (i == modeIndex && arg == "lsp") {
+            options.mode = DriverMode::LanguageServer;
+        }
+        else if (IsServerOption(arg)) {
+            // Consumed by the client; a server that is not running leaves the command to run locally.
+        }
+        else if (arg.starts_with("--socket=")) {
+            options.socketPath = arg.substr(9);
+        }
+        else if (arg == "-fsyntax-only") {
+            options.syntaxOnly = true;
+        }
+        else if (arg == "-fprofile-generate") {
+            options.profileGenerate = "default_%m.profraw";
+        }
+        else if (arg.starts_with("-fprofile-generate=")) {
+            options.profileGenerate = arg.substr(19);
+        }
+        else if (arg.starts_with("-fprofile-use=")) {
+            options.profileUse = arg.substr(14);
+        }
+        else if (arg == "-ftime-trace") {
+            options.timeTrace.emplace();
+        }
+        else if (arg.starts_with("-ftime-trace=")) {
+            options.timeTrace = arg.substr(13);
+        }
+        else if (arg.starts_with("-ftime-trace-granularity=")) {
+            auto granularity = ParseUnsigned(arg.substr(25));
+            if (!granularity) addError(fmt::format("Invalid time trace granularity '{}'.", arg.substr(25)));
+            else options.timeTraceGranularity = *granularity;
+        }
+        else if (arg == "--time-report") {
+            options.timeReport = true;
+        }
+        else if (arg == "--stats") {
+            options.stats = true;
+        }
+        else if (arg == "--mem-report") {
+            options.memReport = true;
+        }
+        else if (arg.starts_with("--stats-file=")) {
+            options.statsFile = arg.substr(13);
+        }
+        else if (arg == "-flto=thin") {
+            options.thinLTO = true;
+        }
+        else if (arg == "-o") {
+            if (i + 1 >= argc) addError("Missing path after '-o'.");
+            else options.output = argv[++i];
+        }
+        else if (arg.starts_with("--emit=")) {
+            auto stage = EmitStages.find(arg.substr(7));
+            if (stage == EmitStages.end()) addError(fmt::format("Unknown emit stage '{}', expected tokens, ast, ir or obj.", arg.substr(7)));
+            else options.emit = stage->second;
+        }
+        else if (OptLevelFlags.contains(arg)) {
+            options.optLevel = OptLevelFlags.at(arg);
+        }
+        else if (arg.starts_with("-march=")) {
+            options.targetCpu = arg.substr(7);
+        }
+        else if (arg.starts_with("-mattr=")) {
+            options.targetFeatures = arg.substr(7);
+        }
+        else if (arg == "--print-pipeline") {
+            options.printPipeline = true;
+        }
+        else if (arg == "--time-passes") {
+            options.timePasses = true;
+        }
+        else if (arg == "--report-dead-functions") {
+            options.reportDeadFunctions = true;
+        }
+        else if (arg == "--lazy") {
+            options.lazy = true;
+        }
+        else if (arg == "--perf") {
+            options.perf = true;
+        }
+        else if (arg == "--profile") {
+            options.profile = true;
+        }
+        else if (arg == "--watch") {
+            options.watch = true;
+        }
+        else if (arg == "--interpret") {
+            options.interpret = true;
+        }
+        else if (arg == "--memoize") {
+            options.memoize = true;
+        }
+        else if (arg == "--vm") {
+            options.vm = true;
+        }
+        else if (arg.starts_with("--bench-iterations=")) {
+            auto iterations = ParseUnsigned(arg.substr(19));
+            if (!iterations || *iterations == 0) addError(fmt::format("Invalid iteration count '{}'.", arg.substr(19)));
+            else options.benchIterations = *iterations;
+        }
+        else if (arg.starts_with("-fcomptime-steps=")) {
+            auto steps = ParseUnsigned(arg.substr(17));
+            if (!steps || *steps == 0) addError(fmt::format("Invalid compile-time step limit '{}'.", arg.substr(17)));
+            else options.comptimeLimits.maxSteps = *steps;
+        }
+        else if (arg.starts_with("-fcomptime-memory=")) {
+            auto megabytes = ParseUnsigned(arg.substr(18));
+            if (!megabytes || *megabytes == 0) addError(fmt::format("Invalid compile-time memory limit '{}'.", arg.substr(18)));
+            else options.comptimeLimits.maxMemory = static_cast<uint64_t>(*megabytes) << 20;
+        }
+        else if (arg.starts_with("-ferror-limit=")) {
+            auto limit = ParseUnsigned(arg.substr(14));
+            if (!limit) addError(fmt::format("Invalid error limit '{}'.", arg.substr(14)));
+            else options.diagnostics.errorLimit = *limit;
+        }
+        else if (arg.starts_with("-fdiagnostics-format=")) {
+            auto format = DiagnosticsFormats.find(arg.substr(21));
+            if (format == DiagnosticsFormats.end()) addError(fmt::format("Unknown diagnostics format '{}', expected text or json.", arg.substr(21)));
+            else options.diagnostics.format = format->second;
+        }
+        else if (arg.starts_with("--tier-threshold=")) {
+            auto threshold = ParseUnsigned(arg.substr(17));
+            if (!threshold || *threshold == 0) addError(fmt::format("Invalid tier threshold '{}'.", arg.substr(17)));
+            else options.tierThreshold = threshold;
+        }
+        else if (arg.starts_with("--cache-dir=")) {
+            if (!options.objectCache) options.objectCache.emplace();
+            options.objectCache->directory = arg.substr(12);
+        }
+        else if (arg.starts_with("--cache-size=")) {
+            auto megabytes = ParseUnsigned(arg.substr(13));
+            if (!megabytes) addError(fmt::format("Invalid cache size '{}'.", arg.substr(13)));
+            else {
+                if (!options.objectCache) options.objectCache.emplace();
+                options.objectCache->maxSizeBytes = static_cast<uint64_t>(*megabytes) << 20;
+            }
+        }
+        else if (arg.starts_with("-j")) {
+            auto value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? std::string_view(argv[++i]) : std::string_view());
+            auto jobs = ParseUnsigned(value);
+            if (!jobs || *jobs == 0) addError(fmt::format("Invalid job count '{}'.", value));
+            else options.jobs = jobs;
+        }
+        else if (arg.starts_with("-")) {
+            addError(fmt::format("Unknown option '{}'.", arg));
+        }
+        else if (options.mode == DriverMode::LTOLink) {
+            options.linkInputs.emplace_back(arg);
+        }
+        else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+
+    if (options.mode == DriverMode::Daemon || options.mode == DriverMode::LanguageServer) {
+        if (!options.inputs.empty()) addError(fmt::format("'{}' takes no input files.", options.mode == DriverMode::Daemon ? "daemon" : "lsp"));
+    }
+    else if (options.mode != DriverMode::LTOLink && options.inputs.empty()) {
+        addError("No input files.");
+    }
+    if (options.socketPath && options.mode != DriverMode::Daemon) {
+        addError("'--socket' is only valid with 'daemon'; clients pass '--server=<path>'.");
+    }
+    if (options.syntaxOnly && (options.mode != DriverMode::Compile || options.emit != EmitStage::Default)) {
+        addError("'-fsyntax-only' is only valid when compiling, without '--emit'.");
+    }
+    if (options.inputs.size() > 1 && std::ranges::any_of(options.inputs, [](const auto& input) { return input.extension() == ".fbc"; })) {
+        addError("Bytecode files must be run on their own.");
+    }
+
+    if ((options.timeTrace || options.timeReport) && (options.mode == DriverMode::LTOLink || options.watch)) {
+        addError("'-ftime-trace' and '--time-report' are not supported with 'lto-link' and '--watch'.");
+    }
+
+    if ((options.stats || options.memReport) && (options.mode == DriverMode::LTOLink || options.watch)) {
+        addError("'--stats' and '--mem-report' are not supported with 'lto-link' and '--watch'.");
+    }
+    if (options.statsFile && !options.stats && !options.memReport) {
+        addError("'--stats-file' requires '--stats' or '--mem-report'.");
+    }
+
+    if (options.emit != EmitStage::Default && (options.mode != DriverMode::Compile || options.thinLTO)) {
+        addError("'--emit' is only valid when compiling, and cannot be combined with '-flto=thin'.");
+    }
+
+    if ((options.interpret || options.tierThreshold || options.vm) && options.mode != DriverMode::Run) {
+        addError("'--interpret', '--tier-threshold' and '--vm' are only valid with 'run'.");
+    }
+
+    if (options.memoize && !options.interpret && !options.tierThreshold) {
+        addError("'--memoize' requires '--interpret' or '--tier-threshold'.");
+    }
+
+    if ((options.perf || options.profile) && (options.mode != DriverMode::Run || options.interpret || options.tierThreshold || options.vm)) {
+        addError("'--perf' and '--profile' apply to JIT execution with 'run'.");
+    }
+
+    if (options.watch && (options.mode != DriverMode::Run || options.inputs.size() != 1 || options.interpret || options.tierThreshold || options.vm || options.profile)) {
+        addError("'--watch' requires JIT execution of a single input file with 'run', without '--profile'.");
+    }
+
+    if ((!options.profileGenerate.empty() || !options.profileUse.empty()) && options.mode != DriverMode::Compile) {
+        addError("Profile options are only valid when compiling.");
+    }
+    if (!options.profileGenerate.empty() && !options.profileUse.empty()) {
+        addError("'-fprofile-generate' and '-fprofile-use' cannot be combined.");
+    }
+
+    if (options.thinLTO && (options.mode != DriverMode::Compile || !options.output)) {
+        addError("'-flto=thin' requires compiling to an output file with '-o'.");
+    }
+    if (options.thinLTO && options.jobs) {
+        addError("'-j' cannot be combined with '-flto=thin'; pass it to 'lto-link' instead.");
+    }
+    if (options.mode == DriverMode::LTOLink && (options.linkInputs.empty() || !options.output)) {
+        addError("'lto-link' requires input modules and an output file given with '-o'.");
+    }
+
+    if (options.objectCache && options.objectCache->directory.empty()) {
+        addError("'--cache-size' requires '--cache-dir'.");
+    }
+
+    return options;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Analysis/ComptimeEvaluation.hpp"
+#include "CodeGen/ObjectCache.hpp"
+#include "CodeGen/Optimizer.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Utils/Diagnostics.hpp>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pl {
+    enum class DriverMode {
+        Compile,
+        Run,        // fractac run <file>: JIT-compiles the program and runs Main.
+        Bench,      // fractac bench <file>: times Main on the interpreter, the bytecode VM and the JIT.
+        LTOLink,    // fractac lto-link <a.bc> <b.bc>... -o <out>: ThinLTO link of '-flto=thin' modules.
+        Daemon,     // fractac daemon: compile server for command lines forwarded with '--server'.
+        LanguageServer,     // fractac lsp: Language Server Protocol over stdin and stdout.
+    };
+
+    // --emit=<stage>: what compiling writes. 'Default' picks the output kind from the '-o' extension.
+    enum class EmitStage {
+        Default,
+        Tokens,
+        AST,
+        IR,
+        Object,
+    };
+
+    struct CompilerOptions {
+        DriverMode mode = DriverMode::Compile;
+
+        std::vector<std::filesystem::path> inputs;          // Source files and directories of them.
+        std::vector<std::filesystem::path> linkInputs;      // lto-link only
+        std::optional<std::filesystem::path> output;
+        EmitStage emit = EmitStage::Default;
+        bool syntaxOnly = false;        // -fsyntax-only: stop after semantic analysis.
+
+        // --socket=<path>: where 'fractac daemon' listens. '--server[=<path>]' is handled before option parsing.
+        std::optional<std::filesystem::path> socketPath;
+
+        OptLevel optLevel = OptLevel::O0;
+        std::string targetCpu;          // -march=<cpu|native>
+        std::string targetFeatures;     // -mattr=+feature,-feature
+
+        bool printPipeline = false;
+        bool timePasses = false;
+
+        // -ftime-trace[=<path>]: write Chrome trace JSON of the compiler's phases and passes.
+        std::optional<std::filesystem::path> timeTrace;
+        unsigned timeTraceGranularity = 500;    // -ftime-trace-granularity=<us>: shorter events are left out.
+        bool timeReport = false;                // --time-report: print total time per phase.
+
+        bool stats = false;             // --stats: print front end counters and time and diagnostics per phase, or
+                                        // with 'lsp', the time and work of every workspace update.
+        bool memReport = false;         // --mem-report: add allocation volume and peak per phase.
+        std::optional<std::filesystem::path> statsFile;     // --stats-file=<path>: also write them as JSON.
+        bool reportDeadFunctions = false;   // --report-dead-functions
+
+        bool lazy = false;              // --lazy: compile functions on first call in run mode.
+        bool perf = false;              // --perf: make JIT code visible to Linux perf.
+        bool profile = false;           // --profile: sample the JIT-compiled program and print a flat profile.
+        bool watch = false;             // --watch: reload functions into the running program when the input changes.
+
+        // -fprofile-generate[=<path>]: instrument for PGO, link the output with the compiler-rt profile runtime.
+        std::string profileGenerate;
+        // -fprofile-use=<file.profdata>: optimise with a merged profile.
+        std::string profileUse;
+
+        // -flto=thin: emit bitcode with a module summary after the pre-link pipeline, for 'lto-link'.
+        bool thinLTO = false;
+
+        // --interpret: run mode executes the AST directly instead of JIT-compiling it.
+        bool interpret = false;
+        // --tier-threshold=N: interpret, promoting each function to the JIT once it has been called N times.
+        std::optional<uint64_t> tierThreshold;
+        // --memoize: the interpreter reuses results of deterministic functions called with equal arguments.
+        bool memoize = false;
+        // --vm: run mode compiles to bytecode and runs it without LLVM. '.fbc' inputs always run this way.
+        bool vm = false;
+
+        unsigned benchIterations = 1000;    // --bench-iterations=N
+
+        // -fcomptime-steps=N, -fcomptime-memory=<MiB>: sandbox limits for compile-time evaluation.
+        ComptimeLimits comptimeLimits;
+
+        // -ferror-limit=N (20 by default, 0 for none), -fdiagnostics-format=text|json: how input, parse and semantic
+        // errors are reported.
+        DiagnosticsSettings diagnostics{.errorLimit = 20};
+
+        // -j N: lexing and parsing of the inputs, and partitioned code generation after optimisation, on N threads.
+        // The output does not depend on N.
+        std::optional<unsigned> jobs;
+
+        // --cache-dir=<path> [--cache-size=<MiB>]: reuse object code across builds and runs.
+        std::optional<ObjectCacheSettings> objectCache;
+    };
+
+    CompilerOptions ParseCommandLine(int argc, const char* const* argv, std::vector<ErrorInfo>& errors);
+}
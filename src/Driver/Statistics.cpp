@@ -0,0 +1,236 @@
+#include "Statistics.hpp"
+#include "Utils/Utils.hpp"
+#include "fmt/core.h"
+#include <Parsing/Expression.hpp>
+#include <Parsing/Statement.hpp>
+#include <Parsing/Type.hpp>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace pl;
+
+// Builds that fail leave through std::exit, which skips the destructor.
+static CompilerStatistics* reportAtExit = nullptr;
+
+namespace {
+    class ASTNodeCounter {
+        private:
+            std::map<std::string, uint64_t, std::less<>>& counts;
+
+        public:
+            explicit ASTNodeCounter(std::map<std::string, uint64_t, std::less<>>& counts) : counts(counts) { }
+
+            void Count(const StmtSP& stmt) {
+                if (!stmt) return;
+
+                if (auto p = InstanceOf<FuncDeclStmt>(stmt)) {
+                    counts["FuncDecl"]++;
+                    for (const auto& arg : p->args) Count(arg.type);
+                    Count(p->returnType);
+                    Count(p->body);
+                }
+                else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+                    counts["Return"]++;
+                    Count(p->value);
+                }
+                else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+                    counts["Block"]++;
+                    for (const auto& s : p->body) Count(s);
+                }
+                else if (auto p = InstanceOf<ExprStmt>(stmt)) {
+                    counts["ExprStmt"]++;
+                    Count(p->expr);
+                }
+            }
+
+            void Count(const ExprSP& expr) {
+                if (!expr) return;
+
+                if (InstanceOf<LiteralExpr>(expr)) counts["Literal"]++;
+                else if (InstanceOf<IdentifierExpr>(expr)) counts["Identifier"]++;
+                else if (auto p = InstanceOf<ParenExpr>(expr)) {
+                    counts["Paren"]++;
+                    Count(p->subExpr);
+                }
+                else if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+                    counts["Comptime"]++;
+                    Count(p->subExpr);
+                }
+                else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+                    counts["Unary"]++;
+                    Count(p->subExpr);
+                }
+                else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+                    counts["Binary"]++;
+                    Count(p->left);
+                    Count(p->right);
+                }
+                else if (auto p = InstanceOf<CallExpr>(expr)) {
+                    counts["Call"]++;
+                    Count(p->callee);
+                    for (const auto& arg : p->args) Count(arg);
+                }
+                else if (auto p = InstanceOf<IndexExpr>(expr)) {
+                    counts["Index"]++;
+                    Count(p->indexedExpr);
+                    for (const auto& index : p->indices) Count(index);
+                }
+            }
+
+            void Count(const TypeSP& type) {
+                if (InstanceOf<NamedType>(type)) counts["NamedType"]++;
+            }
+    };
+
+    double Milliseconds(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    double KiB(int64_t bytes) {
+        return static_cast<double>(bytes) / 1024.0;
+    }
+}
+
+CompilerStatistics::CompilerStatistics(bool counters, bool memory, std::optional<std::filesystem::path> jsonPath)
+    : counters(counters), memory(memory && AllocationCounter::IsAvailable()), jsonPath(std::move(jsonPath)) {
+    if (!IsEnabled()) return;
+
+    if (this->memory) AllocationCounter::Enable();
+    else if (memory) fmt::print(stderr, "Allocation tracking is not available in this build, '--mem-report' is ignored.\n");
+
+    static const bool registered = (std::atexit([] { if (reportAtExit) reportAtExit->Report(); }), true);
+    (void)registered;
+    reportAtExit = this;
+}
+
+CompilerStatistics::~CompilerStatistics() {
+    if (reportAtExit == this) Report();
+}
+
+void CompilerStatistics::BeginPhase(std::string_view name) {
+    if (!IsEnabled()) return;
+    EndPhase();
+
+    phases.push_back({std::string(name), {}, 0, {}});
+    phaseOpen = true;
+    if (memory) {
+        AllocationCounter::ResetPeak();
+        phaseStartMemory = AllocationCounter::Snapshot();
+    }
+    phaseStart = std::chrono::steady_clock::now();
+}
+
+void CompilerStatistics::EndPhase() {
+    if (!phaseOpen) return;
+    phaseOpen = false;
+
+    auto& phase = phases.back();
+    phase.time = std::chrono::steady_clock::now() - phaseStart;
+    if (memory) {
+        const auto end = AllocationCounter::Snapshot();
+        phase.memory = {
+            end.allocations - phaseStartMemory.allocations,
+            end.allocatedBytes - phaseStartMemory.allocatedBytes,
+            end.liveBytes - phaseStartMemory.liveBytes,
+            end.peakLiveBytes - phaseStartMemory.liveBytes
+        };
+    }
+}
+
+void CompilerStatistics::AddDiagnostics(uint64_t count) {
+    if (phaseOpen) phases.back().diagnostics += count;
+}
+
+void CompilerStatistics::Add(std::string_view counter, uint64_t value) {
+    if (!counters) return;
+
+    auto it = values.find(counter);
+    if (it == values.end()) values.emplace(std::string(counter), value);
+    else it->second += value;
+}
+
+void CompilerStatistics::CountASTNodes(const FileSourceNode& file) {
+    if (!counters) return;
+
+    ASTNodeCounter counter(astNodes);
+    for (const auto& stmt : file.statements) counter.Count(stmt);
+}
+
+void CompilerStatistics::Report() {
+    reportAtExit = nullptr;
+    EndPhase();
+
+    PrintTable();
+    if (jsonPath) WriteJSON();
+}
+
+void CompilerStatistics::PrintTable() const {
+    if (counters) {
+        fmt::print(stderr, "Statistics:\n");
+        for (const auto& [name, value] : values) fmt::print(stderr, "{:>12}  {}\n", value, name);
+
+        uint64_t totalNodes = 0;
+        for (const auto& [kind, count] : astNodes) totalNodes += count;
+        fmt::print(stderr, "{:>12}  AST nodes\n", totalNodes);
+        for (const auto& [kind, count] : astNodes) fmt::print(stderr, "{:>12}    {}\n", count, kind);
+    }
+
+    fmt::print(stderr, "{:<16}{:>12}{:>8}", "Phase", "Time ms", "Diags");
+    if (memory) fmt::print(stderr, "{:>10}{:>14}{:>12}{:>12}", "Allocs", "Alloc KiB", "Peak KiB", "Net KiB");
+    fmt::print(stderr, "\n");
+
+    for (const auto& phase : phases) {
+        fmt::print(stderr, "{:<16}{:>12.3f}{:>8}", phase.name, Milliseconds(phase.time), phase.diagnostics);
+        if (memory) {
+            const auto& m = phase.memory;
+            fmt::print(stderr, "{:>10}{:>14.1f}{:>12.1f}{:>12.1f}", m.allocations, KiB(static_cast<int64_t>(m.allocatedBytes)), KiB(m.peakLiveBytes), KiB(m.liveBytes));
+        }
+        fmt::print(stderr, "\n");
+    }
+
+    if (memory) {
+        const auto total = AllocationCounter::Snapshot();
+        fmt::print(stderr, "Process: {} allocations, {:.1f} KiB allocated, {:.1f} KiB net since tracking started.\n",
+            total.allocations, KiB(static_cast<int64_t>(total.allocatedBytes)), KiB(total.liveBytes));
+    }
+}
+
+void CompilerStatistics::WriteJSON() const {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(jsonPath->string(), ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+        ReportErrors("Statistics errors.", {{jsonPath->string(), ec.message(), 0}});
+        return;
+    }
+
+    llvm::json::OStream json(out, 2);
+    json.object([&] {
+        if (counters) {
+            json.attributeObject("counters", [&] {
+                for (const auto& [name, value] : values) json.attribute(name, static_cast<int64_t>(value));
+            });
+            json.attributeObject("astNodes", [&] {
+                for (const auto& [kind, count] : astNodes) json.attribute(kind, static_cast<int64_t>(count));
+            });
+        }
+
+        json.attributeArray("phases", [&] {
+            for (const auto& phase : phases) {
+                json.object([&] {
+                    json.attribute("name", phase.name);
+                    json.attribute("milliseconds", Milliseconds(phase.time));
+                    json.attribute("diagnostics", static_cast<int64_t>(phase.diagnostics));
+                    if (!memory) return;
+                    json.attribute("allocations", static_cast<int64_t>(phase.memory.allocations));
+                    json.attribute("allocatedBytes", static_cast<int64_t>(phase.memory.allocatedBytes));
+                    json.attribute("peakBytes", phase.memory.peakLiveBytes);
+                    json.attribute("netBytes", phase.memory.liveBytes);
+                });
+            }
+        });
+    });
+    out << "\n";
+}
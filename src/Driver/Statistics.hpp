@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Utils/AllocationCounter.hpp"
+#include <Parsing/ASTNode.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    struct PhaseStatistics {
+        std::string name;
+        std::chrono::steady_clock::duration time {};
+        uint64_t diagnostics = 0;
+        AllocationSnapshot memory;      // Allocations and bytes during the phase, and its peak above its start.
+    };
+
+    // Counters and per-phase time, diagnostics and memory of one fractac invocation, for --stats and --mem-report.
+    // Reported when destroyed, or at exit when an error ends the process.
+    class CompilerStatistics {
+        private:
+            bool counters;
+            bool memory;
+            std::optional<std::filesystem::path> jsonPath;
+
+            std::vector<PhaseStatistics> phases;
+            bool phaseOpen = false;
+            std::chrono::steady_clock::time_point phaseStart;
+            AllocationSnapshot phaseStartMemory;
+
+            std::map<std::string, uint64_t, std::less<>> values;
+            std::map<std::string, uint64_t, std::less<>> astNodes;     // By node kind.
+
+        public:
+            CompilerStatistics(bool counters, bool memory, std::optional<std::filesystem::path> jsonPath);
+            ~CompilerStatistics();
+
+            CompilerStatistics(const CompilerStatistics&) = delete;
+            CompilerStatistics& operator=(const CompilerStatistics&) = delete;
+
+            [[nodiscard]] bool IsEnabled() const { return counters || memory; }
+
+            // Ends the open phase, if any, and starts the next one.
+            void BeginPhase(std::string_view name);
+            void EndPhase();
+            void AddDiagnostics(uint64_t count);
+
+            void Add(std::string_view counter, uint64_t value);
+            void CountASTNodes(const FileSourceNode& file);
+
+            void Report();
+
+        private:
+            void PrintTable() const;
+            void WriteJSON() const;
+    };
+}
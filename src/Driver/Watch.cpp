@@ -0,0 +1,292 @@
+#include "Watch.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "Analysis/SemanticAnalysis.hpp"
+#include "CodeGen/CodeGenerator.hpp"
+#include "CodeGen/HotReload.hpp"
+#include "Utils/Utils.hpp"
+#include "fmt/core.h"
+#include <Parsing/Parser.hpp>
+#include <llvm/IR/LLVMContext.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace pl;
+
+namespace {
+    void DescribeExpression(const ExprSP& expr, std::string& out) {
+        if (!expr) return;
+        out += '(';
+
+        if (auto p = InstanceOf<LiteralExpr>(expr)) out += p->value.ToString();
+        else if (auto p = InstanceOf<IdentifierExpr>(expr)) out += p->value.ToString();
+        else if (auto p = InstanceOf<ParenExpr>(expr)) DescribeExpression(p->subExpr, out);
+        else if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+            out += "comptime ";
+            DescribeExpression(p->subExpr, out);
+        }
+        else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+            out += p->op.ToString();
+            DescribeExpression(p->subExpr, out);
+        }
+        else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+            DescribeExpression(p->left, out);
+            out += p->op.ToString();
+            DescribeExpression(p->right, out);
+        }
+        else if (auto p = InstanceOf<CallExpr>(expr)) {
+            DescribeExpression(p->callee, out);
+            for (const auto& arg : p->args) DescribeExpression(arg, out);
+        }
+        else if (auto p = InstanceOf<IndexExpr>(expr)) {
+            DescribeExpression(p->indexedExpr, out);
+            for (const auto& index : p->indices) DescribeExpression(index, out);
+        }
+        else out += '?';
+
+        out += ')';
+    }
+
+    void DescribeStatement(const StmtSP& stmt, std::string& out) {
+        if (!stmt) return;
+        out += '{';
+
+        if (auto p = InstanceOf<ExprStmt>(stmt)) DescribeExpression(p->expr, out);
+        else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+            out += "return";
+            DescribeExpression(p->value, out);
+        }
+        else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+            for (const auto& s : p->body) DescribeStatement(s, out);
+        }
+        else out += '?';
+
+        out += '}';
+    }
+
+    std::string Signature(const FuncDeclStmt& func) {
+        std::string args;
+        for (const auto& arg : func.args) {
+            if (!args.empty()) args += ", ";
+            args += TypeName(arg.type);
+        }
+        return fmt::format("({}) {}", args, TypeName(func.returnType));
+    }
+
+    // Line numbers are left out, so moving a function around does not recompile it.
+    std::string Fingerprint(const FuncDeclStmt& func) {
+        std::string out = fmt::format("{}{}{}", func.isComptime ? "comptime " : "", func.name.identName, Signature(func));
+        for (const auto& arg : func.args) out += arg.name.identName + ',';
+        DescribeStatement(func.body, out);
+        return out;
+    }
+
+    class ProgramWatcher {
+        private:
+            struct WatchedFunction {
+                std::string fingerprint;
+                std::string signature;
+            };
+
+            const CompilerOptions& options;
+            std::filesystem::path path;
+            HotReloadEngine engine;
+            std::unordered_map<std::string, WatchedFunction> functions;
+
+        public:
+            ProgramWatcher(const CompilerOptions& options, std::filesystem::path path);
+
+            // Parses the file and loads the functions that changed since the last successful reload.
+            // Reports diagnostics and returns false if the reload was rejected.
+            bool Reload();
+
+            [[nodiscard]] bool HasRunnableMain() const;
+            [[nodiscard]] HotReloadEngine& GetEngine() { return engine; }
+    };
+
+    JITSettings MakeJITSettings(const CompilerOptions& options) {
+        JITSettings settings;
+        settings.optLevel = options.optLevel;
+        settings.lazy = options.lazy;
+        settings.objectCache = options.objectCache;
+        settings.perfSupport = options.perf;
+        return settings;
+    }
+
+    ProgramWatcher::ProgramWatcher(const CompilerOptions& options, std::filesystem::path path)
+        : options(options), path(std::move(path)), engine(MakeJITSettings(options)) { }
+
+    bool ProgramWatcher::Reload() {
+        auto parser = SourceParser::FromFile(path);
+        auto node = parser.Parse();
+        if (parser.HadErrors()) {
+            ReportErrors("Parsing errors.", parser.GetErrors());
+            return false;
+        }
+
+        std::unordered_map<std::string, WatchedFunction> current;
+        std::vector<FuncDeclStmtSP> changed;
+        std::vector<ErrorInfo> signatureErrors;
+        bool comptimeChanged = false;
+
+        for (const auto& stmt : node->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func) continue;
+
+            const auto& name = func->name.identName;
+            WatchedFunction watched {Fingerprint(*func), Signature(*func)};
+
+            // Code compiled earlier calls the function with its old prototype through the stub.
+            auto old = functions.find(name);
+            if (old != functions.end() && old->second.signature != watched.signature) {
+                signatureErrors.push_back({
+                    path.filename().string(),
+                    fmt::format("Signature of '{}' changed from '{}' to '{}'. Restart to apply it.", name, old->second.signature, watched.signature),
+                    func->line
+                });
+            }
+
+            if (old == functions.end() || old->second.fingerprint != watched.fingerprint) {
+                changed.push_back(func);
+                comptimeChanged = comptimeChanged || func->isComptime;
+            }
+            current.emplace(name, std::move(watched));
+        }
+
+        if (!signatureErrors.empty()) {
+            ReportErrors("Reload rejected.", signatureErrors);
+            return false;
+        }
+
+        // Only changed functions are analysed and compiled; the others are kept as declarations so calls to them
+        // resolve to their stubs. Compile-time functions are always needed to evaluate calls, and a change to one
+        // may change the value of any call to it, so then every function is reloaded.
+        std::vector<StmtSP> statements;
+        size_t reloadCount = 0;
+        for (const auto& stmt : node->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func || func->isComptime) {
+                statements.push_back(stmt);
+                continue;
+            }
+
+            if (comptimeChanged || std::ranges::find(changed, func) != changed.end()) {
+                statements.push_back(func);
+                reloadCount++;
+                continue;
+            }
+
+            auto declaration = MakeSP<FuncDeclStmt>(func->name, func->args, func->returnType, nullptr);
+            declaration->line = func->line;
+            statements.push_back(declaration);
+        }
+
+        if (reloadCount == 0) {
+            functions = std::move(current);
+            return true;
+        }
+
+        auto reduced = MakeSP<FileSourceNode>(node->filename, statements);
+        const auto moduleName = path.stem().string();
+
+        SemanticAnalyzer sema({reduced}, moduleName);
+        sema.SetComptimeLimits(options.comptimeLimits);
+        sema.Analyze();
+        if (sema.HadErrors()) {
+            ReportErrors("Semantic analysis errors.", sema.GetErrors());
+            return false;
+        }
+        ReportWarnings("Semantic analysis warnings.", sema.GetWarnings());
+
+        ConstantFolder folder;
+        folder.Fold(reduced);
+
+        auto context = std::make_unique<llvm::LLVMContext>();
+        CodeGenerator codegen(*context, moduleName);
+        auto module = codegen.Generate({reduced});
+        if (!module) {
+            ReportErrors("Code generation errors.", codegen.GetErrors());
+            return false;
+        }
+
+        auto loaded = engine.Load(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+        if (engine.HadErrors()) {
+            ReportErrors("JIT errors.", engine.GetErrors());
+            return false;
+        }
+
+        // Removed functions stay loaded, so their signatures remain reserved.
+        const bool initial = functions.empty();
+        for (auto& [name, watched] : current) functions[name] = std::move(watched);
+
+        if (!initial) {
+            std::string names;
+            for (const auto& name : loaded) names += (names.empty() ? "" : ", ") + name;
+            fmt::print(stderr, "Reloaded {}.\n", names);
+        }
+        return true;
+    }
+
+    bool ProgramWatcher::HasRunnableMain() const {
+        auto it = functions.find("Main");
+        return it != functions.end() && it->second.signature == "() i32";
+    }
+
+    std::filesystem::file_time_type LastWriteTime(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(path, ec);
+        return ec ? std::filesystem::file_time_type::min() : time;
+    }
+}
+
+int pl::RunWatching(const CompilerOptions& options) {
+    using namespace std::chrono_literals;
+
+    const auto& path = options.inputs.front();
+    ProgramWatcher watcher(options, path);
+
+    // Main runs on its own thread, so the program can be long-running while reloads happen.
+    std::future<int32_t> running;
+    auto startMain = [&] {
+        if (!watcher.HasRunnableMain()) {
+            ReportErrors("Run errors.", {{path.filename().string(), "Program must define 'func Main() i32' to be run.", 0}});
+            return;
+        }
+
+        auto entry = reinterpret_cast<int32_t (*)()>(watcher.GetEngine().Lookup("Main"));
+        if (!entry) {
+            ReportErrors("JIT errors.", watcher.GetEngine().GetErrors());
+            return;
+        }
+        running = std::async(std::launch::async, entry);
+    };
+
+    auto lastWrite = LastWriteTime(path);
+    if (watcher.Reload()) startMain();
+    fmt::print(stderr, "Watching '{}' for changes.\n", path.string());
+
+    while (true) {
+        std::this_thread::sleep_for(100ms);
+
+        if (running.valid() && running.wait_for(0s) == std::future_status::ready) {
+            fmt::print(stderr, "Main returned {}.\n", running.get());
+        }
+
+        const auto write = LastWriteTime(path);
+        if (write == lastWrite) continue;
+        lastWrite = write;
+
+        const bool reloaded = watcher.Reload();
+        // Diagnostics go to stdout, which is block-buffered when piped to another tool.
+        std::fflush(stdout);
+        if (reloaded && !running.valid()) startMain();
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "Driver/Options.hpp"
+
+namespace pl {
+    // fractac run --watch <file>: JIT-runs Main, then reloads the functions that change on disk into the running
+    // process. Main runs again whenever it has returned before a reload. Runs until the process is interrupted.
+    int RunWatching(const CompilerOptions& options);
+}
@@ -0,0 +1,479 @@
+#include "Workspace.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Analysis/SemanticAnalysis.hpp"
+#include "Utils/Utils.hpp"
+#include "fmt/core.h"
+#include <Parsing/Parser.hpp>
+#include <Parsing/Scanner.hpp>
+#include <llvm/Support/TimeProfiler.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <iterator>
+
+using namespace pl;
+
+static bool IsWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Splits text into runs of whole lines, each ending with the line on which a top-level declaration ends. Comments
+// and blank lines before a declaration belong to its chunk, so editing them only reparses that declaration.
+static std::vector<std::string_view> SplitTopLevel(std::string_view text) {
+    std::vector<std::string_view> chunks;
+    size_t start = 0;
+    int depth = 0;
+    bool ended = false;         // A declaration ended on this line, outside of any braces.
+    bool inComment = false;
+    bool inString = false;
+
+    for (size_t i = 0; i < text.size(); i++) {
+        const char c = text[i];
+        if (c == '\n') {
+            inComment = false;
+            if (depth == 0 && ended) {
+                chunks.push_back(text.substr(start, i + 1 - start));
+                start = i + 1;
+                ended = false;
+            }
+            continue;
+        }
+        if (inComment) continue;
+        if (inString) {
+            if (c == '\\') i++;
+            else if (c == '"') inString = false;
+            continue;
+        }
+
+        switch (c) {
+            case '#': inComment = true; break;
+            case '"': inString = true; break;
+            case '{': depth++; break;
+            case '}':
+                // A stray brace ends the declaration it closes rather than swallowing the rest of the document.
+                depth = std::max(depth - 1, 0);
+                if (depth == 0) ended = true;
+                break;
+            case ';':
+                if (depth == 0) ended = true;
+                break;
+            default: break;
+        }
+    }
+
+    if (start < text.size()) chunks.push_back(text.substr(start));
+    return chunks;
+}
+
+static void CollectIdentifiers(const ExprSP& expr, std::vector<std::string>& names) {
+    if (!expr) return;
+
+    if (auto p = InstanceOf<IdentifierExpr>(expr)) names.push_back(p->value.identName);
+    else if (auto p = InstanceOf<ParenExpr>(expr)) CollectIdentifiers(p->subExpr, names);
+    else if (auto p = InstanceOf<ComptimeExpr>(expr)) CollectIdentifiers(p->subExpr, names);
+    else if (auto p = InstanceOf<UnaryExpr>(expr)) CollectIdentifiers(p->subExpr, names);
+    else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+        CollectIdentifiers(p->left, names);
+        CollectIdentifiers(p->right, names);
+    }
+    else if (auto p = InstanceOf<CallExpr>(expr)) {
+        CollectIdentifiers(p->callee, names);
+        for (const auto& arg : p->args) CollectIdentifiers(arg, names);
+    }
+    else if (auto p = InstanceOf<IndexExpr>(expr)) {
+        CollectIdentifiers(p->indexedExpr, names);
+        for (const auto& index : p->indices) CollectIdentifiers(index, names);
+    }
+}
+
+static void CollectIdentifiers(const StmtSP& stmt, std::vector<std::string>& names) {
+    if (!stmt) return;
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) CollectIdentifiers(p->expr, names);
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) CollectIdentifiers(p->value, names);
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (const auto& s : p->body) CollectIdentifiers(s, names);
+    }
+    else if (auto p = InstanceOf<FuncDeclStmt>(stmt)) {
+        // An argument named like a function is an error, so argument names depend on the functions too.
+        for (const auto& arg : p->args) names.push_back(arg.name.identName);
+        CollectIdentifiers(p->body, names);
+    }
+}
+
+// What callers of a function depend on. Argument names are left out, as renaming one changes no caller.
+static std::string Signature(const FuncDeclStmt& func) {
+    std::string args;
+    for (const auto& arg : func.args) {
+        if (!args.empty()) args += ", ";
+        args += TypeName(arg.type);
+    }
+    return fmt::format("{}({}) {}", func.isComptime ? "comptime " : "", args, TypeName(func.returnType));
+}
+
+static std::string Declaration(const FuncDeclStmt& func) {
+    std::string args;
+    for (const auto& arg : func.args) {
+        if (!args.empty()) args += ", ";
+        args += fmt::format("{} {}", arg.name.identName, TypeName(arg.type));
+    }
+    return fmt::format("{}{}func {}({}) {}", func.isExported ? "export " : "", func.isComptime ? "comptime " : "",
+        func.name.identName, args, TypeName(func.returnType));
+}
+
+// Column of the first whole-word occurrence of 'word' at or after 'from', or 0.
+static int FindWord(std::string_view line, std::string_view word, size_t from = 0) {
+    for (auto pos = line.find(word, from); pos != std::string_view::npos; pos = line.find(word, pos + 1)) {
+        const bool startsWord = pos == 0 || !IsWordChar(line[pos - 1]);
+        const bool endsWord = pos + word.size() >= line.size() || !IsWordChar(line[pos + word.size()]);
+        if (startsWord && endsWord) return static_cast<int>(pos);
+    }
+    return 0;
+}
+
+static int FindFunctionName(std::string_view line, std::string_view name) {
+    const auto keyword = line.find("func");
+    return FindWord(line, name, keyword == std::string_view::npos ? 0 : keyword + 4);
+}
+
+static std::vector<size_t> ComputeLineStarts(std::string_view text) {
+    std::vector<size_t> starts = {0};
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n') starts.push_back(i + 1);
+    }
+    return starts;
+}
+
+void Workspace::SetDocument(const std::string& path, std::string text) {
+    auto& document = documents[path];
+    document.text = std::move(text);
+    document.lineStarts = ComputeLineStarts(document.text);
+    document.changed = true;
+}
+
+void Workspace::RemoveDocument(const std::string& path) {
+    documents.erase(path);
+    // Both refer into the documents.
+    owners.clear();
+    definitions.clear();
+}
+
+bool Workspace::EditDocument(const std::string& path, int startLine, int startColumn, int endLine, int endColumn, std::string_view text) {
+    auto it = documents.find(path);
+    if (it == documents.end()) return false;
+    auto& document = it->second;
+
+    auto offset = [&](int line, int column) {
+        if (line < 0) return size_t(0);
+        if (static_cast<size_t>(line) >= document.lineStarts.size()) return document.text.size();
+
+        const auto lineStart = document.lineStarts[line];
+        const auto lineEnd = static_cast<size_t>(line) + 1 < document.lineStarts.size()
+            ? document.lineStarts[line + 1] - 1 : document.text.size();
+        return std::min(lineStart + static_cast<size_t>(std::max(column, 0)), lineEnd);
+    };
+
+    const auto start = offset(startLine, startColumn);
+    const auto end = std::max(offset(endLine, endColumn), start);
+    document.text.replace(start, end - start, text);
+    document.lineStarts = ComputeLineStarts(document.text);
+    document.changed = true;
+    return true;
+}
+
+std::vector<std::string> Workspace::GetPaths() const {
+    std::vector<std::string> paths;
+    for (const auto& [path, document] : documents) paths.push_back(path);
+    return paths;
+}
+
+size_t Workspace::GetChunkCount() const {
+    size_t count = 0;
+    for (const auto& [path, document] : documents) count += document.chunks.size();
+    return count;
+}
+
+void Workspace::Update() {
+    llvm::TimeTraceScope timeScope("Workspace::Update");
+
+    lastParsed = 0;
+    for (auto& [path, document] : documents) {
+        if (!document.changed) continue;
+        SplitDocument(document, path);
+        document.changed = false;
+    }
+    AnalyzeWorkspace();
+}
+
+void Workspace::SplitDocument(Document& document, const std::string& path) {
+    std::unordered_map<std::string_view, ChunkSP> previous;
+    for (const auto& placed : document.chunks) previous.emplace(placed.chunk->text, placed.chunk);
+
+    const auto filename = std::filesystem::path(path).filename().string();
+    std::vector<PlacedChunk> chunks;
+    int line = 0;
+
+    for (auto text : SplitTopLevel(document.text)) {
+        ChunkSP chunk;
+        if (auto it = previous.find(text); it != previous.end()) chunk = it->second;
+        else {
+            chunk = MakeSP<Chunk>();
+            chunk->text = text;
+            chunk->lineCount = static_cast<int>(std::ranges::count(text, '\n')) + (text.ends_with('\n') ? 0 : 1);
+
+            auto scanner = Scanner::FromString(chunk->text, filename);
+            auto tokens = scanner.ScanAll();
+            if (scanner.HadErrors()) chunk->parseErrors = scanner.GetErrors();
+            else {
+                auto parser = SourceParser::FromTokens(std::move(tokens), filename);
+                chunk->statements = parser.Parse()->statements;
+                chunk->parseErrors = parser.GetErrors();
+            }
+
+            for (const auto& stmt : chunk->statements) {
+                CollectIdentifiers(stmt, chunk->references);
+                auto func = InstanceOf<FuncDeclStmt>(stmt);
+                chunk->declarations += func ? fmt::format("{}:{}\n", func->line, Declaration(*func)) : fmt::format("{}:?\n", stmt->line);
+            }
+            std::ranges::sort(chunk->references);
+            chunk->references.erase(std::ranges::unique(chunk->references).begin(), chunk->references.end());
+            lastParsed++;
+        }
+
+        chunks.push_back({chunk, line});
+        line += chunk->lineCount;
+    }
+
+    // The old chunks are only released here, as 'previous' refers to their text.
+    document.chunks = std::move(chunks);
+}
+
+void Workspace::AnalyzeWorkspace() {
+    llvm::TimeTraceScope timeScope("Workspace::Analyze");
+
+    owners.clear();
+    for (auto& [path, document] : documents) {
+        document.firstOwner = owners.size();
+        for (const auto& placed : document.chunks) owners.push_back({&path, &placed});
+    }
+
+    // Editing a body leaves the declarations alone, so most edits skip straight to analysing the changed chunks.
+    bool sameDeclarations = analyzer && owners.size() == declaredChunks.size();
+    for (size_t i = 0; sameDeclarations && i < owners.size(); i++) {
+        const auto& chunk = owners[i].placed->chunk;
+        sameDeclarations = chunk == declaredChunks[i] || chunk->declarations == declaredChunks[i]->declarations;
+    }
+
+    std::unordered_set<std::string> changed;
+    if (!sameDeclarations) BuildGlobals(changed);
+    analyzer->ClearDiagnostics();
+
+    lastAnalyzed = 0;
+    for (size_t i = 0; i < owners.size(); i++) {
+        auto& chunk = *owners[i].placed->chunk;
+        const bool stale = !chunk.analyzed || (!changed.empty() && std::ranges::any_of(chunk.references, [&](const auto& name) { return changed.contains(name); }));
+        if (!stale) continue;
+
+        chunk.errors.clear();
+        chunk.warnings.clear();
+        for (const auto& stmt : chunk.statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func) continue;
+
+            const auto& diagnostics = analyzer->GetDiagnostics();
+            const auto first = diagnostics.Size();
+            analyzer->AnalyzeFunction(func, std::to_string(i));
+            std::ranges::move(diagnostics.GetErrors(first), std::back_inserter(chunk.errors));
+            std::ranges::move(diagnostics.GetWarnings(first), std::back_inserter(chunk.warnings));
+        }
+        chunk.analyzed = true;
+        lastAnalyzed++;
+    }
+}
+
+void Workspace::BuildGlobals(std::unordered_set<std::string>& changed) {
+    llvm::TimeTraceScope timeScope("Workspace::BuildGlobals");
+
+    // Each chunk is analysed as a file of its own, named by its index, so diagnostics lead back to it.
+    std::vector<FileSourceNodeSP> files;
+    declaredChunks.clear();
+    for (size_t i = 0; i < owners.size(); i++) {
+        const auto& chunk = owners[i].placed->chunk;
+        files.push_back(MakeSP<FileSourceNode>(std::to_string(i), chunk->statements));
+        declaredChunks.push_back(chunk);
+    }
+
+    // Every use of an undefined name is marked in the editor, not only the first.
+    analyzer = std::make_unique<SemanticAnalyzer>(files, "workspace", DiagnosticsSettings{.deduplicate = false});
+    globalErrors.assign(owners.size(), {});
+    for (const auto& error : analyzer->GetErrors()) {
+        size_t index = 0;
+        const auto name = std::string_view(error.context).substr(error.context.rfind(':') + 1);
+        std::from_chars(name.data(), name.data() + name.size(), index);
+        globalErrors.at(index).push_back(error);
+    }
+
+    // Functions whose signatures changed, appeared or disappeared; every chunk using one is analysed again.
+    std::unordered_map<std::string, std::string> current;
+    definitions.clear();
+    for (size_t i = 0; i < owners.size(); i++) {
+        const auto& statements = owners[i].placed->chunk->statements;
+        for (size_t j = 0; j < statements.size(); j++) {
+            auto func = InstanceOf<FuncDeclStmt>(statements[j]);
+            if (!func) continue;
+
+            // Defining a name twice changes what calls to it see, just like changing its signature.
+            auto& signature = current[func->name.identName];
+            if (!signature.empty()) signature += '|';
+            signature += Signature(*func);
+            definitions.try_emplace(func->name.identName, Definition {i, j});
+        }
+    }
+
+    for (const auto& [name, signature] : current) {
+        auto it = signatures.find(name);
+        if (it == signatures.end() || it->second != signature) changed.insert(name);
+    }
+    for (const auto& [name, signature] : signatures) {
+        if (!current.contains(name)) changed.insert(name);
+    }
+    signatures = std::move(current);
+}
+
+FuncDeclStmtSP Workspace::GetFunction(const Definition& definition) const {
+    return InstanceOf<FuncDeclStmt>(owners.at(definition.owner).placed->chunk->statements.at(definition.statement));
+}
+
+std::vector<Diagnostic> Workspace::GetDiagnostics(const std::string& path) const {
+    std::vector<Diagnostic> diagnostics;
+    auto it = documents.find(path);
+    if (it == documents.end()) return diagnostics;
+
+    const auto& chunks = it->second.chunks;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const auto& placed = chunks[i];
+        const auto& chunk = *placed.chunk;
+        // The parser reports errors at the end of input on the line after it.
+        auto place = [&](int line) { return placed.firstLine + std::clamp(line, 0, std::max(chunk.lineCount - 1, 0)); };
+
+        for (const auto& error : chunk.parseErrors) diagnostics.push_back({place(error.line), false, error.msg});
+        for (const auto& error : chunk.errors) diagnostics.push_back({place(error.line), false, error.msg});
+        for (const auto& warning : chunk.warnings) diagnostics.push_back({place(warning.line), true, warning.msg});
+
+        const auto owner = it->second.firstOwner + i;
+        if (owner < globalErrors.size()) {
+            for (const auto& error : globalErrors[owner]) diagnostics.push_back({place(error.line), false, error.msg});
+        }
+    }
+
+    std::ranges::stable_sort(diagnostics, {}, &Diagnostic::line);
+    return diagnostics;
+}
+
+std::string_view Workspace::GetLine(const std::string& path, int line) const {
+    auto it = documents.find(path);
+    if (it == documents.end() || line < 0 || static_cast<size_t>(line) >= it->second.lineStarts.size()) return {};
+
+    const auto& document = it->second;
+    const auto start = document.lineStarts[line];
+    auto end = static_cast<size_t>(line) + 1 < document.lineStarts.size() ? document.lineStarts[line + 1] : document.text.size();
+    while (end > start && (document.text[end - 1] == '\n' || document.text[end - 1] == '\r')) end--;
+    return std::string_view(document.text).substr(start, end - start);
+}
+
+std::optional<Workspace::Lookup> Workspace::LookUp(const std::string& path, int line, int column) const {
+    auto it = documents.find(path);
+    if (it == documents.end()) return std::nullopt;
+
+    // A position just past the end of a word still refers to it.
+    const auto text = GetLine(path, line);
+    size_t start = std::min(static_cast<size_t>(std::max(column, 0)), text.size());
+    if ((start == text.size() || !IsWordChar(text[start])) && start > 0 && IsWordChar(text[start - 1])) start--;
+    if (start >= text.size() || !IsWordChar(text[start])) return std::nullopt;
+
+    size_t end = start;
+    while (start > 0 && IsWordChar(text[start - 1])) start--;
+    while (end < text.size() && IsWordChar(text[end])) end++;
+
+    Lookup lookup;
+    lookup.word = text.substr(start, end - start);
+
+    const auto& chunks = it->second.chunks;
+    auto placed = std::ranges::upper_bound(chunks, line, {}, &PlacedChunk::firstLine);
+    if (placed == chunks.begin()) return lookup;
+    placed--;
+
+    for (const auto& stmt : placed->chunk->statements) {
+        auto func = InstanceOf<FuncDeclStmt>(stmt);
+        if (func && placed->firstLine + func->line <= line) {
+            lookup.func = func;
+            lookup.chunkLine = placed->firstLine;
+        }
+    }
+    return lookup;
+}
+
+std::optional<SourceLocation> Workspace::FindDefinition(const std::string& path, int line, int column) const {
+    auto lookup = LookUp(path, line, column);
+    if (!lookup) return std::nullopt;
+
+    // Arguments are the only local names, and shadowing is an error, so they take precedence.
+    if (lookup->func) {
+        for (const auto& arg : lookup->func->args) {
+            if (arg.name.identName != lookup->word) continue;
+
+            const auto argLine = lookup->chunkLine + arg.name.lineNumber;
+            const auto text = GetLine(path, argLine);
+            const auto paren = text.find('(');
+            const auto argColumn = FindWord(text, lookup->word, paren == std::string_view::npos ? 0 : paren);
+            return SourceLocation {path, argLine, argColumn, static_cast<int>(lookup->word.size())};
+        }
+    }
+
+    auto it = definitions.find(lookup->word);
+    if (it == definitions.end()) return std::nullopt;
+
+    const auto& owner = owners.at(it->second.owner);
+    const auto funcLine = owner.placed->firstLine + GetFunction(it->second)->line;
+    const auto nameColumn = FindFunctionName(GetLine(*owner.path, funcLine), lookup->word);
+    return SourceLocation {*owner.path, funcLine, nameColumn, static_cast<int>(lookup->word.size())};
+}
+
+std::optional<std::string> Workspace::Describe(const std::string& path, int line, int column) const {
+    auto lookup = LookUp(path, line, column);
+    if (!lookup) return std::nullopt;
+
+    if (lookup->func) {
+        for (const auto& arg : lookup->func->args) {
+            if (arg.name.identName == lookup->word) {
+                return fmt::format("```fracta\n{} {}\n```\nArgument of `{}`.", arg.name.identName, TypeName(arg.type), lookup->func->name.identName);
+            }
+        }
+    }
+
+    auto it = definitions.find(lookup->word);
+    if (it == definitions.end()) return std::nullopt;
+    return fmt::format("```fracta\n{}\n```", Declaration(*GetFunction(it->second)));
+}
+
+std::vector<DocumentSymbol> Workspace::GetDocumentSymbols(const std::string& path) const {
+    std::vector<DocumentSymbol> symbols;
+    auto it = documents.find(path);
+    if (it == documents.end()) return symbols;
+
+    for (const auto& placed : it->second.chunks) {
+        const auto chunkEnd = placed.firstLine + std::max(placed.chunk->lineCount - 1, 0);
+        const auto first = symbols.size();
+
+        for (const auto& stmt : placed.chunk->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func) continue;
+
+            const auto line = placed.firstLine + func->line;
+            if (symbols.size() > first) symbols.back().endLine = std::max(symbols.back().line, line - 1);
+            symbols.push_back({func->name.identName, Declaration(*func), line, chunkEnd, FindFunctionName(GetLine(path, line), func->name.identName)});
+        }
+    }
+    return symbols;
+}
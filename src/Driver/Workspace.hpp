@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Analysis/SemanticAnalysis.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/Statement.hpp>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pl {
+    struct Diagnostic {
+        int line = 0;
+        bool isWarning = false;
+        std::string msg;
+
+        bool operator==(const Diagnostic&) const = default;
+    };
+
+    struct SourceLocation {
+        std::string path;
+        int line = 0;
+        int column = 0;
+        int length = 0;
+    };
+
+    struct DocumentSymbol {
+        std::string name;
+        std::string detail;
+        int line = 0;
+        int endLine = 0;
+        int column = 0;
+    };
+
+    // The sources the language server works on, with their parse trees and diagnostics kept up to date across
+    // edits. Documents are split into chunks of whole lines that end after a top-level declaration. A chunk is
+    // parsed again only when its text changes, and analysed again only when it changed or refers to a function whose
+    // signature changed. Global symbols are kept while no declaration changes, so editing a body costs a scan of the
+    // text plus the work for that body.
+    // Lines and columns are 0-based; columns count bytes.
+    class Workspace {
+        private:
+            struct Chunk {
+                std::string text;
+                int lineCount = 0;
+                std::vector<StmtSP> statements;     // Lines are relative to the start of the chunk, as are all below.
+                std::vector<ErrorInfo> parseErrors;
+                std::vector<std::string> references;    // Identifiers the declarations use, sorted and unique.
+                std::string declarations;   // The declarations with their lines, which the global symbols come from.
+
+                bool analyzed = false;
+                std::vector<ErrorInfo> errors;
+                std::vector<ErrorInfo> warnings;
+            };
+            using ChunkSP = std::shared_ptr<Chunk>;
+
+            struct PlacedChunk {
+                ChunkSP chunk;
+                int firstLine = 0;
+            };
+
+            struct Document {
+                std::string text;
+                std::vector<size_t> lineStarts;
+                std::vector<PlacedChunk> chunks;
+                size_t firstOwner = 0;      // Index of the first chunk in workspace order.
+                bool changed = true;
+            };
+
+            // A chunk in workspace order, the order in which chunks are analysed.
+            struct Owner {
+                const std::string* path;
+                const PlacedChunk* placed;
+            };
+
+            // A function as the index of its chunk in workspace order and of its statement in the chunk, so that it
+            // stays valid when an edit replaces the chunk without changing what it declares.
+            struct Definition {
+                size_t owner = 0;
+                size_t statement = 0;
+            };
+
+            std::map<std::string, Document> documents;
+            std::vector<Owner> owners;
+
+            // Global symbols are only built again when the declarations in workspace order change.
+            std::unique_ptr<SemanticAnalyzer> analyzer;
+            std::vector<ChunkSP> declaredChunks;
+            std::vector<std::vector<ErrorInfo>> globalErrors;   // Per chunk in workspace order, e.g. duplicate functions.
+            std::unordered_map<std::string, std::string> signatures;
+            std::unordered_map<std::string, Definition> definitions;
+
+            size_t lastParsed = 0;
+            size_t lastAnalyzed = 0;
+
+        public:
+            void SetDocument(const std::string& path, std::string text);
+            void RemoveDocument(const std::string& path);
+
+            // Replaces the text between two positions, which are clamped to the document. Returns false for an
+            // unknown document.
+            bool EditDocument(const std::string& path, int startLine, int startColumn, int endLine, int endColumn, std::string_view text);
+
+            [[nodiscard]] bool HasDocument(const std::string& path) const { return documents.contains(path); }
+            [[nodiscard]] std::vector<std::string> GetPaths() const;
+
+            // Brings parse trees and diagnostics up to date with the documents. Queries reflect the last update.
+            void Update();
+
+            [[nodiscard]] size_t GetChunkCount() const;
+            [[nodiscard]] size_t GetParsedCount() const { return lastParsed; }
+            [[nodiscard]] size_t GetAnalyzedCount() const { return lastAnalyzed; }
+
+            [[nodiscard]] std::vector<Diagnostic> GetDiagnostics(const std::string& path) const;
+            [[nodiscard]] std::optional<SourceLocation> FindDefinition(const std::string& path, int line, int column) const;
+            [[nodiscard]] std::optional<std::string> Describe(const std::string& path, int line, int column) const;
+            [[nodiscard]] std::vector<DocumentSymbol> GetDocumentSymbols(const std::string& path) const;
+            [[nodiscard]] std::string_view GetLine(const std::string& path, int line) const;
+
+        private:
+            void SplitDocument(Document& document, const std::string& path);
+            void AnalyzeWorkspace();
+            // Builds the global symbols, and adds the functions whose signatures changed since the last build.
+            void BuildGlobals(std::unordered_set<std::string>& changed);
+            [[nodiscard]] FuncDeclStmtSP GetFunction(const Definition& definition) const;
+
+            // The identifier at a position, and the function whose declaration encloses it with the first line of
+            // its chunk.
+            struct Lookup {
+                FuncDeclStmtSP func;
+                int chunkLine = 0;
+                std::string word;
+            };
+            [[nodiscard]] std::optional<Lookup> LookUp(const std::string& path, int line, int column) const;
+    };
+}
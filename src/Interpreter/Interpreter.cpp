@@ -0,0 +1,273 @@
+#include "Interpreter.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "fmt/core.h"
+#include <Utils/Utils.hpp>
+#include <algorithm>
+#include <bit>
+
+using namespace pl;
+
+Interpreter::Interpreter(const std::vector<FileSourceNodeSP>& files, const InterpreterSettings& settings) : settings(settings) {
+    for (const auto& file : files) {
+        for (const auto& stmt : file->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func) continue;
+
+            // A definition takes precedence over a forward declaration, in whichever order they appear.
+            auto& entry = functions[func->name.identName];
+            if (!entry.decl || func->body) entry.decl = func;
+        }
+    }
+}
+
+std::optional<Value> Interpreter::Call(std::string_view name, const std::vector<Value>& args) {
+    auto it = functions.find(std::string(name));
+    if (it == functions.end()) {
+        errors.push_back({"Interpreter", fmt::format("Unknown function '{}'.", name), 0});
+        return std::nullopt;
+    }
+
+    Reset();
+    try {
+        return Invoke(it->second, args, it->second.decl->line);
+    }
+    catch (const RuntimeError&) {
+        return std::nullopt;
+    }
+}
+
+std::optional<Value> Interpreter::EvaluateConstant(const ExprBase& expr) {
+    Reset();
+    try {
+        Frame frame;
+        return Evaluate(&expr, frame);
+    }
+    catch (const RuntimeError&) {
+        return std::nullopt;
+    }
+}
+
+FuncDeclStmtSP Interpreter::FindFunction(std::string_view name) const {
+    auto it = functions.find(std::string(name));
+    return it == functions.end() ? nullptr : it->second.decl;
+}
+
+Interpreter::RuntimeError Interpreter::Error(std::string_view msg, int line) {
+    errors.push_back({"Interpreter", std::string(msg), line});
+    return {};
+}
+
+void Interpreter::Step(int line) {
+    if (settings.maxSteps && ++steps > settings.maxSteps) {
+        throw Error(fmt::format("Execution exceeded the limit of {} steps.", settings.maxSteps), line);
+    }
+}
+
+void Interpreter::Reset() {
+    // A runtime error unwinds without restoring the counters.
+    steps = 0;
+    callDepth = 0;
+    memory = 0;
+    stackBase = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+}
+
+static uint64_t ValueBits(const Value& value) {
+    return std::visit([](auto v) { return std::bit_cast<uint64_t>(v); }, value);
+}
+
+size_t Interpreter::ArgsHash::operator()(const std::vector<Value>& args) const {
+    // FNV-1a over the argument bits and kinds.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto& arg : args) {
+        hash = (hash ^ (ValueBits(arg) + arg.index())) * 0x100000001b3ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool Interpreter::ArgsEqual::operator()(const std::vector<Value>& a, const std::vector<Value>& b) const {
+    return std::ranges::equal(a, b, [](const Value& x, const Value& y) {
+        return x.index() == y.index() && ValueBits(x) == ValueBits(y);
+    });
+}
+
+Value Interpreter::Invoke(FunctionEntry& entry, std::vector<Value> args, int line) {
+    if (!settings.memoize || !entry.decl->effects.IsDeterministic()) return Execute(entry, std::move(args), line);
+
+    if (auto it = entry.memo.find(args); it != entry.memo.end()) {
+        memoHits++;
+        return it->second;
+    }
+
+    auto key = args;
+    auto result = Execute(entry, std::move(args), line);
+    if (entry.memo.size() < MaxMemoEntries) entry.memo.emplace(std::move(key), result);
+    return result;
+}
+
+Value Interpreter::Execute(FunctionEntry& entry, std::vector<Value> args, int line) {
+    // Tail calls loop here instead of recursing, so they run in constant interpreter and native stack.
+    for (auto* current = &entry;;) {
+        if (PromoteIfHot(*current)) return InvokeNative(*current, args);
+
+        const auto& decl = *current->decl;
+        if (!decl.body) {
+            throw Error(fmt::format("Function '{}' is declared but has no body.", decl.name.identName), line);
+        }
+        if (callDepth >= settings.maxCallDepth) {
+            throw Error(fmt::format("Call depth exceeded {} in '{}'.", settings.maxCallDepth, decl.name.identName), line);
+        }
+
+        // The stack grows downwards on every supported target.
+        const auto stackUsed = stackBase - reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+        if (settings.maxNativeStack && stackUsed > settings.maxNativeStack) {
+            throw Error(fmt::format("Call depth {} in '{}' exhausted the interpreter's stack.", callDepth, decl.name.identName), line);
+        }
+
+        const uint64_t frameBytes = sizeof(Frame) + args.size() * sizeof(Value);
+        if (settings.maxMemory && memory + frameBytes > settings.maxMemory) {
+            throw Error(fmt::format("Execution exceeded the memory limit of {} bytes in '{}'.", settings.maxMemory, decl.name.identName), line);
+        }
+
+        callDepth++;
+        memory += frameBytes;
+        Frame frame;
+        frame.function = &decl;
+        frame.args = std::move(args);
+        auto result = ExecStatement(decl.body.get(), frame);
+        memory -= frameBytes;
+        callDepth--;
+
+        if (!frame.tailCallee) {
+            // Void functions produce no value; sema guarantees every other function returns one.
+            return result.value_or(Value {int64_t {0}});
+        }
+        current = frame.tailCallee;
+        args = std::move(frame.tailArgs);
+    }
+}
+
+bool Interpreter::PromoteIfHot(FunctionEntry& entry) {
+    if (entry.native) return true;
+
+    entry.callCount++;
+    if (!nativeTier || !settings.tierUpThreshold || entry.promotionFailed || entry.callCount < settings.tierUpThreshold) {
+        return false;
+    }
+
+    // Later calls, including ones from frames already on the stack, go straight to native code.
+    entry.native = nativeTier->Compile(*entry.decl);
+    entry.promotionFailed = !entry.native;
+    if (entry.native) promotedCount++;
+    return entry.native != nullptr;
+}
+
+Value Interpreter::InvokeNative(const FunctionEntry& entry, const std::vector<Value>& args) {
+    const auto& decl = *entry.decl;
+
+    std::vector<uint64_t> rawArgs(args.size());
+    for (size_t i = 0; i < args.size(); i++) {
+        if (auto p = std::get_if<double>(&args[i])) rawArgs[i] = std::bit_cast<uint64_t>(*p);
+        else rawArgs[i] = static_cast<uint64_t>(std::get<int64_t>(args[i]));
+    }
+
+    uint64_t rawResult = 0;
+    entry.native(rawArgs.data(), &rawResult);
+
+    if (IsFloatType(decl.returnType)) return std::bit_cast<double>(rawResult);
+    return static_cast<int64_t>(rawResult);
+}
+
+std::optional<Value> Interpreter::ExecStatement(const StmtBase* stmt, Frame& frame) {
+    if (!stmt) return std::nullopt;
+    Step(stmt->line);
+
+    // Raw pointer casts avoid reference count traffic on every node visited.
+    if (auto p = dynamic_cast<const ExprStmt*>(stmt)) {
+        Evaluate(p->expr.get(), frame);
+    }
+    else if (auto p = dynamic_cast<const ReturnStmt*>(stmt)) {
+        if (!p->value) return Value {int64_t {0}};
+
+        auto call = dynamic_cast<const CallExpr*>(p->value.get());
+        if (call && call->isTailCall) {
+            frame.tailCallee = &ResolveCallee(call);
+            frame.tailArgs = EvaluateArguments(call, frame);
+            return Value {int64_t {0}};
+        }
+        return Evaluate(p->value.get(), frame);
+    }
+    else if (auto p = dynamic_cast<const BlockStmt*>(stmt)) {
+        for (const auto& s : p->body) {
+            if (auto result = ExecStatement(s.get(), frame)) return result;
+        }
+    }
+    else if (!dynamic_cast<const FuncDeclStmt*>(stmt)) {
+        throw Error("Unsupported statement type.", stmt->line);
+    }
+    return std::nullopt;
+}
+
+Value Interpreter::Evaluate(const ExprBase* expr, Frame& frame) {
+    if (auto p = dynamic_cast<const LiteralExpr*>(expr)) {
+        if (auto value = EvaluateLiteral(*p)) return *value;
+        throw Error("Unsupported literal type.", p->line);
+    }
+    if (auto p = dynamic_cast<const IdentifierExpr*>(expr)) {
+        // Constant expressions are evaluated without a function, so they have no values in scope.
+        const auto argCount = frame.function ? frame.function->args.size() : 0;
+        for (size_t i = 0; i < argCount; i++) {
+            if (frame.function->args[i].name.identName == p->value.identName) return frame.args[i];
+        }
+        throw Error(fmt::format("Unknown value '{}'.", p->value.identName), p->line);
+    }
+    if (auto p = dynamic_cast<const ParenExpr*>(expr)) {
+        return Evaluate(p->subExpr.get(), frame);
+    }
+    if (auto p = dynamic_cast<const ComptimeExpr*>(expr)) {
+        return Evaluate(p->subExpr.get(), frame);
+    }
+    if (auto p = dynamic_cast<const UnaryExpr*>(expr)) {
+        auto operand = Evaluate(p->subExpr.get(), frame);
+        if (auto result = EvaluateUnary(p->op.type, operand, p->exprType)) return *result;
+        throw Error("Unsupported unary operator.", p->line);
+    }
+    if (auto p = dynamic_cast<const BinaryExpr*>(expr)) {
+        auto lhs = Evaluate(p->left.get(), frame);
+        auto rhs = Evaluate(p->right.get(), frame);
+        if (auto result = EvaluateBinary(p->op.type, lhs, rhs, p->exprType)) return *result;
+
+        // The evaluator declines exactly the operations that would trap in native code.
+        if (p->op.Check({TokenType::Slash, TokenType::Mod}) && IsIntegerType(p->exprType)) {
+            throw Error(std::get<int64_t>(rhs) == 0 ? "Integer division by zero." : "Integer division overflow.", p->line);
+        }
+        throw Error("Unsupported binary operator.", p->line);
+    }
+    if (auto p = dynamic_cast<const CallExpr*>(expr)) {
+        return EvaluateCall(p, frame);
+    }
+
+    throw Error("Unsupported expression type.", expr->line);
+}
+
+Value Interpreter::EvaluateCall(const CallExpr* call, Frame& frame) {
+    auto& callee = ResolveCallee(call);
+    return Invoke(callee, EvaluateArguments(call, frame), call->line);
+}
+
+Interpreter::FunctionEntry& Interpreter::ResolveCallee(const CallExpr* call) {
+    auto ident = dynamic_cast<const IdentifierExpr*>(call->callee.get());
+    auto it = ident ? functions.find(ident->value.identName) : functions.end();
+    if (it == functions.end()) {
+        throw Error("Call to unknown function.", call->line);
+    }
+    return it->second;
+}
+
+std::vector<Value> Interpreter::EvaluateArguments(const CallExpr* call, Frame& frame) {
+    std::vector<Value> args;
+    args.reserve(call->args.size());
+    for (const auto& arg : call->args) {
+        args.push_back(Evaluate(arg.get(), frame));
+    }
+    return args;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Analysis/ConstantFolding.hpp"
+#include "Parsing/Statement.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pl {
+    // Interpreter values share the constant folder's representation and arithmetic, so both agree on
+    // overflow and division semantics.
+    using Value = ConstantValue;
+
+    // Uniform native calling convention for promoted functions. Integers travel sign- or zero-extended
+    // to 64 bits according to their type, floats as the bits of a double.
+    using NativeThunk = void (*)(const uint64_t* args, uint64_t* result);
+
+    class NativeTier {
+        public:
+            virtual ~NativeTier() = default;
+
+            // Compiles the function to native code, or returns nullptr if it cannot be compiled.
+            virtual NativeThunk Compile(const FuncDeclStmt& func) = 0;
+    };
+
+    struct InterpreterSettings {
+        uint64_t tierUpThreshold = 0;       // Calls before a function is handed to the native tier, 0 never promotes.
+        uint64_t maxSteps = 0;              // Statements executed per Call, 0 is unlimited.
+        uint32_t maxCallDepth = 10000;
+        uint64_t maxMemory = 0;             // Bytes held by live frames and their values, 0 is unlimited.
+        uint64_t maxNativeStack = 4 << 20;  // Host stack used by nested calls, checked before the depth limit can overflow it.
+        bool memoize = false;               // Reuse results of deterministic functions called with equal arguments.
+    };
+
+    class Interpreter {
+        private:
+            // Compares values bitwise, so that e.g. 0.0 and -0.0 are distinct arguments.
+            struct ArgsHash {
+                size_t operator()(const std::vector<Value>& args) const;
+            };
+            struct ArgsEqual {
+                bool operator()(const std::vector<Value>& a, const std::vector<Value>& b) const;
+            };
+
+            struct FunctionEntry {
+                FuncDeclStmtSP decl;
+                uint64_t callCount = 0;
+                NativeThunk native = nullptr;
+                bool promotionFailed = false;
+                std::unordered_map<std::vector<Value>, Value, ArgsHash, ArgsEqual> memo;
+            };
+
+            static constexpr size_t MaxMemoEntries = 1 << 16;   // Per function.
+
+            struct Frame {
+                const FuncDeclStmt* function = nullptr;
+                std::vector<Value> args;
+
+                // Set by 'return f(...)': Invoke runs the callee in place of this frame once it has unwound.
+                FunctionEntry* tailCallee = nullptr;
+                std::vector<Value> tailArgs;
+            };
+
+            struct RuntimeError final : std::exception { };
+
+            InterpreterSettings settings;
+            NativeTier* nativeTier = nullptr;
+            std::unordered_map<std::string, FunctionEntry> functions;
+            std::vector<ErrorInfo> errors;
+
+            uint64_t steps = 0;
+            uint32_t callDepth = 0;
+            uint64_t memory = 0;
+            uintptr_t stackBase = 0;
+            uint64_t promotedCount = 0;
+            uint64_t memoHits = 0;
+
+        public:
+            explicit Interpreter(const std::vector<FileSourceNodeSP>& files, const InterpreterSettings& settings = {});
+
+            void SetNativeTier(NativeTier* tier) { nativeTier = tier; }
+
+            // Calls a function by name. Returns nullopt and records an error if execution fails.
+            std::optional<Value> Call(std::string_view name, const std::vector<Value>& args);
+
+            // Evaluates an expression that refers to no local values, e.g. the operand of 'comptime'.
+            std::optional<Value> EvaluateConstant(const ExprBase& expr);
+
+            [[nodiscard]] FuncDeclStmtSP FindFunction(std::string_view name) const;
+
+            [[nodiscard]] uint64_t GetPromotedCount() const { return promotedCount; }
+            [[nodiscard]] uint64_t GetMemoHits() const { return memoHits; }
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            RuntimeError Error(std::string_view msg, int line);
+            void Step(int line);
+            void Reset();
+
+            Value Invoke(FunctionEntry& entry, std::vector<Value> args, int line);
+            Value Execute(FunctionEntry& entry, std::vector<Value> args, int line);
+            Value InvokeNative(const FunctionEntry& entry, const std::vector<Value>& args);
+            bool PromoteIfHot(FunctionEntry& entry);
+
+            // Returns the function's result once a return statement executed.
+            std::optional<Value> ExecStatement(const StmtBase* stmt, Frame& frame);
+            Value Evaluate(const ExprBase* expr, Frame& frame);
+            Value EvaluateCall(const CallExpr* call, Frame& frame);
+            FunctionEntry& ResolveCallee(const CallExpr* call);
+            std::vector<Value> EvaluateArguments(const CallExpr* call, Frame& frame);
+    };
+}
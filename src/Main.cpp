@@ -1,33 +1,19 @@
-#include "Analysis/SemanticAnalysis.hpp"
+#include "Driver/CompileServer.hpp"
+#include "Driver/Driver.hpp"
+#include "Driver/Options.hpp"
 #include "Utils/Utils.hpp"
-#include <Parsing/Parser.hpp>
-#include <fmt/core.h>
-#include <fmt/color.h>
+#include <vector>
 
-
-const auto testSource = R"(
-return 2;
-
-func Main() i32 {
-    return 2
-}
-
-func aaa(Main b) void {
-    return 2;
-}
-)";
-
-int main() {
-    auto parser = pl::SourceParser::FromString(testSource, "test.fr");
-    auto node = parser.Parse();
-
-    if (parser.HadErrors()) {
-        pl::ReportErrors("Parsing errors.", parser.GetErrors());
+int main(int argc, char** argv) {
+    if (auto status = pl::ForwardToCompileServer(argc, argv)) {
+        return *status;
     }
 
-    pl::SemanticAnalyzer sema({node}, "TestModule");
-    sema.Analyze();
-    if (sema.HadErrors()) {
-        pl::ReportErrors("Semantic analysis errors.", sema.GetErrors());
+    std::vector<pl::ErrorInfo> optionErrors;
+    const auto options = pl::ParseCommandLine(argc, argv, optionErrors);
+    if (!optionErrors.empty()) {
+        pl::ReportErrors("Invalid command line.", optionErrors, true);
     }
-}
\ No newline at end of file
+
+    return pl::RunDriver(options);
+}
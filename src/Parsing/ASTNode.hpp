@@ -1,4 +1,5 @@
 #pragma once
+#include <Common/FileID.hpp>
 #include <memory>
 #include <vector>
 
@@ -15,6 +16,7 @@ namespace pl {
     struct FileSourceNode : public ASTNode {
         std::string filename;
         std::vector<std::shared_ptr<StmtBase>> statements;
+        FileID file = InvalidFileID;    // In the SourceManager of the build, for diagnostics that show source lines.
 
         FileSourceNode(const std::string& filename, std::vector<std::shared_ptr<StmtBase>> statements)
             : filename(filename), 
@@ -0,0 +1,124 @@
+#include "ASTPrinter.hpp"
+#include "Expression.hpp"
+#include "Statement.hpp"
+#include "Type.hpp"
+#include "fmt/core.h"
+#include <Utils/Utils.hpp>
+
+using namespace pl;
+
+namespace {
+    class ASTPrinter {
+        private:
+            std::string out;
+            int depth = 0;
+
+        public:
+            std::string Print(const FileSourceNode& file) {
+                Line(fmt::format("File '{}'", file.filename));
+                depth++;
+                for (const auto& stmt : file.statements) PrintStatement(stmt);
+                depth--;
+                return std::move(out);
+            }
+
+        private:
+            void Line(std::string_view text) {
+                out.append(static_cast<size_t>(depth) * 2, ' ');
+                out += text;
+                out += '\n';
+            }
+
+            static std::string TypeString(const TypeSP& type) {
+                if (auto p = InstanceOf<NamedType>(type)) return p->name.identName;
+                return "?";
+            }
+
+            void PrintStatement(const StmtSP& stmt) {
+                if (!stmt) return;
+
+                if (auto p = InstanceOf<FuncDeclStmt>(stmt)) {
+                    std::string args;
+                    for (const auto& arg : p->args) {
+                        if (!args.empty()) args += ", ";
+                        args += fmt::format("{} {}", arg.name.identName, TypeString(arg.type));
+                    }
+                    const auto prefix = p->isComptime ? "comptime " : p->isExported ? "export " : "";
+                    Line(fmt::format("{}FuncDecl {}({}) {} <line {}>", prefix, p->name.identName, args, TypeString(p->returnType), p->line));
+                    Nested(p->body);
+                }
+                else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+                    Line(fmt::format("Return <line {}>", p->line));
+                    Nested(p->value);
+                }
+                else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+                    Line(fmt::format("Block <line {}>", p->line));
+                    depth++;
+                    for (const auto& s : p->body) PrintStatement(s);
+                    depth--;
+                }
+                else if (auto p = InstanceOf<ExprStmt>(stmt)) {
+                    Line(fmt::format("ExprStmt <line {}>", p->line));
+                    Nested(p->expr);
+                }
+                else Line("<unknown statement>");
+            }
+
+            void PrintExpression(const ExprSP& expr) {
+                if (!expr) return;
+
+                if (auto p = InstanceOf<LiteralExpr>(expr)) Line(fmt::format("Literal {}", p->value.ToString()));
+                else if (auto p = InstanceOf<IdentifierExpr>(expr)) Line(fmt::format("Identifier {}", p->value.identName));
+                else if (auto p = InstanceOf<ParenExpr>(expr)) {
+                    Line("Paren");
+                    Nested(p->subExpr);
+                }
+                else if (auto p = InstanceOf<ComptimeExpr>(expr)) {
+                    Line("Comptime");
+                    Nested(p->subExpr);
+                }
+                else if (auto p = InstanceOf<UnaryExpr>(expr)) {
+                    Line(fmt::format("Unary {}", p->op.ToString()));
+                    Nested(p->subExpr);
+                }
+                else if (auto p = InstanceOf<BinaryExpr>(expr)) {
+                    Line(fmt::format("Binary {}", p->op.ToString()));
+                    depth++;
+                    PrintExpression(p->left);
+                    PrintExpression(p->right);
+                    depth--;
+                }
+                else if (auto p = InstanceOf<CallExpr>(expr)) {
+                    Line("Call");
+                    depth++;
+                    PrintExpression(p->callee);
+                    for (const auto& arg : p->args) PrintExpression(arg);
+                    depth--;
+                }
+                else if (auto p = InstanceOf<IndexExpr>(expr)) {
+                    Line("Index");
+                    depth++;
+                    PrintExpression(p->indexedExpr);
+                    for (const auto& index : p->indices) PrintExpression(index);
+                    depth--;
+                }
+                else Line("<unknown expression>");
+            }
+
+            void Nested(const StmtSP& stmt) {
+                depth++;
+                PrintStatement(stmt);
+                depth--;
+            }
+
+            void Nested(const ExprSP& expr) {
+                depth++;
+                PrintExpression(expr);
+                depth--;
+            }
+    };
+}
+
+std::string pl::PrintAST(const FileSourceNode& file) {
+    return ASTPrinter().Print(file);
+}
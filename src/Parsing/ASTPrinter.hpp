@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ASTNode.hpp"
+#include <string>
+
+namespace pl {
+    // Renders a parsed file as an indented tree, one node per line, for '--emit=ast'.
+    std::string PrintAST(const FileSourceNode& file);
+}
@@ -62,10 +62,20 @@ namespace pl {
 
     using ParenSP = std::shared_ptr<ParenExpr>;
 
+    // 'comptime <expr>': evaluated during semantic analysis and replaced by its value.
+    struct ComptimeExpr final : public ExprBase {
+        ExprSP subExpr;
+
+        explicit ComptimeExpr(ExprSP subExpr) : subExpr(std::move(subExpr)) { }
+    };
+
+    using ComptimeSP = std::shared_ptr<ComptimeExpr>;
+
 
     struct CallExpr final : public ExprBase {
         ExprSP callee;
         std::vector<ExprSP> args;
+        bool isTailCall = false;    // Set by semantic analysis for 'return f(...)'.
 
         explicit CallExpr(ExprSP callee, std::vector<ExprSP> args) : callee(std::move(callee)), args(std::move(args)) { }
     };
@@ -4,11 +4,15 @@
 using namespace pl;
 
 ExprSP SourceParser::LiteralParser::Parse(SourceParser&, Token tok) const {
-    return MakeSP<LiteralExpr>(tok);
+    auto out = MakeSP<LiteralExpr>(tok);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 ExprSP SourceParser::IdentifierParser::Parse(SourceParser&, Token tok) const {
-    return MakeSP<IdentifierExpr>(tok);
+    auto out = MakeSP<IdentifierExpr>(tok);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 ExprSP SourceParser::GroupingParser::Parse(SourceParser& src, Token) const {
@@ -17,9 +21,19 @@ ExprSP SourceParser::GroupingParser::Parse(SourceParser& src, Token) const {
     return expr;
 }
 
+ExprSP SourceParser::ComptimeParser::Parse(SourceParser& src, Token tok) const {
+    // Binds as loosely as possible, so 'comptime a + b' evaluates the whole sum.
+    auto expr = src.ParseExpression(0);
+    auto out = MakeSP<ComptimeExpr>(expr);
+    out->line = tok.lineNumber;
+    return out;
+}
+
 ExprSP SourceParser::PrefixOperatorParser::Parse(SourceParser& src, Token tok) const {
     auto right = src.ParseExpression(rbp);
-    return MakeSP<UnaryExpr>(tok, right);
+    auto out = MakeSP<UnaryExpr>(tok, right);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 float SourceParser::PrefixOperatorParser::Precedence() const {
@@ -28,7 +42,9 @@ float SourceParser::PrefixOperatorParser::Precedence() const {
 
 ExprSP SourceParser::BinaryOperatorParser::Parse(SourceParser& src, ExprSP left, Token tok) const {
     auto right = src.ParseExpression(rbp);
-    return MakeSP<BinaryExpr>(tok, left, right);
+    auto out = MakeSP<BinaryExpr>(tok, left, right);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 float SourceParser::BinaryOperatorParser::Lbp() const {
@@ -36,14 +52,16 @@ float SourceParser::BinaryOperatorParser::Lbp() const {
 }
 
 ExprSP SourceParser::PostfixOperatorParser::Parse(SourceParser&, ExprSP left, Token tok) const {
-    return MakeSP<UnaryExpr>(tok, left);
+    auto out = MakeSP<UnaryExpr>(tok, left);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 float SourceParser::PostfixOperatorParser::Precedence() const {
     return precedence;
 }
 
-ExprSP SourceParser::CallParser::Parse(SourceParser& src, ExprSP left, Token) const {
+ExprSP SourceParser::CallParser::Parse(SourceParser& src, ExprSP left, Token tok) const {
     std::vector<ExprSP> args;
 
     if (!src.Check(TokenType::CloseParen)) {
@@ -54,14 +72,16 @@ ExprSP SourceParser::CallParser::Parse(SourceParser& src, ExprSP left, Token) co
         }
     }
     src.Consume(TokenType::CloseParen, "Expected ')'.");
-    return MakeSP<CallExpr>(left, args);
+    auto out = MakeSP<CallExpr>(left, args);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 float SourceParser::CallParser::Precedence() const {
     return precedence;
 }
 
-ExprSP SourceParser::IndexParser::Parse(SourceParser& src, ExprSP left, Token) const {
+ExprSP SourceParser::IndexParser::Parse(SourceParser& src, ExprSP left, Token tok) const {
     std::vector<ExprSP> args;
 
     if (!src.Check(TokenType::CloseSquare)) {
@@ -72,7 +92,9 @@ ExprSP SourceParser::IndexParser::Parse(SourceParser& src, ExprSP left, Token) c
         }
     }
     src.Consume(TokenType::CloseSquare, "Expected ']'.");
-    return MakeSP<IndexExpr>(left, args);
+    auto out = MakeSP<IndexExpr>(left, args);
+    out->line = tok.lineNumber;
+    return out;
 }
 
 float SourceParser::IndexParser::Precedence() const {
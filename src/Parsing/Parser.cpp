@@ -5,6 +5,7 @@
 #include "Statement.hpp"
 #include "Token.hpp"
 #include "Type.hpp"
+#include "Utils/TimeTrace.hpp"
 #include "fmt/core.h"
 #include "magic_enum/magic_enum.hpp"
 #include <Utils/Utils.hpp>
@@ -18,6 +19,7 @@ SourceParser::SourceParser() {
         {TokenType::StringLiteral, MakeSP<LiteralParser>()},
         {TokenType::Identifier, MakeSP<IdentifierParser>()},
         {TokenType::OpenParen, MakeSP<GroupingParser>()},
+        {TokenType::KwComptime, MakeSP<ComptimeParser>()},
 
         {TokenType::Plus, MakeSP<PrefixOperatorParser>(30)},
         {TokenType::Minus, MakeSP<PrefixOperatorParser>(30)},
@@ -52,29 +54,30 @@ SourceParser SourceParser::FromFile(const std::filesystem::path &path) {
 }
 
 SourceParser SourceParser::FromScanner(Scanner& scanner, std::string_view filename) {
+    auto parser = SourceParser::FromTokens(scanner.ScanAll(), filename);
+    // Reported with the parse errors, by whoever reports those.
+    parser.errors = scanner.GetErrors();
+    return parser;
+}
+
+SourceParser SourceParser::FromTokens(std::vector<Token> tokens, std::string_view filename) {
     SourceParser parser;
     parser.filename = filename;
+    parser.tokens = std::move(tokens);
 
-    if (!scanner.IsOpen()) {
+    // Unreadable input yields no tokens at all.
+    if (parser.tokens.empty()) {
         Token tok;
         tok.type = TokenType::EoF;
         parser.tokens.push_back(tok);
-        return parser;
-    }
-
-    while (scanner.IsValid()) {
-        auto tok = scanner.GetToken();
-        parser.tokens.push_back(tok);
-    }
-
-    if (scanner.HadErrors()) {
-        ReportErrors(scanner.GetErrors());
     }
 
     return parser;
 }
 
 FileSourceNodeSP SourceParser::Parse() {
+    TimeTraceScope timeScope("SourceParser::Parse", filename);
+
     SList statements;
     while (!IsAtEnd()) {
         try {
@@ -99,6 +102,11 @@ Token& SourceParser::Peek() {
     return tokens[current];
 }
 
+Token& SourceParser::PeekNext() {
+    if (IsAtEnd()) return Peek();
+    return tokens[current + 1];
+}
+
 Token& SourceParser::Previous() {
     return tokens.at(current - 1);
 }
@@ -165,6 +173,15 @@ TypeSP SourceParser::TNamed() {
 StmtSP SourceParser::Statement() {
     try {
         if (Match(TokenType::KwFunc)) return SFunctionDecl();
+        if (Check(TokenType::KwComptime) && PeekNext().type == TokenType::KwFunc) {
+            Advance();
+            Advance();
+            return SFunctionDecl(true);
+        }
+        if (Match(TokenType::KwExport)) {
+            Consume(TokenType::KwFunc, "Expected 'func' after 'export'.");
+            return SFunctionDecl(false, true);
+        }
         if (Match(TokenType::KwReturn)) return SReturn();
         if (Match(TokenType::OpenBracket)) return SBlock();
 
@@ -175,7 +192,7 @@ StmtSP SourceParser::Statement() {
     }
 }
 
-StmtSP SourceParser::SFunctionDecl() {
+StmtSP SourceParser::SFunctionDecl(bool isComptime, bool isExported) {
     int line = Previous().lineNumber;
     auto name = Consume(TokenType::Identifier, "Expected identifier.");
     Consume(TokenType::OpenParen, "Expected '(' after function identifier.");
@@ -207,6 +224,8 @@ StmtSP SourceParser::SFunctionDecl() {
 
     auto out = MakeSP<FuncDeclStmt>(name, args, rtype, body);
     out->line = line;
+    out->isComptime = isComptime;
+    out->isExported = isExported;
     return out;
 }
 
@@ -238,7 +257,9 @@ StmtSP SourceParser::SBlock() {
 }
 
 StmtSP SourceParser::SExpr() {
-    auto out = MakeSP<ExprStmt>(ParseExpression());
+    auto expr = ParseExpression();
+    auto out = MakeSP<ExprStmt>(expr);
+    out->line = expr->line;
     Consume(TokenType::SemiColon, "Expected semicolon after expression.");
     return out;
 }
@@ -36,6 +36,7 @@ namespace pl {
             static SourceParser FromFile(const std::filesystem::path& path);
 
             static SourceParser FromScanner(Scanner& scanner, std::string_view filename);
+            static SourceParser FromTokens(std::vector<Token> tokens, std::string_view filename);
 
             FileSourceNodeSP Parse();
 
@@ -45,6 +46,7 @@ namespace pl {
         private:
             bool IsAtEnd();
             Token& Peek();
+            Token& PeekNext();
             Token& Previous();
             Token& Advance();
             Token& Consume(TokenType type, std::string_view msg);
@@ -59,7 +61,7 @@ namespace pl {
             TypeSP TNamed();
 
             StmtSP Statement();
-            StmtSP SFunctionDecl();
+            StmtSP SFunctionDecl(bool isComptime = false, bool isExported = false);
             StmtSP SReturn();
             StmtSP SBlock();
 
@@ -103,6 +105,10 @@ namespace pl {
                 [[nodiscard]] ExprSP Parse(SourceParser&, Token) const override;
             };
 
+            struct ComptimeParser final : public PrefixParser {
+                [[nodiscard]] ExprSP Parse(SourceParser&, Token) const override;
+            };
+
             struct PrefixOperatorParser final : public PrefixParser {
                 float rbp;
                 explicit PrefixOperatorParser(const float rbp) : rbp(rbp) { }
@@ -1,5 +1,6 @@
 #include "Scanner.hpp"
 #include "Token.hpp"
+#include "Utils/TimeTrace.hpp"
 #include "fmt/core.h"
 #include "magic_enum/magic_enum.hpp"
 #include <Utils/Utils.hpp>
@@ -7,11 +8,9 @@
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <memory>
 #include <ranges>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -22,6 +21,8 @@ using namespace pl;
 static const std::unordered_map<std::string, TokenType> Keywords = {
     {"func", TokenType::KwFunc},
     {"return", TokenType::KwReturn},
+    {"comptime", TokenType::KwComptime},
+    {"export", TokenType::KwExport},
 };
 
 static const std::unordered_map<std::string, TokenType> Punctuations = {
@@ -110,7 +111,7 @@ void pl::TestPunctuation() {
 void Scanner::ScannerError(std::string_view msg) {
     //ReportError(fmt::format("[Scanner error] {}", msg));
     errors.emplace_back(
-        "test",
+        filename,
         std::string(msg),
         currentLine
     );
@@ -142,24 +143,25 @@ Scanner Scanner::FromString(std::string_view str, std::string_view filename) {
     return Scanner(str, filename);
 }
 
+Scanner Scanner::FromSource(const SourceManager& sources, FileID file) {
+    Scanner scanner(sources.GetText(file), sources.GetName(file));
+    scanner.handleValid = true;
+    return scanner;
+}
+
 Scanner::Scanner(const std::filesystem::path& filepath) {
-    handleValid = std::filesystem::exists(filepath);
-    if(handleValid) {
-        auto ptr = std::make_shared<std::ifstream>();
-        ptr->open(filepath.string());
-        inputStream = ptr;
+    std::error_code ec;
+    ownedBuffer = MappedFile::Open(filepath, ec);
+    handleValid = ownedBuffer != nullptr;
+    if (handleValid) {
+        text = ownedBuffer->GetText();
         filename = filepath.filename();
     }
 }
 
 Scanner::Scanner(std::string_view str, std::string_view filename) {
     handleValid = !str.empty();
-
-    if (handleValid) {
-        auto ptr = std::make_shared<std::stringstream>();
-        ptr->str(std::string(str));
-        inputStream = ptr;
-    }
+    text = str;
     this->filename = filename;
 }
 
@@ -170,7 +172,7 @@ Token Scanner::GetToken() {
         out.type = TokenType::Error;
         out.lineNumber = currentLine;
     }
-    else if (inputStream->eof()) {
+    else if (atEnd) {
         handleValid = false;
         out.type = TokenType::EoF;
         out.lineNumber = currentLine;
@@ -182,26 +184,40 @@ Token Scanner::GetToken() {
     return out;
 }
 
+std::vector<Token> Scanner::ScanAll() {
+    TimeTraceScope timeScope("Scanner", filename);
+
+    std::vector<Token> tokens;
+    while (IsValid()) {
+        tokens.push_back(GetToken());
+    }
+    return tokens;
+}
+
 char Scanner::Advance() {
-    char c = inputStream->get();
-    if (inputStream->eof()) {
+    if (atEnd || position >= text.size()) {
+        atEnd = true;
         handleValid = false;
         return '\0';
     }
-    return c;
+    return text[position++];
 }
 
 char Scanner::Peek() {
-    if (inputStream->eof()) {
+    if (atEnd) {
         handleValid = false;
         return '\0';
     }
-    return inputStream->peek();
+    if (position >= text.size()) {
+        atEnd = true;
+        return '\0';
+    }
+    return text[position];
 }
 
 char Scanner::PeekNext() {
     char c = Advance();
-    inputStream->unget();
+    if (!atEnd) position--;
     return c;
 }
 
@@ -215,7 +231,7 @@ bool Scanner::Match(char c) {
 
 void Scanner::ScanToken(Token& out) {
     char c = Advance();
-    if (inputStream->eof()) {
+    if (atEnd) {
         out.type = TokenType::EoF;
         out.lineNumber = currentLine;
         return;
@@ -245,7 +261,7 @@ void Scanner::ScanToken(Token& out) {
         } while (skipFlag);
     }
 
-    if (inputStream->eof()) {
+    if (atEnd) {
         out.type = TokenType::EoF;
         out.lineNumber = currentLine;
         return;
@@ -2,9 +2,10 @@
 #include "Common/ErrorInfo.hpp"
 #include <vector>
 #include "Token.hpp"
+#include <Utils/SourceManager.hpp>
 #include <filesystem>
-#include <istream>
 #include <memory>
+#include <string>
 #include <string_view>
 
 namespace pl {
@@ -13,7 +14,10 @@ namespace pl {
     class Scanner {
         private:
             bool handleValid = false;
-            std::shared_ptr<std::istream> inputStream;
+            std::string_view text;
+            size_t position = 0;
+            bool atEnd = false;     // A read went past the end of the text.
+            std::shared_ptr<MappedFile> ownedBuffer;    // Only for FromFile.
             int currentLine = 0;
             std::vector<ErrorInfo> errors;
             std::string filename;
@@ -21,7 +25,9 @@ namespace pl {
         public:
             ~Scanner() = default;
             static Scanner FromFile(const std::filesystem::path& filepath);
+            // Scans the text in place; it must outlive the scanner.
             static Scanner FromString(std::string_view str, std::string_view filename);
+            static Scanner FromSource(const SourceManager& sources, FileID file);
             [[nodiscard]] bool IsOpen() const { return handleValid; }
             [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
             [[nodiscard]] bool IsValid() const { return IsOpen() && !HadErrors(); }
@@ -46,6 +52,9 @@ namespace pl {
 
         public:
             Token GetToken();
-            
+
+            // Scans the rest of the input. The tokens end with EoF unless scanning failed.
+            std::vector<Token> ScanAll();
+
     };
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Token.hpp"
 #include "Type.hpp"
 #include "Expression.hpp"
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -26,6 +27,23 @@ namespace pl {
 
     typedef std::shared_ptr<ExprStmt> ExprStmtSP;
 
+    enum class MemoryEffect : uint8_t {
+        None,
+        Read,
+        ReadWrite,
+    };
+
+    // What a call may do besides computing its result. Conservative until InferFunctionEffects has run.
+    struct FunctionEffects {
+        MemoryEffect memory = MemoryEffect::ReadWrite;
+        bool mayUnwind = true;
+        bool mayDiverge = true;     // May never return, e.g. through recursion.
+
+        // The result depends only on the arguments, so calls with equal arguments may share it.
+        [[nodiscard]] bool IsDeterministic() const { return memory == MemoryEffect::None; }
+        [[nodiscard]] bool IsPure() const { return IsDeterministic() && !mayUnwind && !mayDiverge; }
+    };
+
     struct FuncDeclStmt final : public StmtBase {
         struct ArgPair {
             TypeSP type;
@@ -37,6 +55,9 @@ namespace pl {
         ArgList args;
         TypeSP returnType;
         StmtSP body;
+        bool isComptime = false;    // 'comptime func': only callable at compile time, never emitted.
+        bool isExported = false;    // 'export func': kept by dead function elimination even when unused.
+        FunctionEffects effects;
 
         FuncDeclStmt(Token name, ArgList args, TypeSP rType, StmtSP body)
             : name(std::move(name)),
@@ -47,6 +47,8 @@ namespace pl {
 
         KwFunc,
         KwReturn,
+        KwComptime,
+        KwExport,
     };
 
     struct Token {
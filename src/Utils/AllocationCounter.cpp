@@ -0,0 +1,55 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+
+using namespace pl;
+
+// Constant-initialised, as the hooks run before any dynamic initialisation.
+static constinit std::atomic<bool> available = false;
+static constinit std::atomic<bool> enabled = false;
+static constinit std::atomic<uint64_t> allocations = 0;
+static constinit std::atomic<uint64_t> allocatedBytes = 0;
+static constinit std::atomic<int64_t> liveBytes = 0;
+static constinit std::atomic<int64_t> peakLiveBytes = 0;
+
+bool AllocationCounter::IsAvailable() {
+    return available.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::MarkAvailable() {
+    available.store(true, std::memory_order_relaxed);
+}
+
+void AllocationCounter::Enable() {
+    ResetPeak();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+bool AllocationCounter::IsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+AllocationSnapshot AllocationCounter::Snapshot() {
+    return {
+        allocations.load(std::memory_order_relaxed),
+        allocatedBytes.load(std::memory_order_relaxed),
+        liveBytes.load(std::memory_order_relaxed),
+        peakLiveBytes.load(std::memory_order_relaxed)
+    };
+}
+
+void AllocationCounter::ResetPeak() {
+    peakLiveBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void AllocationCounter::RecordAllocation(size_t bytes) {
+    const auto live = liveBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    auto peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+}
+
+void AllocationCounter::RecordFree(size_t bytes) {
+    liveBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pl {
+    struct AllocationSnapshot {
+        uint64_t allocations = 0;       // Counted while enabled.
+        uint64_t allocatedBytes = 0;    // Counted while enabled.
+        int64_t liveBytes = 0;          // Allocated less freed while enabled, so only differences are meaningful.
+        int64_t peakLiveBytes = 0;      // Since the last ResetPeak.
+    };
+
+    // Process-wide allocation totals, fed by the replacement operator new and delete that only the fractac
+    // executable links in (AllocationHooks.cpp). Nothing is tracked until enabled for --mem-report, so other
+    // runs pay one relaxed load per allocation. Live bytes count from then on: blocks allocated before and freed
+    // after lower them.
+    class AllocationCounter {
+        public:
+            // False when the hooks are not part of the program, e.g. on platforms without malloc_usable_size.
+            static bool IsAvailable();
+            static void MarkAvailable();
+
+            static void Enable();
+            static bool IsEnabled();
+            static AllocationSnapshot Snapshot();
+            // Restarts the peak from the current live size.
+            static void ResetPeak();
+
+            // Only called while enabled.
+            static void RecordAllocation(size_t bytes);
+            static void RecordFree(size_t bytes);
+    };
+}
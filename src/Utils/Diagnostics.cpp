@@ -0,0 +1,287 @@
+#include "Diagnostics.hpp"
+#include "SourceManager.hpp"
+#include "fmt/args.h"
+#include "fmt/color.h"
+#include "fmt/format.h"
+#include "magic_enum/magic_enum.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <tuple>
+
+using namespace pl;
+
+// A JSON string literal. Bytes that are not valid UTF-8 become U+FFFD, as JSON text must be UTF-8.
+static std::string QuoteJSON(std::string_view text) {
+    std::string out = "\"";
+    for (size_t i = 0; i < text.size(); ) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x80) {
+            const size_t length = c >= 0xF5 ? 0 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC2 ? 2 : 0;
+            bool valid = length > 0 && i + length <= text.size();
+            for (size_t k = 1; valid && k < length; k++) valid = (static_cast<unsigned char>(text[i + k]) & 0xC0) == 0x80;
+            if (valid) out.append(text.substr(i, length));
+            else out += "\uFFFD";
+            i += valid ? length : 1;
+            continue;
+        }
+
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) fmt::format_to(std::back_inserter(out), "\\u{:04x}", c);
+                else out += static_cast<char>(c);
+        }
+        i++;
+    }
+    out += '"';
+    return out;
+}
+
+static std::string_view GetFormat(DiagID id) {
+    switch (id) {
+        case DiagID::Custom: return "{}";
+        case DiagID::FunctionRedefined: return "Function '{}' already defined.";
+        case DiagID::GlobalStatement: return "Global scope only supports function and type declarations.";
+        case DiagID::UnsupportedStatement: return "Unsupported statement type.";
+        case DiagID::NestedFunction: return "Functions may only be declared on file scope.";
+        case DiagID::InvalidArgumentType: return "Argument '{}' has invalid type '{}'.";
+        case DiagID::UnknownReturnType: return "Function '{}' has unknown return type '{}'.";
+        case DiagID::ComptimeWithoutBody: return "Compile-time function '{}' must have a body.";
+        case DiagID::ExportWithoutBody: return "Exported function '{}' must have a body.";
+        case DiagID::ArgumentShadows: return "Argument '{}' shadows already existing name.";
+        case DiagID::MissingReturn: return "Function '{}' must return a value of type '{}'.";
+        case DiagID::ReturnOutsideFunction: return "Return statement outside of a function.";
+        case DiagID::ReturnFromVoid: return "Function '{}' returns void and cannot return a value.";
+        case DiagID::ReturnTypeMismatch: return "Cannot return a value of type '{}' from function '{}' returning '{}'.";
+        case DiagID::UnsupportedExpression: return "Unsupported expression type.";
+        case DiagID::StringLiteral: return "String literals are not supported yet.";
+        case DiagID::UndefinedIdentifier: return "Undefined identifier '{}'.";
+        case DiagID::FunctionAsValue: return "Function '{}' cannot be used as a value.";
+        case DiagID::UnsupportedUnary: return "Unary operator '{}' is not supported yet.";
+        case DiagID::NonNumericUnary: return "Unary operator '{}' requires a numeric operand, got '{}'.";
+        case DiagID::NonNumericBinary: return "Operator '{}' requires numeric operands, got '{}' and '{}'.";
+        case DiagID::MismatchedOperands: return "Mismatched operand types '{}' and '{}' for operator '{}'.";
+        case DiagID::UnnamedCall: return "Only named functions can be called.";
+        case DiagID::UndefinedFunction: return "Undefined function '{}'.";
+        case DiagID::NotAFunction: return "'{}' is not a function.";
+        case DiagID::ArgumentCount: return "Function '{}' expects {} arguments, got {}.";
+        case DiagID::ArgumentTypeMismatch: return "Argument {} of '{}' has type '{}', expected '{}'.";
+        case DiagID::NonTailRecursion: return "Recursive call to '{}' is not in tail position and needs a stack frame per level.";
+        case DiagID::TailCallSignatureMismatch:
+            return "Recursive tail call to '{}' cannot reuse the frame of '{}', whose signature differs, and needs a stack frame per level.";
+    }
+    return "{}";
+}
+
+// Uses of an undefined name repeat its first error, so only that one is kept.
+static bool IsOncePerContext(DiagID id) {
+    return id == DiagID::UndefinedIdentifier || id == DiagID::UndefinedFunction;
+}
+
+size_t DiagnosticsEngine::EntryHash::operator()(uint32_t index) const {
+    const auto& entry = engine->entries[index];
+    size_t hash = std::hash<uint64_t>()((uint64_t(entry.id) << 32) | entry.context);
+    if (!IsOncePerContext(entry.id)) hash = hash * 31 + std::hash<int>()(entry.line);
+    for (uint32_t i = 0; i < entry.argCount; i++) {
+        hash = hash * 31 + std::hash<std::string>()(engine->args[entry.firstArg + i]);
+    }
+    return hash;
+}
+
+bool DiagnosticsEngine::EntryEqual::operator()(uint32_t a, uint32_t b) const {
+    const auto& left = engine->entries[a];
+    const auto& right = engine->entries[b];
+    if (left.id != right.id || left.context != right.context || left.argCount != right.argCount) return false;
+    if (!IsOncePerContext(left.id) && left.line != right.line) return false;
+    for (uint32_t i = 0; i < left.argCount; i++) {
+        if (engine->args[left.firstArg + i] != engine->args[right.firstArg + i]) return false;
+    }
+    return true;
+}
+
+DiagnosticsEngine::DiagnosticsEngine(const DiagnosticsSettings& settings)
+    : settings(settings), seen(0, EntryHash{this}, EntryEqual{this}) { }
+
+uint32_t DiagnosticsEngine::InternContext(std::string_view context, FileID file) {
+    // Producers report file by file, so the context is almost always the last one.
+    uint32_t id = static_cast<uint32_t>(contexts.size() - 1);
+    if (contexts.empty() || contexts.back() != context) {
+        auto [it, inserted] = contextIds.try_emplace(std::string(context), static_cast<uint32_t>(contexts.size()));
+        if (inserted) {
+            contexts.emplace_back(context);
+            contextFiles.push_back(file);
+        }
+        id = it->second;
+    }
+
+    if (contextFiles[id] == InvalidFileID) contextFiles[id] = file;
+    return id;
+}
+
+bool DiagnosticsEngine::Accepts(bool isWarning) {
+    if (!LimitReached()) return true;
+    if (!isWarning) droppedErrors++;
+    return false;
+}
+
+bool DiagnosticsEngine::IsWarning(DiagID id) {
+    return id == DiagID::NonTailRecursion || id == DiagID::TailCallSignatureMismatch;
+}
+
+void DiagnosticsEngine::Commit(DiagID id, bool isWarning, uint32_t context, int line, uint32_t firstArg) {
+    const auto index = static_cast<uint32_t>(entries.size());
+    entries.push_back({id, isWarning, static_cast<uint8_t>(args.size() - firstArg), context, firstArg, line});
+
+    if (settings.deduplicate && !seen.insert(index).second) {
+        entries.pop_back();
+        args.resize(firstArg);
+        return;
+    }
+    if (!entries.back().isWarning) errorCount++;
+}
+
+void DiagnosticsEngine::Add(const ErrorInfo& error, bool isWarning, FileID file) {
+    if (!Accepts(isWarning)) return;
+    const auto firstArg = static_cast<uint32_t>(args.size());
+    args.push_back(error.msg);
+    Commit(DiagID::Custom, isWarning, InternContext(error.context, file), error.line, firstArg);
+}
+
+void DiagnosticsEngine::Add(const std::vector<ErrorInfo>& errors, bool areWarnings, FileID file) {
+    for (const auto& error : errors) Add(error, areWarnings, file);
+}
+
+void DiagnosticsEngine::Append(const DiagnosticsEngine& other, const Entry& entry) {
+    if (!Accepts(entry.isWarning)) return;
+    const auto firstArg = static_cast<uint32_t>(args.size());
+    for (uint32_t i = 0; i < entry.argCount; i++) args.push_back(other.args[entry.firstArg + i]);
+    Commit(entry.id, entry.isWarning, InternContext(other.contexts[entry.context], other.contextFiles[entry.context]), entry.line, firstArg);
+}
+
+void DiagnosticsEngine::SortByLocation() {
+    std::stable_sort(entries.begin() + flushed, entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.context, a.line) < std::tie(b.context, b.line);
+    });
+
+    // The set refers to entries by index.
+    if (!settings.deduplicate) return;
+    seen.clear();
+    for (uint32_t i = 0; i < entries.size(); i++) seen.insert(i);
+}
+
+std::string DiagnosticsEngine::FormatMessage(const Entry& entry) const {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    for (uint32_t i = 0; i < entry.argCount; i++) {
+        store.push_back(std::string_view(args[entry.firstArg + i]));
+    }
+    return fmt::vformat(GetFormat(entry.id), store);
+}
+
+std::vector<ErrorInfo> DiagnosticsEngine::Collect(size_t first, bool warnings) const {
+    std::vector<ErrorInfo> result;
+    for (auto i = first; i < entries.size(); i++) {
+        const auto& entry = entries[i];
+        if (entry.isWarning != warnings) continue;
+        result.push_back({contexts[entry.context], FormatMessage(entry), entry.line});
+    }
+    return result;
+}
+
+std::vector<ErrorInfo> DiagnosticsEngine::GetErrors(size_t first) const {
+    return Collect(first, false);
+}
+
+std::vector<ErrorInfo> DiagnosticsEngine::GetWarnings(size_t first) const {
+    return Collect(first, true);
+}
+
+std::string_view DiagnosticsEngine::GetSourceLine(const Entry& entry) const {
+    const auto file = contextFiles[entry.context];
+    if (!sources || file == InvalidFileID || file >= sources->GetFileCount()) return {};
+    return sources->GetLine(file, entry.line);
+}
+
+std::string DiagnosticsEngine::Render(std::string_view header, size_t first) const {
+    return RenderRange(header, first, LimitReached());
+}
+
+std::string DiagnosticsEngine::RenderRange(std::string_view header, size_t first, bool noteLimit) const {
+    std::string out;
+
+    if (settings.format == DiagnosticsFormat::JSON) {
+        auto inserter = std::back_inserter(out);
+        for (auto i = first; i < entries.size(); i++) {
+            const auto& entry = entries[i];
+            fmt::format_to(inserter, R"({{"severity":"{}","id":{},"context":{},"line":{},"message":{})",
+                entry.isWarning ? "warning" : "error", QuoteJSON(magic_enum::enum_name(entry.id)), QuoteJSON(contexts[entry.context]),
+                entry.line, QuoteJSON(FormatMessage(entry)));
+            const auto source = GetSourceLine(entry);
+            if (!source.empty()) fmt::format_to(inserter, R"(,"source":{})", QuoteJSON(source));
+            out += "}\n";
+        }
+        if (noteLimit) {
+            const auto msg = fmt::format("Too many errors, stopped after {} (-ferror-limit={}).", errorCount, settings.errorLimit);
+            fmt::format_to(inserter, R"({{"severity":"note","message":{}}})" "\n", QuoteJSON(msg));
+        }
+        return out;
+    }
+
+    if (first == entries.size() && !noteLimit) return out;
+
+    auto inserter = std::back_inserter(out);
+    if (!header.empty()) fmt::format_to(inserter, fmt::emphasis::bold, "{}\n", header);
+    for (auto i = first; i < entries.size(); i++) {
+        const auto& entry = entries[i];
+        if (entry.isWarning) {
+            fmt::format_to(inserter, fmt::fg(fmt::color::yellow), "Warning [at {}, line {}]:\n\t{}\n", contexts[entry.context], entry.line, FormatMessage(entry));
+        }
+        else {
+            fmt::format_to(inserter, fmt::fg(fmt::color::red), "Error [at {}, line {}]:\n\t{}\n", contexts[entry.context], entry.line, FormatMessage(entry));
+        }
+
+        const auto source = GetSourceLine(entry);
+        if (!source.empty()) fmt::format_to(inserter, "\t{} | {}\n", entry.line, source);
+    }
+    if (noteLimit) {
+        fmt::format_to(inserter, fmt::emphasis::bold, "Too many errors, stopped after {} (-ferror-limit={}).\n", errorCount, settings.errorLimit);
+    }
+    return out;
+}
+
+void DiagnosticsEngine::Flush(std::string_view header, std::FILE* out) {
+    const auto text = RenderRange(header, flushed, LimitReached() && !limitNoted);
+    flushed = entries.size();
+    limitNoted = LimitReached();
+    if (text.empty()) return;
+
+    std::fwrite(text.data(), 1, text.size(), out);
+    std::fflush(out);
+}
+
+void DiagnosticsEngine::Clear() {
+    entries.clear();
+    args.clear();
+    seen.clear();
+    errorCount = 0;
+    droppedErrors = 0;
+    flushed = 0;
+    limitNoted = false;
+}
+
+DiagnosticsCollector::DiagnosticsCollector(size_t shardCount, const DiagnosticsSettings& settings) : shards(shardCount) {
+    for (auto& shard : shards) shard.diagnostics.SetSettings(settings);
+}
+
+void DiagnosticsCollector::MergeInto(DiagnosticsEngine& out) const {
+    for (const auto& shard : shards) {
+        for (const auto& entry : shard.diagnostics.entries) out.Append(shard.diagnostics, entry);
+        // Errors a shard dropped at its own limit count towards the merged one.
+        out.droppedErrors += shard.diagnostics.droppedErrors;
+    }
+    out.SortByLocation();
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <Common/ErrorInfo.hpp>
+#include <Common/FileID.hpp>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pl {
+    class SourceManager;
+
+    // Every message the semantic analyzer produces. Messages of other phases arrive formatted, as Custom.
+    enum class DiagID : uint16_t {
+        Custom,
+
+        FunctionRedefined,
+        GlobalStatement,
+        UnsupportedStatement,
+        NestedFunction,
+        InvalidArgumentType,
+        UnknownReturnType,
+        ComptimeWithoutBody,
+        ExportWithoutBody,
+        ArgumentShadows,
+        MissingReturn,
+        ReturnOutsideFunction,
+        ReturnFromVoid,
+        ReturnTypeMismatch,
+        UnsupportedExpression,
+        StringLiteral,
+        UndefinedIdentifier,
+        FunctionAsValue,
+        UnsupportedUnary,
+        NonNumericUnary,
+        NonNumericBinary,
+        MismatchedOperands,
+        UnnamedCall,
+        UndefinedFunction,
+        NotAFunction,
+        ArgumentCount,
+        ArgumentTypeMismatch,
+
+        NonTailRecursion,
+        TailCallSignatureMismatch,
+    };
+
+    enum class DiagnosticsFormat {
+        Text,
+        JSON,       // One object per line.
+    };
+
+    struct DiagnosticsSettings {
+        // -ferror-limit=N: errors after the first N are counted but neither kept nor formatted. 0 keeps all.
+        unsigned errorLimit = 0;
+        // Drops repeats of a diagnostic, and undefined names after their first use in a file.
+        bool deduplicate = true;
+        DiagnosticsFormat format = DiagnosticsFormat::Text;    // -fdiagnostics-format=text|json
+    };
+
+    // Collects the diagnostics of a phase as an id, a location and arguments, and formats them only when they are
+    // written or asked for. Output is rendered into one buffer and written at once.
+    class DiagnosticsEngine {
+        private:
+            struct Entry {
+                DiagID id;
+                bool isWarning;
+                uint8_t argCount;
+                uint32_t context;
+                uint32_t firstArg;
+                int line;
+            };
+
+            // Entries are deduplicated by index, so that the set does not copy their arguments.
+            struct EntryHash {
+                const DiagnosticsEngine* engine;
+                size_t operator()(uint32_t index) const;
+            };
+            struct EntryEqual {
+                const DiagnosticsEngine* engine;
+                bool operator()(uint32_t a, uint32_t b) const;
+            };
+
+            DiagnosticsSettings settings;
+            const SourceManager* sources = nullptr;
+            std::vector<Entry> entries;
+            std::vector<std::string> args;
+            std::vector<std::string> contexts;
+            std::vector<FileID> contextFiles;
+            std::unordered_map<std::string, uint32_t> contextIds;
+            std::unordered_set<uint32_t, EntryHash, EntryEqual> seen;
+
+            size_t errorCount = 0;
+            size_t droppedErrors = 0;
+            size_t flushed = 0;
+            bool limitNoted = false;
+
+        public:
+            explicit DiagnosticsEngine(const DiagnosticsSettings& settings = {});
+            DiagnosticsEngine(const DiagnosticsEngine&) = delete;
+            DiagnosticsEngine& operator=(const DiagnosticsEngine&) = delete;
+
+            void SetSettings(const DiagnosticsSettings& newSettings) { settings = newSettings; }
+            [[nodiscard]] const DiagnosticsSettings& GetSettings() const { return settings; }
+
+            // Text output shows the source line of diagnostics whose context has a file in 'manager'.
+            void SetSourceManager(const SourceManager* manager) { sources = manager; }
+
+            // The id of a context, e.g. a file, for Report. A context's file is the first one it was given.
+            uint32_t InternContext(std::string_view context, FileID file = InvalidFileID);
+
+            template <class... Args>
+            void Report(DiagID id, uint32_t context, int line, const Args&... arguments) {
+                if (!Accepts(IsWarning(id))) return;
+                const auto firstArg = static_cast<uint32_t>(args.size());
+                (AddArgument(arguments), ...);
+                Commit(id, IsWarning(id), context, line, firstArg);
+            }
+
+            void Add(const ErrorInfo& error, bool isWarning = false, FileID file = InvalidFileID);
+            void Add(const std::vector<ErrorInfo>& errors, bool areWarnings = false, FileID file = InvalidFileID);
+
+            [[nodiscard]] bool HadErrors() const { return errorCount + droppedErrors > 0; }
+            [[nodiscard]] size_t GetErrorCount() const { return errorCount + droppedErrors; }
+            [[nodiscard]] size_t GetDroppedCount() const { return droppedErrors; }
+            // Whether errors are being dropped, so that producers can stop looking for more.
+            [[nodiscard]] bool LimitReached() const { return settings.errorLimit && errorCount >= settings.errorLimit; }
+
+            // Kept diagnostics, errors and warnings in the order they were reported.
+            [[nodiscard]] size_t Size() const { return entries.size(); }
+            // Formats the kept errors or warnings from the entry at 'first' on.
+            [[nodiscard]] std::vector<ErrorInfo> GetErrors(size_t first = 0) const;
+            [[nodiscard]] std::vector<ErrorInfo> GetWarnings(size_t first = 0) const;
+
+            // Orders the diagnostics not written yet by context, in the order contexts first appeared, and line.
+            // Diagnostics at the same place keep the order they were reported in.
+            void SortByLocation();
+
+            // Renders the diagnostics not written yet, under a header in text format, and writes them at once.
+            void Flush(std::string_view header, std::FILE* out = stdout);
+            [[nodiscard]] std::string Render(std::string_view header, size_t first = 0) const;
+
+            void Clear();
+
+        private:
+            static bool IsWarning(DiagID id);
+            bool Accepts(bool isWarning);
+            void Commit(DiagID id, bool isWarning, uint32_t context, int line, uint32_t firstArg);
+
+            void AddArgument(std::string_view arg) { args.emplace_back(arg); }
+            void AddArgument(std::integral auto arg) { args.push_back(std::to_string(arg)); }
+
+            // Adds an entry of another engine, subject to this one's limit and deduplication.
+            void Append(const DiagnosticsEngine& other, const Entry& entry);
+
+            [[nodiscard]] std::string FormatMessage(const Entry& entry) const;
+            [[nodiscard]] std::string_view GetSourceLine(const Entry& entry) const;
+            [[nodiscard]] std::string RenderRange(std::string_view header, size_t first, bool noteLimit) const;
+            [[nodiscard]] std::vector<ErrorInfo> Collect(size_t first, bool warnings) const;
+
+            friend class DiagnosticsCollector;
+    };
+
+    // Diagnostics of work that runs on several threads. Each task reports into its own shard, picked by an index
+    // that depends only on the work (a file, a partition), so workers share nothing and need no locks. Merging
+    // takes the shards in index order and sorts by location, so the result does not depend on the thread count or
+    // on which task finished first, and matches a serial run.
+    class DiagnosticsCollector {
+        private:
+            // Shards are written by different threads, so each gets its own cache line.
+            struct alignas(64) Shard {
+                DiagnosticsEngine diagnostics;
+            };
+
+            std::vector<Shard> shards;
+
+        public:
+            explicit DiagnosticsCollector(size_t shardCount, const DiagnosticsSettings& settings = {});
+
+            [[nodiscard]] size_t Size() const { return shards.size(); }
+            // Only the task that owns the shard may use it until the work is done.
+            [[nodiscard]] DiagnosticsEngine& GetShard(size_t index) { return shards[index].diagnostics; }
+
+            // Adds every shard's diagnostics to 'out' and sorts them. Call once all tasks are done.
+            void MergeInto(DiagnosticsEngine& out) const;
+    };
+}
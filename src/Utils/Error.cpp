@@ -1,7 +1,7 @@
 #include "Common/ErrorInfo.hpp"
+#include "Diagnostics.hpp"
 #include "Utils.hpp"
-
-#include "fmt/color.h"
+#include <cstdlib>
 
 /*void pl::ReportError(const std::string_view msg, int code) {
     fmt::print(fmt::fg(fmt::color::red), "{}\n", msg);
@@ -14,10 +14,15 @@ void pl::ReportErrors(const std::vector<ErrorInfo>& errors, bool terminate) {
 
 void pl::ReportErrors(std::string_view header, const std::vector<ErrorInfo>& errors, bool terminate) {
     if (errors.empty()) return;
-    if (!header.empty()) fmt::print(fmt::emphasis::bold, "{}\n", header);
-    for (const auto& error : errors) {
-        fmt::print(fmt::fg(fmt::color::red), "Error [at {}, line {}]:\n\t{}\n", error.context, error.line, error.msg);
-    }
+    DiagnosticsEngine diagnostics({.deduplicate = false});
+    diagnostics.Add(errors);
+    diagnostics.Flush(header);
 
     if (terminate) std::exit(1);
-}
\ No newline at end of file
+}
+
+void pl::ReportWarnings(std::string_view header, const std::vector<ErrorInfo>& warnings) {
+    DiagnosticsEngine diagnostics({.deduplicate = false});
+    diagnostics.Add(warnings, true);
+    diagnostics.Flush(header);
+}
@@ -0,0 +1,65 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pl;
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path, std::error_code& ec) {
+    ec.clear();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec = std::error_code(errno, std::generic_category());
+        return nullptr;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto file = std::make_unique<MappedFile>();
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        const auto size = static_cast<size_t>(st.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            ::close(fd);
+            file->mapping = data;
+            file->mappingSize = size;
+            file->text = std::string_view(static_cast<const char*>(data), size);
+            return file;
+        }
+    }
+
+    // Files that cannot be mapped, or whose size is not known up front, are read until their end.
+    char chunk[16384];
+    while (true) {
+        const auto read = ::read(fd, chunk, sizeof(chunk));
+        if (read == 0) break;
+        if (read < 0) {
+            if (errno == EINTR) continue;
+            ec = std::error_code(errno, std::generic_category());
+            ::close(fd);
+            return nullptr;
+        }
+        file->copy.append(chunk, static_cast<size_t>(read));
+    }
+    ::close(fd);
+    file->text = file->copy;
+    return file;
+}
+
+std::unique_ptr<MappedFile> MappedFile::FromCopy(std::string_view text) {
+    auto file = std::make_unique<MappedFile>();
+    file->copy = text;
+    file->text = file->copy;
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (mapping) ::munmap(mapping, mappingSize);
+}
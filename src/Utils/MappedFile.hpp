@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace pl {
+    // The read-only contents of a file, memory-mapped where the system allows it and read into memory otherwise,
+    // e.g. for pipes. The text stays valid and unchanged for the lifetime of the object.
+    class MappedFile {
+        private:
+            void* mapping = nullptr;
+            size_t mappingSize = 0;
+            std::string copy;   // When not mapped.
+            std::string_view text;
+
+        public:
+            // Returns null and sets 'ec' if the file cannot be read.
+            static std::unique_ptr<MappedFile> Open(const std::filesystem::path& path, std::error_code& ec);
+            static std::unique_ptr<MappedFile> FromCopy(std::string_view text);
+
+            MappedFile() = default;
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            [[nodiscard]] std::string_view GetText() const { return text; }
+    };
+}
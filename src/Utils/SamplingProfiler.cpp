@@ -0,0 +1,71 @@
+#include "SamplingProfiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#include <csignal>
+#include <sys/time.h>
+#include <ucontext.h>
+#define FRACTA_HAS_SAMPLING 1
+#else
+#define FRACTA_HAS_SAMPLING 0
+#endif
+
+using namespace pl;
+
+// The signal handler can only reach global state, and must not allocate. The buffer is allocated once and never
+// freed, as a signal already pending on another thread may still be handled after Stop.
+static std::unique_ptr<uint64_t[]> samples;
+static std::atomic<size_t> sampleCount {0};
+
+#if FRACTA_HAS_SAMPLING
+static void OnProfilingSignal(int, siginfo_t*, void* context) {
+    auto uc = static_cast<ucontext_t*>(context);
+#if defined(__x86_64__)
+    const auto pc = static_cast<uint64_t>(uc->uc_mcontext.gregs[REG_RIP]);
+#else
+    const auto pc = static_cast<uint64_t>(uc->uc_mcontext.pc);
+#endif
+
+    auto index = sampleCount.fetch_add(1, std::memory_order_relaxed);
+    if (index < SamplingProfiler::MaxSamples) samples[index] = pc;
+}
+#endif
+
+bool SamplingProfiler::Start(unsigned intervalMicros) {
+#if FRACTA_HAS_SAMPLING
+    // Zeroed, so a slot a handler has claimed but not yet written when Stop copies it reads as no address (or as
+    // one of an earlier run).
+    if (!samples) samples = std::make_unique<uint64_t[]>(MaxSamples);
+    sampleCount = 0;
+
+    struct sigaction action {};
+    action.sa_sigaction = OnProfilingSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) return false;
+
+    itimerval timer {};
+    timer.it_interval.tv_sec = intervalMicros / 1000000;
+    timer.it_interval.tv_usec = intervalMicros % 1000000;
+    timer.it_value = timer.it_interval;
+    return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+#else
+    (void)intervalMicros;
+    return false;
+#endif
+}
+
+std::vector<uint64_t> SamplingProfiler::Stop() {
+#if FRACTA_HAS_SAMPLING
+    itimerval timer {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    // Ignored rather than reset, as the default action of a signal still pending on another thread is to terminate.
+    signal(SIGPROF, SIG_IGN);
+#endif
+
+    if (!samples) return {};
+    const auto count = std::min(sampleCount.load(), MaxSamples);
+    return std::vector<uint64_t>(samples.get(), samples.get() + count);
+}
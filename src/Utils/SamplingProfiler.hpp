@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace pl {
+    // Samples the program counter of the running thread on SIGPROF, which fires per slice of consumed CPU time.
+    // Only one profiler may run at a time. Unsupported platforms record no samples.
+    class SamplingProfiler {
+        public:
+            static constexpr size_t MaxSamples = 1 << 20;
+
+            // Returns false if sampling could not be started.
+            static bool Start(unsigned intervalMicros = 1000);
+            static std::vector<uint64_t> Stop();
+    };
+}
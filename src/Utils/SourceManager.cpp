@@ -0,0 +1,99 @@
+#include "SourceManager.hpp"
+
+using namespace pl;
+
+static std::string_view TextOf(const MappedFile* buffer) {
+    return buffer ? buffer->GetText() : std::string_view();
+}
+
+FileID SourceManager::Load(const std::filesystem::path& path, std::error_code& ec) {
+    // Only used as a key, so a path that cannot be resolved is taken as written.
+    std::error_code canonicalError;
+    auto key = std::filesystem::weakly_canonical(path, canonicalError);
+    if (canonicalError) key = path.lexically_normal();
+
+    File* file = nullptr;
+    FileID id = 0;
+    {
+        std::lock_guard lock(mutex);
+        auto [it, inserted] = ids.try_emplace(key.string(), static_cast<FileID>(files.size()));
+        if (inserted) {
+            auto& added = files.emplace_back(std::make_unique<File>());
+            added->path = path;
+            added->name = path.filename().string();
+        }
+        id = it->second;
+        file = files[id].get();
+    }
+
+    // Read outside the lock, so that workers load different files at the same time. A second request for the
+    // same file waits for the first.
+    std::call_once(file->loaded, [file] {
+        file->buffer = MappedFile::Open(file->path, file->error);
+    });
+    ec = file->error;
+    return id;
+}
+
+FileID SourceManager::AddBuffer(std::string_view name, std::string_view text) {
+    auto file = std::make_unique<File>();
+    file->path = name;
+    file->name = std::string(name);
+    file->buffer = MappedFile::FromCopy(text);
+
+    std::lock_guard lock(mutex);
+    files.push_back(std::move(file));
+    return static_cast<FileID>(files.size() - 1);
+}
+
+size_t SourceManager::GetFileCount() const {
+    std::lock_guard lock(mutex);
+    return files.size();
+}
+
+SourceManager::File& SourceManager::GetFile(FileID id) const {
+    std::lock_guard lock(mutex);
+    return *files.at(id);
+}
+
+std::string_view SourceManager::GetText(FileID id) const {
+    return TextOf(GetFile(id).buffer.get());
+}
+
+const std::filesystem::path& SourceManager::GetPath(FileID id) const {
+    return GetFile(id).path;
+}
+
+std::string_view SourceManager::GetName(FileID id) const {
+    return GetFile(id).name;
+}
+
+void SourceManager::BuildLines(File& file) const {
+    std::call_once(file.linesBuilt, [&file] {
+        const auto text = TextOf(file.buffer.get());
+        file.lineStarts.push_back(0);
+        for (auto next = text.find('\n'); next != std::string_view::npos && next + 1 < text.size(); next = text.find('\n', next + 1)) {
+            file.lineStarts.push_back(static_cast<uint32_t>(next + 1));
+        }
+    });
+}
+
+size_t SourceManager::GetLineCount(FileID id) const {
+    auto& file = GetFile(id);
+    BuildLines(file);
+    return file.lineStarts.size();
+}
+
+std::string_view SourceManager::GetLine(FileID id, int line) const {
+    auto& file = GetFile(id);
+    BuildLines(file);
+    if (line < 0 || static_cast<size_t>(line) >= file.lineStarts.size()) return {};
+
+    const auto text = TextOf(file.buffer.get());
+    const size_t start = file.lineStarts[line];
+    const size_t end = static_cast<size_t>(line) + 1 < file.lineStarts.size() ? file.lineStarts[line + 1] : text.size();
+    auto result = text.substr(start, end - start);
+    if (result.ends_with('\n')) result.remove_suffix(1);
+    if (result.ends_with('\r')) result.remove_suffix(1);
+    return result;
+}
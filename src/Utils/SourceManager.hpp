@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Utils/MappedFile.hpp"
+#include <Common/FileID.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace pl {
+    // Owns the text of the sources of a build, one copy per file, and maps lines back to text. Files are
+    // memory-mapped where the system allows it, and paths naming the same file share an id. Loading and lookups
+    // are thread-safe, so front end workers can load their files concurrently. Texts stay valid and unchanged for
+    // the lifetime of the manager.
+    // Lines are 0-based.
+    class SourceManager {
+        private:
+            struct File {
+                std::filesystem::path path;
+                std::string name;       // Without directories, as diagnostics show it.
+                std::unique_ptr<MappedFile> buffer;
+                std::error_code error;
+                std::once_flag loaded;
+
+                // Offsets of line starts, built on first use.
+                std::once_flag linesBuilt;
+                std::vector<uint32_t> lineStarts;
+            };
+
+            mutable std::mutex mutex;
+            std::vector<std::unique_ptr<File>> files;
+            std::unordered_map<std::string, FileID> ids;
+
+        public:
+            // Loads a file, or returns the id it was loaded under before. On failure 'ec' is set, and the id is
+            // still valid with an empty text.
+            FileID Load(const std::filesystem::path& path, std::error_code& ec);
+            // Copies text that does not come from a file, e.g. an editor's buffer. Every call gets a new id.
+            FileID AddBuffer(std::string_view name, std::string_view text);
+
+            [[nodiscard]] size_t GetFileCount() const;
+            [[nodiscard]] std::string_view GetText(FileID id) const;
+            [[nodiscard]] const std::filesystem::path& GetPath(FileID id) const;
+            [[nodiscard]] std::string_view GetName(FileID id) const;
+
+            [[nodiscard]] size_t GetLineCount(FileID id) const;
+            // The text of a line without its line break, or an empty view past the end.
+            [[nodiscard]] std::string_view GetLine(FileID id, int line) const;
+
+        private:
+            [[nodiscard]] File& GetFile(FileID id) const;
+            void BuildLines(File& file) const;
+    };
+}
@@ -0,0 +1,130 @@
+#include "TimeTrace.hpp"
+#include "Utils/Utils.hpp"
+#include "fmt/core.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace pl;
+
+static constexpr const char* ProcessName = "fractac";
+
+// Workers of the session start their own profilers with the same granularity.
+static unsigned sessionGranularity = 0;
+// The live session, finished by an exit hook if the compiler leaves through std::exit, e.g. on errors.
+static TimeTraceSession* finishAtExit = nullptr;
+
+static void PrintTimeReport(llvm::StringRef trace, std::chrono::steady_clock::duration wall) {
+    struct Phase {
+        std::string name;
+        int64_t count;
+        int64_t micros;
+    };
+    std::vector<Phase> phases;
+
+    // The profiler appends a "Total <name>" event per name, covering its outermost occurrences.
+    auto json = llvm::json::parse(trace);
+    if (!json) {
+        llvm::consumeError(json.takeError());
+        return;
+    }
+    if (auto events = json->getAsObject() ? json->getAsObject()->getArray("traceEvents") : nullptr) {
+        for (const auto& event : *events) {
+            auto object = event.getAsObject();
+            if (!object) continue;
+
+            auto name = object->getString("name");
+            llvm::StringRef phase = name ? *name : llvm::StringRef();
+            if (!phase.consume_front("Total ")) continue;
+
+            int64_t count = 0;
+            if (auto args = object->getObject("args")) {
+                if (auto value = args->getInteger("count")) count = *value;
+            }
+            auto micros = object->getInteger("dur");
+            phases.push_back({phase.str(), count, micros ? *micros : 0});
+        }
+    }
+    std::ranges::sort(phases, std::greater {}, &Phase::micros);
+
+    const auto wallMicros = std::chrono::duration_cast<std::chrono::microseconds>(wall).count();
+    fmt::print(stderr, "Time report ({:.3f} ms wall clock, nested phases overlap):\n", static_cast<double>(wallMicros) / 1000.0);
+    fmt::print(stderr, "{:>9}{:>12}{:>8}  {}\n", "Wall %", "Total ms", "Count", "Phase");
+    for (const auto& phase : phases) {
+        const double percent = wallMicros ? 100.0 * static_cast<double>(phase.micros) / static_cast<double>(wallMicros) : 0.0;
+        fmt::print(stderr, "{:>8.2f}%{:>12.3f}{:>8}  {}\n", percent, static_cast<double>(phase.micros) / 1000.0, phase.count, phase.name);
+    }
+}
+
+// Both do nothing on a thread without a profiler, like llvm::TimeTraceScope.
+static const TimeTraceHooks LLVMHooks {
+    [](std::string_view name, std::string_view detail) {
+        llvm::timeTraceProfilerBegin(llvm::StringRef(name.data(), name.size()), llvm::StringRef(detail.data(), detail.size()));
+    },
+    [] { llvm::timeTraceProfilerEnd(); },
+};
+
+TimeTraceSession::TimeTraceSession(std::optional<std::filesystem::path> tracePath, bool report, unsigned granularityMicros)
+    : tracePath(std::move(tracePath)), report(report), start(std::chrono::steady_clock::now()) {
+    if (!this->tracePath && !report) return;
+
+    // Statics are destroyed and exit hooks run in reverse order of creation, so the profiler's state is created
+    // before the hook is registered. Without a profiler this does nothing else.
+    llvm::timeTraceProfilerCleanup();
+    static const bool registered = (std::atexit([] { if (finishAtExit) finishAtExit->Finish(); }), true);
+    (void)registered;
+    finishAtExit = this;
+
+    // Totals are kept for every region, so a report alone does not need to store individual events.
+    sessionGranularity = this->tracePath ? granularityMicros : std::numeric_limits<unsigned>::max();
+    llvm::timeTraceProfilerInitialize(sessionGranularity, ProcessName);
+    timeTraceHooks = &LLVMHooks;
+}
+
+TimeTraceSession::~TimeTraceSession() {
+    if (finishAtExit == this) Finish();
+}
+
+void TimeTraceSession::Finish() {
+    finishAtExit = nullptr;
+    timeTraceHooks = nullptr;
+    const auto wall = std::chrono::steady_clock::now() - start;
+
+    llvm::SmallString<0> trace;
+    llvm::raw_svector_ostream traceStream(trace);
+    llvm::timeTraceProfilerWrite(traceStream);
+    llvm::timeTraceProfilerCleanup();
+
+    if (tracePath) {
+        std::error_code ec;
+        llvm::raw_fd_ostream out(tracePath->string(), ec, llvm::sys::fs::OF_Text);
+        if (!ec) {
+            out << trace;
+            out.close();
+            if (out.has_error()) ec = out.error();
+        }
+        if (ec) {
+            ReportErrors("Time trace errors.", {{tracePath->string(), ec.message(), 0}});
+        }
+    }
+
+    if (report) PrintTimeReport(trace, wall);
+}
+
+TimeTraceWorkerScope::TimeTraceWorkerScope(bool tracing) {
+    if (!tracing || llvm::timeTraceProfilerEnabled()) return;
+    llvm::timeTraceProfilerInitialize(sessionGranularity, ProcessName);
+    owned = true;
+}
+
+TimeTraceWorkerScope::~TimeTraceWorkerScope() {
+    // Hands the thread's events over to the session, which writes them with its own.
+    if (owned) llvm::timeTraceProfilerFinishThread();
+}
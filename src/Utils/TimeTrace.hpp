@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace pl {
+    // What pl::TimeTraceScope calls while a TimeTraceSession is active. The session forwards to LLVM's time
+    // profiler, so the front end and the VM, which are built without LLVM, only reach it through these.
+    struct TimeTraceHooks {
+        void (*begin)(std::string_view name, std::string_view detail);
+        void (*end)();
+    };
+
+    inline std::atomic<const TimeTraceHooks*> timeTraceHooks {nullptr};
+
+    // A traced region in code that does not link LLVM, where llvm::TimeTraceScope cannot be used. Without a
+    // session it costs one atomic load.
+    class TimeTraceScope {
+        private:
+            const TimeTraceHooks* hooks;
+
+        public:
+            explicit TimeTraceScope(std::string_view name, std::string_view detail = {})
+                : hooks(timeTraceHooks.load(std::memory_order_relaxed)) {
+                if (hooks) hooks->begin(name, detail);
+            }
+            ~TimeTraceScope() {
+                if (hooks) hooks->end();
+            }
+
+            TimeTraceScope(const TimeTraceScope&) = delete;
+            TimeTraceScope& operator=(const TimeTraceScope&) = delete;
+    };
+
+    // Records the compiler's pl::TimeTraceScope and llvm::TimeTraceScope regions, which include every LLVM pass, while
+    // it is alive.
+    // On destruction, or at exit if the compiler leaves through std::exit, writes them as Chrome trace JSON
+    // (-ftime-trace) and/or prints per-phase totals (--time-report). Without a session, a scope costs one
+    // thread-local load.
+    class TimeTraceSession {
+        private:
+            std::optional<std::filesystem::path> tracePath;
+            bool report = false;
+            std::chrono::steady_clock::time_point start;
+
+        public:
+            TimeTraceSession(std::optional<std::filesystem::path> tracePath, bool report, unsigned granularityMicros);
+            ~TimeTraceSession();
+
+            TimeTraceSession(const TimeTraceSession&) = delete;
+            TimeTraceSession& operator=(const TimeTraceSession&) = delete;
+
+        private:
+            void Finish();
+    };
+
+    // Makes a thread pool task record into the session of the thread that queued it, where 'tracing' is
+    // llvm::timeTraceProfilerEnabled() captured on that thread.
+    class TimeTraceWorkerScope {
+        private:
+            bool owned = false;
+
+        public:
+            explicit TimeTraceWorkerScope(bool tracing);
+            ~TimeTraceWorkerScope();
+
+            TimeTraceWorkerScope(const TimeTraceWorkerScope&) = delete;
+            TimeTraceWorkerScope& operator=(const TimeTraceWorkerScope&) = delete;
+    };
+}
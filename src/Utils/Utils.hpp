@@ -11,6 +11,7 @@ namespace pl {
 
     void ReportErrors(const std::vector<ErrorInfo>& errors, bool terminate = false);
     void ReportErrors(std::string_view header, const std::vector<ErrorInfo>& errors, bool terminate = false);
+    void ReportWarnings(std::string_view header, const std::vector<ErrorInfo>& warnings);
 
     template <class T, class... Args>
     std::shared_ptr<T> MakeSP(Args&&... args) {
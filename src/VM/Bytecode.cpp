@@ -0,0 +1,189 @@
+#include "Bytecode.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pl;
+
+BytecodeModule::~BytecodeModule() {
+    Unmap();
+}
+
+bool BytecodeModule::Adopt(std::vector<uint8_t> image) {
+    Unmap();
+    ownedImage = std::move(image);
+    return Parse(ownedImage);
+}
+
+bool BytecodeModule::Load(const std::filesystem::path& path) {
+    Unmap();
+    ownedImage.clear();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        AddError(fmt::format("Cannot open '{}': {}", path.string(), std::strerror(errno)));
+        return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        AddError(fmt::format("Cannot read '{}'.", path.string()));
+        return false;
+    }
+
+    // The image is used in place: nothing is copied or relocated, so loading costs one mmap and a verify pass.
+    auto size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        AddError(fmt::format("Cannot map '{}': {}", path.string(), std::strerror(errno)));
+        return false;
+    }
+
+    mapping = data;
+    mappingSize = size;
+    return Parse({static_cast<const uint8_t*>(data), size});
+}
+
+std::optional<uint16_t> BytecodeModule::FindFunction(std::string_view name) const {
+    for (size_t i = 0; i < functions.size(); i++) {
+        if (functions[i].name == name) return static_cast<uint16_t>(i);
+    }
+    return std::nullopt;
+}
+
+bool BytecodeModule::Parse(std::span<const uint8_t> image) {
+    functions.clear();
+
+    bytecode::FileHeader header {};
+    if (image.size() < sizeof(header)) {
+        AddError("File is too small to be a bytecode module.");
+        return false;
+    }
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, bytecode::Magic, sizeof(header.magic)) != 0) {
+        AddError("Not a bytecode module.");
+        return false;
+    }
+    if (header.version != bytecode::Version) {
+        AddError(fmt::format("Unsupported bytecode version {}.", header.version));
+        return false;
+    }
+
+    const uint64_t recordsEnd = sizeof(header) + uint64_t {header.functionCount} * sizeof(bytecode::FunctionRecord);
+    if (recordsEnd > image.size() || header.functionCount > UINT16_MAX + 1u) {
+        AddError("Function table is out of bounds.");
+        return false;
+    }
+
+    // Each section must lie inside the image and be aligned for its element type.
+    auto section = [&](uint32_t offset, uint32_t count, size_t elementSize) {
+        return offset % elementSize == 0 && offset + uint64_t {count} * elementSize <= image.size();
+    };
+
+    for (uint32_t i = 0; i < header.functionCount; i++) {
+        bytecode::FunctionRecord record {};
+        std::memcpy(&record, image.data() + sizeof(header) + i * sizeof(record), sizeof(record));
+
+        if (!section(record.nameOffset, record.nameLength, 1)
+            || !section(record.codeOffset, record.codeLength, sizeof(uint32_t))
+            || !section(record.constantOffset, record.constantCount, sizeof(uint64_t))) {
+            AddError(fmt::format("Function {} has a section out of bounds.", i));
+            return false;
+        }
+
+        BytecodeFunction function;
+        function.name = {reinterpret_cast<const char*>(image.data() + record.nameOffset), record.nameLength};
+        function.code = {reinterpret_cast<const uint32_t*>(image.data() + record.codeOffset), record.codeLength};
+        function.constants = {reinterpret_cast<const uint64_t*>(image.data() + record.constantOffset), record.constantCount};
+        function.numArgs = record.numArgs;
+        function.numRegs = record.numRegs;
+        function.returnKind = record.returnKind;
+        functions.push_back(function);
+    }
+
+    for (const auto& function : functions) {
+        if (!VerifyFunction(function)) {
+            functions.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BytecodeModule::VerifyFunction(const BytecodeFunction& function) {
+    // After verification the VM needs no bounds checks beyond the register stack limit.
+    auto fail = [&](size_t pc, std::string_view msg) {
+        AddError(fmt::format("Invalid bytecode in '{}' at {}: {}", function.name, pc, msg));
+        return false;
+    };
+
+    if (function.returnKind > ValueKind::Float) return fail(0, "unknown return kind");
+    if (function.numArgs > function.numRegs || function.numRegs > 256) return fail(0, "bad register count");
+    if (function.code.empty()) return fail(0, "empty function");
+
+    const auto last = DecodeOp(function.code.back());
+    if (last != Opcode::Ret && last != Opcode::RetVoid && last != Opcode::TailCall) return fail(function.code.size() - 1, "code does not end in a return");
+
+    for (size_t pc = 0; pc < function.code.size(); pc++) {
+        const auto insn = function.code[pc];
+        const auto op = DecodeOp(insn);
+        const auto a = DecodeA(insn), b = DecodeB(insn), c = DecodeC(insn);
+
+        if (op >= Opcode::Count) return fail(pc, "unknown opcode");
+        if (op != Opcode::RetVoid && op != Opcode::CheckDivS && a >= function.numRegs) return fail(pc, "register out of range");
+
+        switch (op) {
+            case Opcode::LoadK:
+                if (DecodeBx(insn) >= function.constants.size()) return fail(pc, "constant out of range");
+                break;
+            case Opcode::Call:
+            case Opcode::TailCall: {
+                if (DecodeBx(insn) >= functions.size()) return fail(pc, "function out of range");
+                const auto& callee = functions[DecodeBx(insn)];
+                if (a + std::max<unsigned>(callee.numArgs, 1) > function.numRegs) return fail(pc, "arguments out of range");
+                break;
+            }
+            case Opcode::Ret:
+            case Opcode::RetVoid:
+                break;
+            case Opcode::CheckDivS:
+                if (a != 8 && a != 16 && a != 32) return fail(pc, "bad integer width");
+                if (b >= function.numRegs || c >= function.numRegs) return fail(pc, "register out of range");
+                break;
+            case Opcode::Mov:
+            case Opcode::NegI:
+            case Opcode::NegF:
+            case Opcode::SExt8: case Opcode::SExt16: case Opcode::SExt32:
+            case Opcode::ZExt8: case Opcode::ZExt16: case Opcode::ZExt32:
+            case Opcode::RoundF32:
+                if (b >= function.numRegs) return fail(pc, "register out of range");
+                break;
+            default:
+                if (b >= function.numRegs || c >= function.numRegs) return fail(pc, "register out of range");
+                break;
+        }
+    }
+    return true;
+}
+
+void BytecodeModule::Unmap() {
+    if (mapping) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+}
+
+void BytecodeModule::AddError(std::string_view msg) {
+    errors.push_back({
+        "Bytecode",
+        std::string(msg),
+        0
+    });
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <Common/ErrorInfo.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    // Instructions are 32 bits: the opcode in the low byte, then register operands A, B and C.
+    // Constant and function indices use the 16 bits of B and C together (Bx).
+    enum class Opcode : uint8_t {
+        LoadK,          // A = K[Bx]
+        Mov,            // A = B
+
+        AddI, SubI, MulI,               // A = B op C, wrapping at 64 bits
+        DivS, DivU, RemS, RemU,         // A = B op C, trapping on division by zero and MIN / -1
+        CheckDivS,      // Traps if B / C overflows a signed integer of A bits
+        NegI,           // A = -B
+        SExt8, SExt16, SExt32,          // A = B truncated to N bits and sign-extended
+        ZExt8, ZExt16, ZExt32,          // A = B truncated to N bits and zero-extended
+
+        AddF, SubF, MulF, DivF, RemF,   // A = B op C on doubles
+        NegF,           // A = -B
+        RoundF32,       // A = B rounded to single precision
+
+        Call,           // Calls F[Bx] with its arguments in A, A+1, ...; the result replaces A.
+        TailCall,       // Replaces the current frame with a call to F[Bx], arguments as for Call.
+        Ret,            // Returns A
+        RetVoid,
+
+        Count
+    };
+
+    // How a function's 64-bit result is interpreted. Integers are sign- or zero-extended by their type.
+    enum class ValueKind : uint8_t {
+        Void,
+        Integer,
+        Float,
+    };
+
+    constexpr uint32_t EncodeABC(Opcode op, uint8_t a, uint8_t b = 0, uint8_t c = 0) {
+        return static_cast<uint32_t>(op) | (uint32_t {a} << 8) | (uint32_t {b} << 16) | (uint32_t {c} << 24);
+    }
+
+    constexpr uint32_t EncodeABx(Opcode op, uint8_t a, uint16_t bx) {
+        return static_cast<uint32_t>(op) | (uint32_t {a} << 8) | (uint32_t {bx} << 16);
+    }
+
+    constexpr Opcode DecodeOp(uint32_t insn) { return static_cast<Opcode>(insn & 0xFF); }
+    constexpr uint8_t DecodeA(uint32_t insn) { return (insn >> 8) & 0xFF; }
+    constexpr uint8_t DecodeB(uint32_t insn) { return (insn >> 16) & 0xFF; }
+    constexpr uint8_t DecodeC(uint32_t insn) { return insn >> 24; }
+    constexpr uint16_t DecodeBx(uint32_t insn) { return insn >> 16; }
+
+    // On-disk layout, in host byte order. All offsets are from the start of the file, and constant pools
+    // are 8-byte aligned so a mapped file is used in place.
+    namespace bytecode {
+        constexpr char Magic[4] = {'F', 'R', 'B', 'C'};
+        constexpr uint32_t Version = 2;
+
+        struct FileHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t functionCount;
+            uint32_t reserved;
+        };
+
+        struct FunctionRecord {
+            uint32_t nameOffset, nameLength;
+            uint32_t codeOffset, codeLength;            // In instructions
+            uint32_t constantOffset, constantCount;
+            uint16_t numArgs, numRegs;
+            ValueKind returnKind;
+            uint8_t padding[3];
+        };
+
+        static_assert(sizeof(FileHeader) == 16 && sizeof(FunctionRecord) == 32);
+    }
+
+    struct BytecodeFunction {
+        std::string_view name;
+        std::span<const uint32_t> code;
+        std::span<const uint64_t> constants;
+        uint16_t numArgs = 0;
+        uint16_t numRegs = 0;               // Arguments occupy the first registers.
+        ValueKind returnKind = ValueKind::Void;
+    };
+
+    // A verified view over a bytecode image, either owned or mapped from a file.
+    class BytecodeModule {
+        private:
+            std::vector<uint8_t> ownedImage;
+            void* mapping = nullptr;
+            size_t mappingSize = 0;
+
+            std::vector<BytecodeFunction> functions;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            BytecodeModule() = default;
+            ~BytecodeModule();
+
+            BytecodeModule(const BytecodeModule&) = delete;
+            BytecodeModule& operator=(const BytecodeModule&) = delete;
+
+            bool Adopt(std::vector<uint8_t> image);
+            bool Load(const std::filesystem::path& path);
+
+            [[nodiscard]] std::optional<uint16_t> FindFunction(std::string_view name) const;
+            [[nodiscard]] const BytecodeFunction& GetFunction(uint16_t index) const { return functions[index]; }
+            [[nodiscard]] size_t GetFunctionCount() const { return functions.size(); }
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            bool Parse(std::span<const uint8_t> image);
+            bool VerifyFunction(const BytecodeFunction& function);
+            void Unmap();
+            void AddError(std::string_view msg);
+    };
+}
@@ -0,0 +1,330 @@
+#include "BytecodeCompiler.hpp"
+#include "Analysis/BuiltinTypes.hpp"
+#include "Analysis/ConstantFolding.hpp"
+#include "Utils/TimeTrace.hpp"
+#include "fmt/core.h"
+#include <Utils/Utils.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using namespace pl;
+
+static bool IsTerminator(const std::vector<uint32_t>& code) {
+    if (code.empty()) return false;
+    auto op = DecodeOp(code.back());
+    return op == Opcode::Ret || op == Opcode::RetVoid || op == Opcode::TailCall;
+}
+
+std::vector<uint8_t> BytecodeCompiler::Compile(const std::vector<FileSourceNodeSP>& files) {
+    TimeTraceScope timeScope("BytecodeCompiler");
+    // Index every function first so calls are resolved to fixed slots regardless of definition order.
+    for (const auto& file : files) {
+        currentFilename = file->filename;
+        for (const auto& stmt : file->statements) {
+            auto func = InstanceOf<FuncDeclStmt>(stmt);
+            if (!func) continue;
+
+            auto [it, inserted] = functionIndex.try_emplace(func->name.identName, static_cast<uint16_t>(functions.size()));
+            if (inserted) functions.emplace_back();
+            if (inserted || func->body) {
+                functions[it->second].decl = func;
+                functions[it->second].filename = file->filename;
+            }
+        }
+    }
+
+    if (functions.size() > UINT16_MAX + 1u) {
+        AddError("Too many functions for one bytecode module.", 0);
+        return {};
+    }
+
+    for (auto& function : functions) {
+        currentFilename = function.filename;
+        CompileFunction(function);
+    }
+
+    if (HadErrors()) return {};
+    return Serialize();
+}
+
+void BytecodeCompiler::AddError(std::string_view msg, int line) {
+    errors.push_back({
+        fmt::format("bytecode:{}", currentFilename),
+        std::string(msg),
+        line
+    });
+}
+
+void BytecodeCompiler::CompileFunction(FunctionState& function) {
+    current = &function;
+    const auto numArgs = static_cast<unsigned>(function.decl->args.size());
+    function.nextReg = function.numRegs = numArgs;
+
+    if (numArgs > 255) {
+        AddError(fmt::format("Function '{}' has too many arguments.", function.decl->name.identName), function.decl->line);
+        return;
+    }
+
+    // Calls to functions without a body are rejected at the call site.
+    if (function.decl->body) CompileStatement(function.decl->body);
+    if (!IsTerminator(function.code)) Emit(EncodeABC(Opcode::RetVoid, 0));
+
+    current = nullptr;
+}
+
+void BytecodeCompiler::CompileStatement(const StmtSP& stmt) {
+    if (!stmt) return;
+
+    // Without branches, anything after a return is unreachable.
+    if (IsTerminator(current->code)) return;
+
+    const auto numArgs = static_cast<unsigned>(current->decl->args.size());
+
+    if (auto p = InstanceOf<ExprStmt>(stmt)) {
+        CompileExpression(p->expr);
+    }
+    else if (auto p = InstanceOf<ReturnStmt>(stmt)) {
+        auto call = InstanceOf<CallExpr>(p->value);
+        if (!p->value) Emit(EncodeABC(Opcode::RetVoid, 0));
+        else if (call && call->isTailCall) CompileCall(call, true);
+        else Emit(EncodeABC(Opcode::Ret, CompileExpression(p->value)));
+    }
+    else if (auto p = InstanceOf<BlockStmt>(stmt)) {
+        for (auto& s : p->body) CompileStatement(s);
+    }
+    else {
+        AddError("Unsupported statement type.", stmt->line);
+    }
+
+    // Temporaries do not outlive the statement that created them.
+    current->nextReg = numArgs;
+}
+
+uint8_t BytecodeCompiler::CompileExpression(const ExprSP& expr) {
+    if (auto p = InstanceOf<LiteralExpr>(expr)) return CompileLiteral(p);
+    if (auto p = InstanceOf<IdentifierExpr>(expr)) return CompileIdentifier(p);
+    if (auto p = InstanceOf<ParenExpr>(expr)) return CompileExpression(p->subExpr);
+    if (auto p = InstanceOf<UnaryExpr>(expr)) return CompileUnary(p);
+    if (auto p = InstanceOf<BinaryExpr>(expr)) return CompileBinary(p);
+    if (auto p = InstanceOf<CallExpr>(expr)) return CompileCall(p);
+
+    AddError("Unsupported expression type.", expr->line);
+    return 0;
+}
+
+uint8_t BytecodeCompiler::CompileLiteral(const LiteralSP& lit) {
+    auto value = EvaluateLiteral(*lit);
+    if (!value) {
+        AddError("Unsupported literal type.", lit->line);
+        return 0;
+    }
+
+    auto raw = std::holds_alternative<double>(*value)
+        ? std::bit_cast<uint64_t>(std::get<double>(*value))
+        : static_cast<uint64_t>(std::get<int64_t>(*value));
+
+    auto reg = AllocateRegister(lit->line);
+    Emit(EncodeABx(Opcode::LoadK, reg, AddConstant(raw, lit->line)));
+    return reg;
+}
+
+uint8_t BytecodeCompiler::CompileIdentifier(const IdentifierSP& ident) {
+    // Arguments live in the first registers for the whole call, so they are read in place.
+    const auto& args = current->decl->args;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i].name.identName == ident->value.identName) return static_cast<uint8_t>(i);
+    }
+
+    AddError(fmt::format("Unknown value '{}'.", ident->value.identName), ident->line);
+    return 0;
+}
+
+uint8_t BytecodeCompiler::CompileUnary(const UnarySP& unary) {
+    if (unary->op.type == TokenType::Plus) return CompileExpression(unary->subExpr);
+    if (unary->op.type != TokenType::Minus) {
+        AddError("Unsupported unary operator.", unary->line);
+        return 0;
+    }
+
+    const auto mark = current->nextReg;
+    auto operand = CompileExpression(unary->subExpr);
+    current->nextReg = mark;
+
+    auto dst = AllocateRegister(unary->line);
+    Emit(EncodeABC(IsFloatType(unary->exprType) ? Opcode::NegF : Opcode::NegI, dst, operand));
+    EmitNormalize(dst, unary->exprType);
+    return dst;
+}
+
+uint8_t BytecodeCompiler::CompileBinary(const BinarySP& binary) {
+    const auto mark = current->nextReg;
+    auto lhs = CompileExpression(binary->left);
+    auto rhs = CompileExpression(binary->right);
+
+    // Operands are read before the destination is written, so it may reuse either temporary.
+    current->nextReg = mark;
+    auto dst = AllocateRegister(binary->line);
+
+    std::optional<Opcode> op;
+    if (IsFloatType(binary->exprType)) {
+        switch (binary->op.type) {
+            case TokenType::Plus: op = Opcode::AddF; break;
+            case TokenType::Minus: op = Opcode::SubF; break;
+            case TokenType::Star: op = Opcode::MulF; break;
+            case TokenType::Slash: op = Opcode::DivF; break;
+            case TokenType::Mod: op = Opcode::RemF; break;
+            default: break;
+        }
+    }
+    else {
+        const auto info = GetIntegerTypeInfo(binary->exprType).value_or(IntegerTypeInfo {64, true});
+        const bool narrowSigned = info.isSigned && info.bits < 64;
+
+        switch (binary->op.type) {
+            case TokenType::Plus: op = Opcode::AddI; break;
+            case TokenType::Minus: op = Opcode::SubI; break;
+            case TokenType::Star: op = Opcode::MulI; break;
+            case TokenType::Slash: op = info.isSigned ? Opcode::DivS : Opcode::DivU; break;
+            case TokenType::Mod: op = info.isSigned ? Opcode::RemS : Opcode::RemU; break;
+            default: break;
+        }
+
+        // 64-bit division cannot overflow for narrower operands, so MIN / -1 is checked at the real width.
+        if (narrowSigned && binary->op.Check({TokenType::Slash, TokenType::Mod})) {
+            Emit(EncodeABC(Opcode::CheckDivS, static_cast<uint8_t>(info.bits), lhs, rhs));
+        }
+    }
+
+    if (!op) {
+        AddError("Unsupported binary operator.", binary->line);
+        return dst;
+    }
+
+    Emit(EncodeABC(*op, dst, lhs, rhs));
+    EmitNormalize(dst, binary->exprType);
+    return dst;
+}
+
+uint8_t BytecodeCompiler::CompileCall(const CallSP& call, bool tail) {
+    auto ident = InstanceOf<IdentifierExpr>(call->callee);
+    auto it = ident ? functionIndex.find(ident->value.identName) : functionIndex.end();
+    if (it == functionIndex.end()) {
+        AddError("Call to unknown function.", call->line);
+        return 0;
+    }
+    if (!functions[it->second].decl->body) {
+        AddError(fmt::format("Function '{}' is declared but has no body.", ident->value.identName), call->line);
+        return 0;
+    }
+
+    // The callee's register window starts at 'base'. Each argument is evaluated with its own slot as the first
+    // free register, so most land in place; later slots are still free and may hold its temporaries.
+    const auto base = current->nextReg;
+    const auto window = std::max<unsigned>(call->args.size(), 1);
+    if (base + window > 256) {
+        AddError("Expression needs more than 256 registers.", call->line);
+        return 0;
+    }
+    current->numRegs = std::max(current->numRegs, base + window);
+
+    for (size_t i = 0; i < call->args.size(); i++) {
+        current->nextReg = base + i;
+        auto reg = CompileExpression(call->args[i]);
+        auto target = static_cast<uint8_t>(base + i);
+        if (reg != target) Emit(EncodeABC(Opcode::Mov, target, reg));
+    }
+
+    current->nextReg = base + 1;
+    Emit(EncodeABx(tail ? Opcode::TailCall : Opcode::Call, static_cast<uint8_t>(base), it->second));
+    return static_cast<uint8_t>(base);
+}
+
+uint8_t BytecodeCompiler::AllocateRegister(int line) {
+    if (current->nextReg >= 256) {
+        AddError("Expression needs more than 256 registers.", line);
+        return 0;
+    }
+    current->numRegs = std::max(current->numRegs, current->nextReg + 1);
+    return static_cast<uint8_t>(current->nextReg++);
+}
+
+uint16_t BytecodeCompiler::AddConstant(uint64_t value, int line) {
+    auto [it, inserted] = current->constantIndex.try_emplace(value, static_cast<uint16_t>(current->constants.size()));
+    if (inserted) {
+        if (current->constants.size() > UINT16_MAX) {
+            AddError("Too many constants in one function.", line);
+            return 0;
+        }
+        current->constants.push_back(value);
+    }
+    return it->second;
+}
+
+void BytecodeCompiler::EmitNormalize(uint8_t reg, const TypeSP& type) {
+    if (TypeName(type) == "f32") {
+        Emit(EncodeABC(Opcode::RoundF32, reg, reg));
+        return;
+    }
+
+    auto info = GetIntegerTypeInfo(type);
+    if (!info || info->bits == 64) return;
+
+    Opcode op;
+    switch (info->bits) {
+        case 8: op = info->isSigned ? Opcode::SExt8 : Opcode::ZExt8; break;
+        case 16: op = info->isSigned ? Opcode::SExt16 : Opcode::ZExt16; break;
+        default: op = info->isSigned ? Opcode::SExt32 : Opcode::ZExt32; break;
+    }
+    Emit(EncodeABC(op, reg, reg));
+}
+
+std::vector<uint8_t> BytecodeCompiler::Serialize() const {
+    std::vector<uint8_t> image;
+    auto append = [&](const void* data, size_t size) {
+        auto offset = image.size();
+        image.resize(offset + size);
+        if (size) std::memcpy(image.data() + offset, data, size);
+        return static_cast<uint32_t>(offset);
+    };
+    auto align = [&](size_t alignment) {
+        image.resize((image.size() + alignment - 1) / alignment * alignment);
+    };
+
+    bytecode::FileHeader header {};
+    std::memcpy(header.magic, bytecode::Magic, sizeof(header.magic));
+    header.version = bytecode::Version;
+    header.functionCount = static_cast<uint32_t>(functions.size());
+    append(&header, sizeof(header));
+
+    // Records are filled in once the section offsets are known.
+    const auto recordsOffset = image.size();
+    image.resize(recordsOffset + functions.size() * sizeof(bytecode::FunctionRecord));
+
+    for (size_t i = 0; i < functions.size(); i++) {
+        const auto& function = functions[i];
+        const auto& name = function.decl->name.identName;
+
+        bytecode::FunctionRecord record {};
+        record.nameOffset = append(name.data(), name.size());
+        record.nameLength = static_cast<uint32_t>(name.size());
+
+        align(alignof(uint32_t));
+        record.codeOffset = append(function.code.data(), function.code.size() * sizeof(uint32_t));
+        record.codeLength = static_cast<uint32_t>(function.code.size());
+
+        align(alignof(uint64_t));
+        record.constantOffset = append(function.constants.data(), function.constants.size() * sizeof(uint64_t));
+        record.constantCount = static_cast<uint32_t>(function.constants.size());
+
+        record.numArgs = static_cast<uint16_t>(function.decl->args.size());
+        record.numRegs = static_cast<uint16_t>(function.numRegs);
+        record.returnKind = IsVoidType(function.decl->returnType) ? ValueKind::Void
+            : IsFloatType(function.decl->returnType) ? ValueKind::Float
+            : ValueKind::Integer;
+
+        std::memcpy(image.data() + recordsOffset + i * sizeof(record), &record, sizeof(record));
+    }
+
+    return image;
+}
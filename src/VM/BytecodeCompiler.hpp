@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Parsing/Statement.hpp"
+#include "VM/Bytecode.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <Parsing/ASTNode.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pl {
+    // Lowers analysed files to a bytecode image. Registers are allocated like a stack: every statement starts
+    // again above the arguments, and a call's arguments are placed so they become the callee's first registers.
+    class BytecodeCompiler {
+        private:
+            struct FunctionState {
+                FuncDeclStmtSP decl;
+                std::string filename;
+                std::vector<uint32_t> code;
+                std::vector<uint64_t> constants;
+                std::unordered_map<uint64_t, uint16_t> constantIndex;
+                unsigned nextReg = 0;
+                unsigned numRegs = 0;
+            };
+
+            std::vector<FunctionState> functions;
+            std::unordered_map<std::string, uint16_t> functionIndex;
+            FunctionState* current = nullptr;
+
+            std::string currentFilename;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            // Returns an empty image if compilation failed.
+            std::vector<uint8_t> Compile(const std::vector<FileSourceNodeSP>& files);
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            void AddError(std::string_view msg, int line);
+
+            void CompileFunction(FunctionState& function);
+            void CompileStatement(const StmtSP& stmt);
+
+            uint8_t CompileExpression(const ExprSP& expr);
+            uint8_t CompileLiteral(const LiteralSP& lit);
+            uint8_t CompileIdentifier(const IdentifierSP& ident);
+            uint8_t CompileUnary(const UnarySP& unary);
+            uint8_t CompileBinary(const BinarySP& binary);
+            uint8_t CompileCall(const CallSP& call, bool tail = false);
+
+            uint8_t AllocateRegister(int line);
+            uint16_t AddConstant(uint64_t value, int line);
+            void Emit(uint32_t insn) { current->code.push_back(insn); }
+
+            // Narrows a 64-bit result to the width and precision of its type.
+            void EmitNormalize(uint8_t reg, const TypeSP& type);
+
+            std::vector<uint8_t> Serialize() const;
+    };
+}
@@ -0,0 +1,214 @@
+#include "VirtualMachine.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+using namespace pl;
+
+// Labels as values give every handler its own indirect branch, which predicts far better than the single
+// branch of a switch. Other compilers fall back to the switch.
+#if defined(__GNUC__)
+#define FRACTA_VM_COMPUTED_GOTO 1
+#else
+#define FRACTA_VM_COMPUTED_GOTO 0
+#endif
+
+static double AsDouble(uint64_t raw) { return std::bit_cast<double>(raw); }
+static uint64_t FromDouble(double value) { return std::bit_cast<uint64_t>(value); }
+
+VirtualMachine::VirtualMachine(const BytecodeModule& module, const VMSettings& settings)
+    : module(module),
+      settings(settings),
+      stack(std::make_unique_for_overwrite<uint64_t[]>(settings.stackSlots))
+    { }
+
+std::optional<uint64_t> VirtualMachine::Call(uint16_t function, std::span<const uint64_t> args) {
+    if (function >= module.GetFunctionCount()) {
+        errors.push_back({"VM", fmt::format("No function with index {}.", function), 0});
+        return std::nullopt;
+    }
+
+    const auto& entry = module.GetFunction(function);
+    if (args.size() != entry.numArgs) {
+        errors.push_back({"VM", fmt::format("'{}' expects {} arguments, got {}.", entry.name, entry.numArgs, args.size()), 0});
+        return std::nullopt;
+    }
+    if (entry.numRegs > settings.stackSlots) {
+        errors.push_back({"VM", "Register stack overflow.", 0});
+        return std::nullopt;
+    }
+
+    std::ranges::copy(args, stack.get());
+    frames.clear();
+    return Execute(&entry, stack.get());
+}
+
+void VirtualMachine::Trap(const BytecodeFunction& function, const uint32_t* ip, std::string_view msg) {
+    errors.push_back({
+        fmt::format("VM:{}+{}", function.name, ip - function.code.data()),
+        std::string(msg),
+        0
+    });
+    frames.clear();
+}
+
+std::optional<uint64_t> VirtualMachine::Execute(const BytecodeFunction* function, uint64_t* base) {
+    const uint32_t* ip = function->code.data();
+    const uint64_t* k = function->constants.data();
+    const uint64_t* stackEnd = stack.get() + settings.stackSlots;
+    uint32_t insn = 0;
+
+#define VM_A base[DecodeA(insn)]
+#define VM_B base[DecodeB(insn)]
+#define VM_C base[DecodeC(insn)]
+#define VM_SB static_cast<int64_t>(VM_B)
+#define VM_SC static_cast<int64_t>(VM_C)
+#define VM_TRAP(msg) do { Trap(*function, ip - 1, msg); return std::nullopt; } while (false)
+
+#define VM_RETURN()                                         \
+    if (frames.empty()) return base[0];                     \
+    function = frames.back().function;                      \
+    ip = frames.back().returnIp;                            \
+    base = frames.back().base;                              \
+    k = function->constants.data();                         \
+    frames.pop_back();                                      \
+    VM_DISPATCH()
+
+#if FRACTA_VM_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    // Must list the handlers in Opcode order.
+    static const void* const dispatchTable[] = {
+        &&op_LoadK, &&op_Mov,
+        &&op_AddI, &&op_SubI, &&op_MulI,
+        &&op_DivS, &&op_DivU, &&op_RemS, &&op_RemU,
+        &&op_CheckDivS, &&op_NegI,
+        &&op_SExt8, &&op_SExt16, &&op_SExt32,
+        &&op_ZExt8, &&op_ZExt16, &&op_ZExt32,
+        &&op_AddF, &&op_SubF, &&op_MulF, &&op_DivF, &&op_RemF,
+        &&op_NegF, &&op_RoundF32,
+        &&op_Call, &&op_TailCall, &&op_Ret, &&op_RetVoid,
+    };
+    static_assert(std::size(dispatchTable) == static_cast<size_t>(Opcode::Count));
+
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() insn = *ip++; goto *dispatchTable[insn & 0xFF]
+
+    VM_DISPATCH();
+#else
+#define VM_CASE(name) case Opcode::name:
+#define VM_DISPATCH() break
+
+    for (;;) {
+    insn = *ip++;
+    switch (DecodeOp(insn)) {
+#endif
+
+    VM_CASE(LoadK) VM_A = k[DecodeBx(insn)]; VM_DISPATCH();
+    VM_CASE(Mov) VM_A = VM_B; VM_DISPATCH();
+
+    VM_CASE(AddI) VM_A = VM_B + VM_C; VM_DISPATCH();
+    VM_CASE(SubI) VM_A = VM_B - VM_C; VM_DISPATCH();
+    VM_CASE(MulI) VM_A = VM_B * VM_C; VM_DISPATCH();
+
+    VM_CASE(DivS) {
+        if (VM_C == 0) VM_TRAP("Integer division by zero.");
+        if (VM_SB == std::numeric_limits<int64_t>::min() && VM_SC == -1) VM_TRAP("Integer division overflow.");
+        VM_A = static_cast<uint64_t>(VM_SB / VM_SC);
+        VM_DISPATCH();
+    }
+    VM_CASE(DivU) {
+        if (VM_C == 0) VM_TRAP("Integer division by zero.");
+        VM_A = VM_B / VM_C;
+        VM_DISPATCH();
+    }
+    VM_CASE(RemS) {
+        if (VM_C == 0) VM_TRAP("Integer division by zero.");
+        if (VM_SB == std::numeric_limits<int64_t>::min() && VM_SC == -1) VM_TRAP("Integer division overflow.");
+        VM_A = static_cast<uint64_t>(VM_SB % VM_SC);
+        VM_DISPATCH();
+    }
+    VM_CASE(RemU) {
+        if (VM_C == 0) VM_TRAP("Integer division by zero.");
+        VM_A = VM_B % VM_C;
+        VM_DISPATCH();
+    }
+    VM_CASE(CheckDivS) {
+        if (VM_SC == -1 && VM_SB == -(int64_t {1} << (DecodeA(insn) - 1))) VM_TRAP("Integer division overflow.");
+        VM_DISPATCH();
+    }
+    VM_CASE(NegI) VM_A = uint64_t {0} - VM_B; VM_DISPATCH();
+
+    VM_CASE(SExt8) VM_A = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(VM_B))); VM_DISPATCH();
+    VM_CASE(SExt16) VM_A = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(VM_B))); VM_DISPATCH();
+    VM_CASE(SExt32) VM_A = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(VM_B))); VM_DISPATCH();
+    VM_CASE(ZExt8) VM_A = static_cast<uint8_t>(VM_B); VM_DISPATCH();
+    VM_CASE(ZExt16) VM_A = static_cast<uint16_t>(VM_B); VM_DISPATCH();
+    VM_CASE(ZExt32) VM_A = static_cast<uint32_t>(VM_B); VM_DISPATCH();
+
+    VM_CASE(AddF) VM_A = FromDouble(AsDouble(VM_B) + AsDouble(VM_C)); VM_DISPATCH();
+    VM_CASE(SubF) VM_A = FromDouble(AsDouble(VM_B) - AsDouble(VM_C)); VM_DISPATCH();
+    VM_CASE(MulF) VM_A = FromDouble(AsDouble(VM_B) * AsDouble(VM_C)); VM_DISPATCH();
+    VM_CASE(DivF) VM_A = FromDouble(AsDouble(VM_B) / AsDouble(VM_C)); VM_DISPATCH();
+    VM_CASE(RemF) VM_A = FromDouble(std::fmod(AsDouble(VM_B), AsDouble(VM_C))); VM_DISPATCH();
+    VM_CASE(NegF) VM_A = FromDouble(-AsDouble(VM_B)); VM_DISPATCH();
+    VM_CASE(RoundF32) VM_A = FromDouble(static_cast<float>(AsDouble(VM_B))); VM_DISPATCH();
+
+    VM_CASE(Call) {
+        const auto& callee = module.GetFunction(DecodeBx(insn));
+        uint64_t* calleeBase = base + DecodeA(insn);
+
+        if (frames.size() >= settings.maxCallDepth) VM_TRAP("Call depth exceeded.");
+        if (calleeBase + callee.numRegs > stackEnd) VM_TRAP("Register stack overflow.");
+
+        // Arguments are already in place at the start of the callee's window.
+        frames.push_back({function, ip, base});
+        function = &callee;
+        base = calleeBase;
+        ip = callee.code.data();
+        k = callee.constants.data();
+        VM_DISPATCH();
+    }
+    VM_CASE(TailCall) {
+        const auto& callee = module.GetFunction(DecodeBx(insn));
+        if (base + callee.numRegs > stackEnd) VM_TRAP("Register stack overflow.");
+
+        // The frame is reused: arguments slide down to the bottom of the current window.
+        std::memmove(base, base + DecodeA(insn), callee.numArgs * sizeof(uint64_t));
+        function = &callee;
+        ip = callee.code.data();
+        k = callee.constants.data();
+        VM_DISPATCH();
+    }
+    VM_CASE(Ret) {
+        base[0] = VM_A;
+        VM_RETURN();
+    }
+    VM_CASE(RetVoid) {
+        base[0] = 0;
+        VM_RETURN();
+    }
+
+#if FRACTA_VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#else
+    default:
+        VM_TRAP("Invalid opcode.");
+    }
+    }
+#endif
+
+#undef VM_A
+#undef VM_B
+#undef VM_C
+#undef VM_SB
+#undef VM_SC
+#undef VM_TRAP
+#undef VM_RETURN
+#undef VM_CASE
+#undef VM_DISPATCH
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "VM/Bytecode.hpp"
+#include <Common/ErrorInfo.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace pl {
+    struct VMSettings {
+        size_t stackSlots = size_t {1} << 20;  // 64-bit registers shared by all frames.
+        uint32_t maxCallDepth = 10000;
+    };
+
+    // Register machine over a verified BytecodeModule. Values are raw 64-bit patterns: integers extended by
+    // their type and floats as the bits of a double, the same convention as the JIT's thunks.
+    class VirtualMachine {
+        private:
+            struct CallFrame {
+                const BytecodeFunction* function;
+                const uint32_t* returnIp;
+                uint64_t* base;
+            };
+
+            const BytecodeModule& module;
+            VMSettings settings;
+            std::unique_ptr<uint64_t[]> stack;     // Left uninitialised: registers are always written before use.
+            std::vector<CallFrame> frames;
+            std::vector<ErrorInfo> errors;
+
+        public:
+            explicit VirtualMachine(const BytecodeModule& module, const VMSettings& settings = {});
+
+            // Returns nullopt and records an error if execution traps.
+            std::optional<uint64_t> Call(uint16_t function, std::span<const uint64_t> args);
+
+            [[nodiscard]] bool HadErrors() const { return !errors.empty(); }
+            [[nodiscard]] const std::vector<ErrorInfo>& GetErrors() const { return errors; }
+
+        private:
+            std::optional<uint64_t> Execute(const BytecodeFunction* function, uint64_t* base);
+            void Trap(const BytecodeFunction& function, const uint32_t* ip, std::string_view msg);
+    };
+}